@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef CONSOLE_EMERG_H
+#define CONSOLE_EMERG_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Longer writes are split over several slots. */
+#if !defined(CONSOLE_EMERG_SLOT_SIZE)
+#define CONSOLE_EMERG_SLOT_SIZE		64U
+#endif
+#if !defined(CONSOLE_EMERG_SLOT_COUNT)
+#define CONSOLE_EMERG_SLOT_COUNT	16U
+#endif
+
+/** Output used by console_emerg_drain(). Returns bytes written or a
+ * negative value on error. */
+typedef int (*console_emerg_write_t)(const void *data, size_t len);
+
+/**
+ * @brief Write to the console from any context without taking a lock.
+ *
+ * Safe from ISRs, fault handlers and before the scheduler starts. The data
+ * is copied into a lock-free ring. If the scheduler is not running yet or
+ * console_emerg_panic() has been called, the ring is drained at once with
+ * polled output. Otherwise it is drained by the next console write or
+ * console_sync_flush() from a task, in order with the regular output.
+ *
+ * @param[in] data Data to write.
+ * @param[in] len Length of @p data in bytes.
+ * @return Number of bytes queued. Less than @p len if the ring is full.
+ */
+size_t console_emerg_write(const void *data, size_t len);
+
+/**
+ * @brief Format and write like console_emerg_write().
+ *
+ * The text is formatted on the stack and truncated to
+ * CONSOLE_EMERG_SLOT_SIZE * 2 bytes.
+ *
+ * @return Number of bytes queued.
+ */
+size_t console_emerg_printf(const char *fmt, ...)
+	__attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Pass queued records to @p write, oldest first.
+ *
+ * Only one caller drains at a time; others return at once. A record whose
+ * writer was interrupted before committing stops the drain until the next
+ * call.
+ *
+ * @param[in] write Output to write to.
+ * @return Number of bytes written.
+ */
+size_t console_emerg_drain(console_emerg_write_t write);
+
+/**
+ * @brief Switch to synchronous output for good.
+ *
+ * Meant for fault and assert handlers. Whatever is queued is written out
+ * with polled output, even if a drain was interrupted halfway, and every
+ * later console_emerg_write() goes straight out the same way. No lock is
+ * taken, so it cannot deadlock on a task that was holding the console.
+ */
+void console_emerg_panic(void);
+
+/**
+ * @brief Get the number of bytes lost to a full ring.
+ *
+ * @return Number of bytes dropped since boot.
+ */
+uint32_t console_emerg_dropped(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CONSOLE_EMERG_H */
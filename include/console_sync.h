@@ -12,12 +12,146 @@ extern "C" {
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
+
+/** Flush policy applied when the default policy is not immediate. The
+ * stdout buffer is sized by CONSOLE_SYNC_BUFSIZE in that case. */
+#if !defined(CONSOLE_SYNC_FLUSH_POLICY)
+#define CONSOLE_SYNC_FLUSH_POLICY	CONSOLE_SYNC_FLUSH_IMMEDIATE
+#endif
+#if !defined(CONSOLE_SYNC_BUFSIZE)
+#define CONSOLE_SYNC_BUFSIZE		1024U
+#endif
+/** Pending bytes that trigger a flush under CONSOLE_SYNC_FLUSH_WATERMARK. */
+#if !defined(CONSOLE_SYNC_HIGH_WATERMARK)
+#define CONSOLE_SYNC_HIGH_WATERMARK	(CONSOLE_SYNC_BUFSIZE * 3U / 4U)
+#endif
+/** Flush period under CONSOLE_SYNC_FLUSH_PERIODIC. */
+#if !defined(CONSOLE_SYNC_FLUSH_INTERVAL_MS)
+#define CONSOLE_SYNC_FLUSH_INTERVAL_MS	100U
+#endif
+
+typedef enum {
+	CONSOLE_SYNC_FLUSH_IMMEDIATE, /**< flush and sync after every write */
+	CONSOLE_SYNC_FLUSH_WATERMARK, /**< flush past the high watermark */
+	CONSOLE_SYNC_FLUSH_PERIODIC,  /**< flush from a timer */
+} console_sync_flush_t;
+
+/**
+ * @brief One part of a message passed to console_sync_writev().
+ */
+struct console_sync_iov {
+	const void *base;
+	size_t len;
+};
 
 int console_sync_init(void);
 int console_sync_deinit(void);
 int console_sync_write(const void *data, size_t datasize);
+
+/**
+ * @brief Write the parts of a message back to back under one lock.
+ *
+ * Parts are written in order straight from the caller's buffers, so a
+ * header, payload and trailer need not be joined first, and no other
+ * writer can interleave with them.
+ *
+ * @param[in] iov Array of parts. Empty parts are skipped.
+ * @param[in] iovcnt Number of parts in @p iov.
+ * @return Number of bytes written, which is less than the total on a
+ *         short write, or negative value on error.
+ */
+int console_sync_writev(const struct console_sync_iov *iov, size_t iovcnt);
 int console_sync_read(void *buf, size_t bufsize);
 
+/**
+ * @brief Read input, waiting up to @p timeout_ms for the first byte.
+ *
+ * It returns as soon as any input is available. Readers are serialized
+ * on their own lock, so a waiting reader does not block writers.
+ *
+ * @param[out] buf Buffer to read into.
+ * @param[in] bufsize Size of @p buf in bytes.
+ * @param[in] timeout_ms 0 to return at once, negative to wait forever.
+ * @return Number of bytes read, 0 on timeout, or negative value on error.
+ */
+int console_sync_read_timeout(void *buf, size_t bufsize, int32_t timeout_ms);
+
+/**
+ * @brief Select when buffered console output is pushed out.
+ *
+ * Only the stdio-backed console buffers; RTT and the interrupt-driven UART
+ * hand bytes to the transport on every write and ignore the policy. The
+ * logging backends flush on their own after lines at or above
+ * LOGGER_FLUSH_LEVEL whatever the policy is.
+ *
+ * @param[in] policy Flush policy.
+ * @return 0 on success, negative value on error.
+ */
+int console_sync_set_flush_policy(console_sync_flush_t policy);
+
+/**
+ * @brief Keep other writers off the console until console_sync_unlock().
+ *
+ * For output that reaches the console transport without console_sync,
+ * written in pieces that log lines must not split. The holder must not
+ * write or flush through console_sync meanwhile.
+ */
+void console_sync_lock(void);
+
+/**
+ * @brief Release the console taken with console_sync_lock().
+ */
+void console_sync_unlock(void);
+
+/**
+ * @brief Get the flush policy in effect.
+ *
+ * Consoles that ignore the policy report CONSOLE_SYNC_FLUSH_IMMEDIATE,
+ * since every write reaches the transport at once.
+ *
+ * @return Current flush policy.
+ */
+console_sync_flush_t console_sync_get_flush_policy(void);
+
+/**
+ * @brief Push out everything buffered and sync the output.
+ *
+ * It waits for the console lock like a write does, so it must not be
+ * called from fault or panic paths. Those use console_sync_flush_panic().
+ *
+ * @return 0 on success, negative value on error.
+ */
+int console_sync_flush(void);
+
+/**
+ * @brief Push out what is buffered without waiting, for panic paths.
+ *
+ * Records queued by console_emerg_write() go out by polling, and the
+ * emergency path stays synchronous from then on as with
+ * console_emerg_panic(). The stdio buffer is flushed only if the console
+ * lock is free: a writer stopped halfway leaves it inconsistent, and
+ * waiting for it would never end.
+ *
+ * @return 0 on success, -EBUSY if a writer held the console and buffered
+ *         stdio output was left behind.
+ */
+int console_sync_flush_panic(void);
+
+/**
+ * @brief Write straight to the console transport without any lock.
+ *
+ * Bytes go out by polling, bypassing buffers and the interrupt-driven
+ * driver, so it works from fault handlers and before the scheduler
+ * starts. It may interleave with a regular write in progress. Used by the
+ * emergency path in console_emerg.h.
+ *
+ * @param[in] data Data to write.
+ * @param[in] datasize Size of @p data in bytes.
+ * @return Number of bytes written, or negative value on error.
+ */
+int console_sync_write_polled(const void *data, size_t datasize);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef CRC16_XMODEM_H
+#define CRC16_XMODEM_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Implementations, named by the number of bytes folded per step. Each
+ * costs a 512-byte table per slice in flash. */
+#define CRC16_XMODEM_IMPL_TABLE		1
+#define CRC16_XMODEM_IMPL_SLICE4	4
+#define CRC16_XMODEM_IMPL_SLICE8	8
+
+#if !defined(CRC16_XMODEM_IMPL)
+#define CRC16_XMODEM_IMPL		CRC16_XMODEM_IMPL_SLICE4
+#endif
+
+#define CRC16_XMODEM_INIT		0U
+
+/**
+ * @brief Fold @p data into a running CRC16-XMODEM.
+ *
+ * Polynomial 0x1021, initial value 0, no reflection and no final XOR,
+ * the same as libmcu's crc16_xmodem(). Feeding a buffer in pieces gives
+ * the same result as feeding it at once.
+ *
+ * @param[in] crc CRC so far, CRC16_XMODEM_INIT to start.
+ * @param[in] data Data to fold in.
+ * @param[in] len Length of @p data in bytes.
+ * @return Updated CRC.
+ */
+uint16_t crc16_xmodem_update(uint16_t crc, const void *data, size_t len);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CRC16_XMODEM_H */
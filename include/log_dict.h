@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LOG_DICT_H
+#define LOG_DICT_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include "libmcu/logging.h"
+
+/*
+ * Dictionary (binary) log records carry:
+ *
+ *   [type][len_lo][len_hi][timestamp:4][fmt:4][args:len]
+ *
+ * All words are little-endian. fmt is the address of the format string in
+ * the firmware image, so the text is never formatted nor sent on the
+ * device. Arguments are packed in the order of the conversions in the
+ * format string: integers and pointers as their native width, doubles as
+ * 8 bytes, and strings as a length byte followed by the characters.
+ *
+ * A record goes out as a frame that passes for a text line: LOG_DICT_SYNC,
+ * then the record with every LOG_DICT_SYNC, LOG_DICT_ESC and newline byte
+ * replaced by LOG_DICT_ESC and the byte XORed with 0x20. The sync byte
+ * therefore only ever starts a frame, and a frame is carried, suppressed,
+ * retained and written by the logging backends like any other line.
+ * tools/log_dict_decode.py rebuilds the text from the ELF file.
+ */
+#define LOG_DICT_SYNC			0xA5U
+#define LOG_DICT_ESC			0xA6U
+#define LOG_DICT_HDR_SIZE		11U
+/** Set in the type byte of a record logged again from the retained ring. */
+#define LOG_DICT_REPLAYED		0x80U
+
+/** Largest record, before it is framed. */
+#if !defined(LOG_DICT_RECORD_MAXLEN)
+#define LOG_DICT_RECORD_MAXLEN		128U
+#endif
+#if !defined(LOG_DICT_STRING_MAXLEN)
+#define LOG_DICT_STRING_MAXLEN		32U
+#endif
+/** Largest frame, when every byte of the record is escaped. */
+#define LOG_DICT_FRAME_MAXLEN		(1U + LOG_DICT_RECORD_MAXLEN * 2U)
+
+/**
+ * @brief Initialize dictionary logging.
+ *
+ * @param[in] get_time Timestamp source in milliseconds.
+ */
+void log_dict_init(uint32_t (*get_time)(void));
+
+/**
+ * @brief Encode a log record into its frame.
+ *
+ * @param[out] buf Buffer to encode into. LOG_DICT_FRAME_MAXLEN bytes
+ *             always suffice.
+ * @param[in] bufsize Size of @p buf in bytes.
+ * @param[in] type Log level.
+ * @param[in] fmt Format string. It must live in the firmware image.
+ * @param[in] ap Arguments for @p fmt.
+ * @return Size of the frame in bytes, or 0 if it does not fit.
+ */
+size_t log_dict_encode(void *buf, size_t bufsize, logging_t type,
+		const char *fmt, va_list ap);
+
+/**
+ * @brief Decode a frame back into its record.
+ *
+ * @param[out] buf Buffer to decode into.
+ * @param[in] bufsize Size of @p buf in bytes.
+ * @param[in] frame Frame produced by log_dict_encode().
+ * @param[in] len Length of @p frame in bytes.
+ * @return Size of the record in bytes, or 0 if @p frame is malformed or
+ *         the record does not fit.
+ */
+size_t log_dict_decode(void *buf, size_t bufsize, const void *frame,
+		size_t len);
+
+/**
+ * @brief Encode a log record and pass its frame to the logging backend.
+ *
+ * With LOGGING_DICTIONARY defined, debug(), info(), warn() and error()
+ * from "logging.h" log through it.
+ *
+ * @param[in] type Log level.
+ * @param[in] fmt Format string. It must live in the firmware image.
+ * @return Size of the frame taken by the backend in bytes.
+ */
+size_t log_dict_save(logging_t type, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LOG_DICT_H */
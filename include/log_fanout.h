@@ -0,0 +1,109 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LOG_FANOUT_H
+#define LOG_FANOUT_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "libmcu/logging.h"
+
+#if !defined(LOG_FANOUT_MAX_SINKS)
+#define LOG_FANOUT_MAX_SINKS		4U
+#endif
+/** Bytes of formatted text each sink can hold while it is behind. */
+#if !defined(LOG_FANOUT_QUEUE_SIZE)
+#define LOG_FANOUT_QUEUE_SIZE		2048U
+#endif
+/** Largest batch handed to a sink in one write call. */
+#if !defined(LOG_FANOUT_BATCH_SIZE)
+#define LOG_FANOUT_BATCH_SIZE		512U
+#endif
+#if !defined(LOG_FANOUT_STACK_SIZE)
+#define LOG_FANOUT_STACK_SIZE		3072U
+#endif
+#if !defined(LOG_FANOUT_PRIORITY)
+#define LOG_FANOUT_PRIORITY		1
+#endif
+
+typedef enum {
+	LOG_FANOUT_DROP_NEWEST, /**< keep what is queued, drop the new line */
+	LOG_FANOUT_DROP_OLDEST, /**< evict queued lines to make room */
+} log_fanout_policy_t;
+
+/**
+ * @brief Output registered to the fan-out layer.
+ */
+struct log_sink {
+	const char *name;
+	/**
+	 * Writes a batch of whole lines, each terminated by a newline. It is
+	 * called from the sink's own task only, so it may block.
+	 *
+	 * @return Number of bytes written.
+	 */
+	size_t (*write)(const void *data, size_t len);
+	logging_t level; /**< lowest level delivered */
+	log_fanout_policy_t policy;
+};
+
+struct log_sink_stats {
+	uint32_t lines;          /**< lines handed to the sink */
+	uint32_t batches;        /**< write calls */
+	uint32_t dropped;        /**< lines lost to a full queue or short write */
+	uint32_t latency_max_ms; /**< worst time from queueing to written */
+	uint32_t latency_avg_ms; /**< moving average of the same */
+	uint32_t queue_peak;     /**< high watermark of the queue in bytes */
+};
+
+/**
+ * @brief Add a sink and start its task.
+ *
+ * @param[in] sink Sink description. It is copied.
+ * @return Sink id on success, negative value on error.
+ */
+int log_fanout_add(const struct log_sink *sink);
+
+/**
+ * @brief Queue a formatted line to every sink whose level it meets.
+ *
+ * Lines whose level cannot be parsed are delivered to every sink. The
+ * caller never waits on a sink; a full queue is resolved by the policy of
+ * that sink alone.
+ *
+ * @param[in] text Line without its trailing newline. One is appended.
+ * @param[in] len Length of @p text in bytes.
+ * @return @p len if at least one sink took the line, 0 otherwise.
+ */
+size_t log_fanout_write(const char *text, size_t len);
+
+/**
+ * @brief Change the level threshold of a sink at run time.
+ *
+ * @param[in] id Sink id returned by log_fanout_add().
+ * @param[in] level Lowest level delivered.
+ * @return 0 on success, negative value on error.
+ */
+int log_fanout_set_level(int id, logging_t level);
+
+/**
+ * @brief Read the delivery statistics of a sink.
+ *
+ * @param[in] id Sink id returned by log_fanout_add().
+ * @param[out] stats Snapshot of the counters.
+ * @return 0 on success, negative value on error.
+ */
+int log_fanout_stats(int id, struct log_sink_stats *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LOG_FANOUT_H */
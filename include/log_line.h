@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LOG_LINE_H
+#define LOG_LINE_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "libmcu/logging.h"
+
+/**
+ * @brief Fields of a line produced by logging_stringify().
+ *
+ * Lines look like "<timestamp>: [<LEVEL>] <<pc>,<lr>> <message>". Fields
+ * that cannot be found are left as the whole line so that callers keying
+ * on them degrade to keying on the text. Dictionary frames from
+ * log_dict_encode() are split the same way, with the format string
+ * address as the call site.
+ */
+struct log_line {
+	logging_t level;      /**< LOGGING_TYPE_NONE if unknown */
+	const char *site;     /**< "<pc,lr>" call site */
+	size_t site_len;
+	const char *body;     /**< everything after the timestamp */
+	size_t body_len;
+	bool replayed;        /**< logged again by log_retained_init() */
+};
+
+/**
+ * @brief Split a formatted log line into its fields.
+ *
+ * @param[out] line Parsed fields. They point into @p text.
+ * @param[in] text Line produced by logging_stringify().
+ * @param[in] len Length of @p text in bytes.
+ */
+void log_line_parse(struct log_line *line, const char *text, size_t len);
+
+/**
+ * @brief 32-bit FNV-1a hash used to key lines and call sites.
+ *
+ * @param[in] data Bytes to hash.
+ * @param[in] len Number of bytes.
+ * @return Hash value.
+ */
+uint32_t log_line_hash(const char *data, size_t len);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LOG_LINE_H */
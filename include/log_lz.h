@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LOG_LZ_H
+#define LOG_LZ_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Small LZ compressor producing the LZ4 block format, so blocks can be
+ * inspected on a host with any LZ4 implementation. Input blocks are
+ * limited to 64 KiB and compressed independently of each other.
+ */
+
+#if !defined(LOG_LZ_HASH_BITS)
+#define LOG_LZ_HASH_BITS		10U
+#endif
+
+/** Number of uint16_t entries in the table passed to log_lz_compress(). */
+#define LOG_LZ_TABLE_LEN		(1U << LOG_LZ_HASH_BITS)
+/** Worst-case compressed size of @p n input bytes. */
+#define LOG_LZ_BOUND(n)			((n) + (n) / 255U + 16U)
+
+/**
+ * @brief Compress a block.
+ *
+ * @param[in] src Input bytes, at most 64 KiB.
+ * @param[in] srclen Number of input bytes.
+ * @param[out] dst Output buffer.
+ * @param[in] dstcap Size of @p dst in bytes.
+ * @param[in] table Scratch table of LOG_LZ_TABLE_LEN entries.
+ * @return Compressed size in bytes, or 0 if @p dst is too small.
+ */
+size_t log_lz_compress(const void *src, size_t srclen,
+		void *dst, size_t dstcap, uint16_t *table);
+
+/**
+ * @brief Decompress a block produced by log_lz_compress().
+ *
+ * @param[in] src Compressed bytes.
+ * @param[in] srclen Number of compressed bytes.
+ * @param[out] dst Output buffer.
+ * @param[in] dstcap Size of @p dst in bytes.
+ * @return Decompressed size in bytes, or negative value if the block is
+ *         malformed or does not fit in @p dst.
+ */
+int log_lz_decompress(const void *src, size_t srclen,
+		void *dst, size_t dstcap);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LOG_LZ_H */
@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LOG_RETAINED_H
+#define LOG_RETAINED_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/** Bytes of log text kept across resets. The whole ring, header included,
+ * must fit in the NOINIT region of the linker script. */
+#if !defined(LOG_RETAINED_SIZE)
+#define LOG_RETAINED_SIZE		768U
+#endif
+
+/** Prefix of the message of a line logged again by log_retained_init(). */
+#define LOG_RETAINED_TAG		"<retained>"
+
+/**
+ * @brief Replay the lines retained from the previous boot and start over.
+ *
+ * The retained ring lives in RAM that is not initialized at startup, so
+ * the last lines written before a watchdog or fault reset survive it. If
+ * the header is valid, the retained lines are logged again through the
+ * registered backends, tagged with LOG_RETAINED_TAG so that suppression
+ * lets them all through. The ring is then cleared and starts to record.
+ * Call it once, after the backends are registered and before anything
+ * else is logged.
+ *
+ * @return Number of lines replayed.
+ */
+size_t log_retained_init(void);
+
+/**
+ * @brief Append a formatted line to the retained ring.
+ *
+ * It costs a copy into RAM and a header update; nothing touches flash.
+ * The oldest lines are overwritten when the ring is full. Lines written
+ * before log_retained_init() are ignored.
+ *
+ * @param[in] text Line without the trailing newline.
+ * @param[in] len Length of @p text in bytes.
+ */
+void log_retained_write(const char *text, size_t len);
+
+/**
+ * @brief Copy the retained lines, oldest first, into @p buf.
+ *
+ * @param[out] buf Buffer to copy into.
+ * @param[in] bufsize Size of @p buf in bytes.
+ * @return Number of bytes copied.
+ */
+size_t log_retained_read(char *buf, size_t bufsize);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LOG_RETAINED_H */
@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LOG_RING_SLOT_HDR_SIZE		8U
+#define LOG_RING_SLOT_STRIDE(slot_size)	\
+	((LOG_RING_SLOT_HDR_SIZE + (slot_size) + 3U) & ~3U)
+#define LOG_RING_MEMSIZE(slot_count, slot_size)	\
+	((slot_count) * LOG_RING_SLOT_STRIDE(slot_size))
+
+/**
+ * @brief Bounded multi-producer, single-consumer ring of fixed-size slots.
+ *
+ * Producers reserve a slot with a single compare-and-swap and never block,
+ * so a put from any task costs one copy of the record. The only consumer
+ * reads committed slots in order and may process them in place.
+ */
+struct log_ring {
+	uint8_t *mem;
+	uint32_t stride;
+	uint32_t slot_size;
+	uint32_t mask;
+	uint32_t head;
+	uint32_t tail;
+};
+
+/**
+ * @brief Initialize a ring over caller-provided memory.
+ *
+ * The number of slots is the largest power of two that fits in @p memsize.
+ *
+ * @param[in] ring Ring to initialize.
+ * @param[in] mem Backing memory, 4-byte aligned.
+ * @param[in] memsize Size of @p mem in bytes.
+ * @param[in] slot_size Maximum payload of a slot in bytes.
+ * @return 0 on success, negative value on error.
+ */
+int log_ring_init(struct log_ring *ring, void *mem, size_t memsize,
+		size_t slot_size);
+
+/**
+ * @brief Copy a record into the next free slot.
+ *
+ * Safe to call concurrently from multiple tasks. It never blocks.
+ *
+ * @param[in] ring Ring to put into.
+ * @param[in] data Record to copy.
+ * @param[in] datasize Size of @p data in bytes.
+ * @return true on success, false if the ring is full or the record does
+ *         not fit in a slot.
+ */
+bool log_ring_put(struct log_ring *ring, const void *data, size_t datasize);
+
+/**
+ * @brief Get the oldest committed record without removing it.
+ *
+ * Must only be called from the single consumer.
+ *
+ * @param[in] ring Ring to peek.
+ * @param[out] datasize Size of the record in bytes.
+ * @return Pointer to the record, or NULL if nothing is committed yet.
+ */
+const void *log_ring_peek(struct log_ring *ring, size_t *datasize);
+
+/**
+ * @brief Release the record returned by the last log_ring_peek().
+ *
+ * @param[in] ring Ring to consume from.
+ */
+void log_ring_consume(struct log_ring *ring);
+
+/**
+ * @brief Get the number of slots reserved but not yet consumed.
+ *
+ * @param[in] ring Ring to query.
+ * @return Number of slots in use.
+ */
+size_t log_ring_count(const struct log_ring *ring);
+
+/**
+ * @brief Get the total number of slots.
+ *
+ * @param[in] ring Ring to query.
+ * @return Number of slots.
+ */
+size_t log_ring_capacity(const struct log_ring *ring);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LOG_RING_H */
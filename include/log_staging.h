@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LOG_STAGING_H
+#define LOG_STAGING_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/** Formatting buffers shared by all logging tasks. A task that finds them
+ * all in use formats on its own stack instead, so every task that logs
+ * needs LOGGING_MESSAGE_MAXLEN bytes of stack headroom unless this is at
+ * least the number of tasks logging at once. */
+#if !defined(LOG_STAGING_COUNT)
+#define LOG_STAGING_COUNT		4U
+#endif
+
+/**
+ * @brief Take a formatting buffer from the staging pool.
+ *
+ * The pool is handed out with a single compare-and-swap, so concurrent
+ * loggers format in parallel on their own buffers and only the console
+ * write is serialized.
+ *
+ * @param[out] bufsize Size of the returned buffer in bytes.
+ * @return Buffer on success, NULL if every buffer is in use.
+ */
+char *log_staging_acquire(size_t *bufsize);
+
+/**
+ * @brief Give a buffer back to the staging pool.
+ *
+ * @param[in] buf Buffer returned by log_staging_acquire().
+ */
+void log_staging_release(char *buf);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LOG_STAGING_H */
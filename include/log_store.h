@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LOG_STORE_H
+#define LOG_STORE_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Raw bytes of log text batched into one compressed block. */
+#if !defined(LOG_STORE_BLOCK_SIZE)
+#define LOG_STORE_BLOCK_SIZE		4096U
+#endif
+/** Longest time a line may wait in RAM before its block is written. This
+ * bounds both the latency of the store and the number of partial blocks,
+ * hence flash wear, per unit of time. */
+#if !defined(LOG_STORE_FLUSH_MS)
+#define LOG_STORE_FLUSH_MS		60000U
+#endif
+/** A file is closed and a new one started when it would exceed this. */
+#if !defined(LOG_STORE_FILE_SIZE)
+#define LOG_STORE_FILE_SIZE		(64U * 1024U)
+#endif
+/** Number of files kept. The oldest is removed when a new one starts. */
+#if !defined(LOG_STORE_FILES)
+#define LOG_STORE_FILES			32U
+#endif
+
+/**
+ * @brief Position of a reader in the store.
+ *
+ * Zero-initialize it to read from the oldest record.
+ */
+struct log_store_cursor {
+	uint32_t file;   /**< file sequence number */
+	uint32_t block;  /**< offset of the block in the file */
+	uint32_t pos;    /**< offset in the decompressed block */
+};
+
+/**
+ * @brief Mount the file system and start the store.
+ *
+ * Registers a logging backend that appends each formatted line to the
+ * store, and the SMP log group that reads the store back.
+ *
+ * @return 0 on success, negative value on error.
+ */
+int log_store_init(void);
+
+/**
+ * @brief Append a formatted line to the current block.
+ *
+ * The line is copied into RAM only. Full blocks are compressed and written
+ * by the store task. If the task is behind, the line is dropped and
+ * counted in LogStoreDropCount.
+ *
+ * @param[in] text Line without the trailing newline.
+ * @param[in] len Length of @p text in bytes.
+ * @return 0 on success, negative value on error.
+ */
+int log_store_write(const char *text, size_t len);
+
+/**
+ * @brief Write the current block now, regardless of the flush policy.
+ *
+ * Meant for shutdown and reboot paths.
+ *
+ * @return 0 on success, negative value on error.
+ */
+int log_store_flush(void);
+
+/**
+ * @brief Read stored text recorded between @p since and @p until.
+ *
+ * Only one block is held in RAM at a time. Call it repeatedly with the
+ * same cursor until it returns 0.
+ *
+ * @param[in,out] cursor Reader position.
+ * @param[in] since Oldest time of interest, in seconds since the epoch.
+ * @param[in] until Newest time of interest, in seconds since the epoch.
+ * @param[out] buf Buffer to copy the text into.
+ * @param[in] bufsize Size of @p buf in bytes.
+ * @return Number of bytes copied, 0 at the end, negative value on error.
+ */
+int log_store_read(struct log_store_cursor *cursor,
+		uint32_t since, uint32_t until, void *buf, size_t bufsize);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LOG_STORE_H */
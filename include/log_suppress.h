@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LOG_SUPPRESS_H
+#define LOG_SUPPRESS_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Number of call sites tracked at once. Must be a power of two. */
+#if !defined(LOG_SUPPRESS_SITES)
+#define LOG_SUPPRESS_SITES		16U
+#endif
+/** Lines per second a single call site may sustain. */
+#if !defined(LOG_SUPPRESS_RATE)
+#define LOG_SUPPRESS_RATE		10U
+#endif
+/** Lines a single call site may emit back to back. */
+#if !defined(LOG_SUPPRESS_BURST)
+#define LOG_SUPPRESS_BURST		20U
+#endif
+/** Interval to report a run of repeats that is still going on. */
+#if !defined(LOG_SUPPRESS_REPORT_MS)
+#define LOG_SUPPRESS_REPORT_MS		5000U
+#endif
+
+/**
+ * @brief Decide whether a formatted log line should be emitted.
+ *
+ * Identical consecutive lines are collapsed and lines beyond the token
+ * bucket of their call site are dropped. Both are counted in metrics.
+ * Lines replayed by log_retained_init() always pass. The cost is constant
+ * and nothing is allocated.
+ *
+ * @param[in] text Line produced by logging_stringify().
+ * @param[in] len Length of @p text in bytes.
+ * @param[out] repeats Number of collapsed repeats of the previous line
+ *             that the caller should report before this line, 0 if none.
+ *             It is set even when the line itself is dropped.
+ * @return true to emit the line, false to drop it.
+ */
+bool log_suppress_check(const char *text, size_t len, uint32_t *repeats);
+
+/**
+ * @brief Format the "repeated N times" line for @p repeats.
+ *
+ * @param[out] buf Buffer to format into.
+ * @param[in] bufsize Size of @p buf in bytes.
+ * @param[in] repeats Value returned by log_suppress_check().
+ * @return Length of the line, without a trailing newline.
+ */
+size_t log_suppress_stringify(char *buf, size_t bufsize, uint32_t repeats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* LOG_SUPPRESS_H */
@@ -13,8 +13,61 @@ extern "C" {
 
 #include "libmcu/logging.h"
 
+/**
+ * @brief Register the synchronous console backend.
+ *
+ * Each record is formatted and written to the console in the caller's
+ * context, so the caller blocks until the console accepts the line.
+ */
 void logging_stdout_backend_init(void);
 
+/**
+ * @brief Register the deferred console backend.
+ *
+ * Records are copied into a fixed-size lock-free ring in the caller's
+ * context and formatted and written by a low-priority drain task. When the
+ * ring is full the record is dropped and counted in LogDropCount instead
+ * of stalling the caller.
+ *
+ * @return 0 on success, negative value on error.
+ */
+int logging_async_backend_init(void);
+
+/**
+ * @brief Register the fan-out backend with the console as its first sink.
+ *
+ * Each record is formatted once in the caller's context and queued to
+ * every sink added with log_fanout_add(), each drained by its own task.
+ *
+ * @return 0 on success, negative value on error.
+ */
+int logging_fanout_backend_init(void);
+
+/**
+ * @brief Pass a record encoded outside the logging core to the backend.
+ *
+ * The record takes the same path as the lines formatted by the core:
+ * staging, suppression, retention and the console, or the ring of the
+ * deferred backend. It is written as given, without formatting.
+ *
+ * @param[in] data Encoded record, without a trailing newline.
+ * @param[in] size Size of @p data in bytes.
+ * @return @p size if the backend took the record, 0 otherwise.
+ */
+size_t logging_write_encoded(const void *data, size_t size);
+
+#if defined(LOGGING_DICTIONARY)
+#include "log_dict.h"
+#undef debug
+#undef info
+#undef warn
+#undef error
+#define debug(...)		log_dict_save(LOGGING_TYPE_DEBUG, __VA_ARGS__)
+#define info(...)		log_dict_save(LOGGING_TYPE_INFO, __VA_ARGS__)
+#define warn(...)		log_dict_save(LOGGING_TYPE_WARN, __VA_ARGS__)
+#define error(...)		log_dict_save(LOGGING_TYPE_ERROR, __VA_ARGS__)
+#endif
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SMP_FRAG_H
+#define SMP_FRAG_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SMP_FRAG_HDR_SIZE		8U
+
+/**
+ * @brief Reassembly of an SMP packet split over several link-layer writes.
+ *
+ * The packet length comes from the SMP header, so fragments carry no
+ * extra framing. A fragment never spans two packets.
+ */
+struct smp_reasm {
+	uint8_t *buf;
+	size_t bufsize;
+	size_t len;
+	size_t expected;
+};
+
+/**
+ * @brief Splits an SMP packet into fragments of at most a given size.
+ */
+struct smp_frag {
+	const uint8_t *data;
+	size_t len;
+	size_t pos;
+};
+
+/**
+ * @brief Initialize a reassembly over caller-provided memory.
+ *
+ * @param[in] reasm Reassembly to initialize.
+ * @param[in] buf Buffer to reassemble into.
+ * @param[in] bufsize Size of @p buf in bytes, the largest packet accepted.
+ */
+void smp_reasm_init(struct smp_reasm *reasm, void *buf, size_t bufsize);
+
+/**
+ * @brief Append a fragment.
+ *
+ * On error the partial packet is discarded and the next fragment is taken
+ * as the start of a new packet.
+ *
+ * @param[in] reasm Reassembly to append to.
+ * @param[in] data Fragment received.
+ * @param[in] datasize Size of @p data in bytes.
+ * @return Length of the packet once it is complete, 0 if more fragments
+ *         are needed, -EMSGSIZE if the packet does not fit in the buffer
+ *         or -EPROTO if the fragment runs past the end of the packet.
+ */
+int smp_reasm_feed(struct smp_reasm *reasm, const void *data, size_t datasize);
+
+/**
+ * @brief Discard whatever is buffered, including a complete packet.
+ *
+ * @param[in] reasm Reassembly to reset.
+ */
+void smp_reasm_reset(struct smp_reasm *reasm);
+
+/**
+ * @brief Check if a packet is partially received.
+ *
+ * @param[in] reasm Reassembly to query.
+ * @return true if fragments of an incomplete packet are buffered.
+ */
+bool smp_reasm_busy(const struct smp_reasm *reasm);
+
+/**
+ * @brief Start splitting a packet.
+ *
+ * The packet is not copied and must stay valid until the last fragment
+ * is consumed.
+ *
+ * @param[in] frag Fragmenter to initialize.
+ * @param[in] data Packet to split.
+ * @param[in] datasize Size of @p data in bytes.
+ */
+void smp_frag_init(struct smp_frag *frag, const void *data, size_t datasize);
+
+/**
+ * @brief Get the next fragment without consuming it.
+ *
+ * The limit may change between calls, as when the MTU is renegotiated in
+ * the middle of a packet.
+ *
+ * @param[in] frag Fragmenter to peek.
+ * @param[in] maxlen Maximum fragment size in bytes.
+ * @param[out] datasize Size of the fragment in bytes.
+ * @return Pointer to the fragment, or NULL when the packet is all sent.
+ */
+const void *smp_frag_peek(const struct smp_frag *frag, size_t maxlen,
+		size_t *datasize);
+
+/**
+ * @brief Consume the fragment returned by the last smp_frag_peek().
+ *
+ * @param[in] frag Fragmenter to advance.
+ * @param[in] datasize Size of the fragment sent.
+ */
+void smp_frag_consume(struct smp_frag *frag, size_t datasize);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SMP_FRAG_H */
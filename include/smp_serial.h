@@ -0,0 +1,191 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SMP_SERIAL_H
+#define SMP_SERIAL_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Largest SMP packet sent or received, header included. */
+#if !defined(SMP_SERIAL_PKT_MAX)
+#define SMP_SERIAL_PKT_MAX		1032U
+#endif
+/** Base64 characters per console line. */
+#if !defined(SMP_SERIAL_LINE_MAX)
+#define SMP_SERIAL_LINE_MAX		128U
+#endif
+
+/** Both framings decode the CRC into the buffer after the packet. */
+#define SMP_SERIAL_BUF_SIZE		(SMP_SERIAL_PKT_MAX + 2U)
+/** Terminates every console line. A port may wake on it. */
+#define SMP_SERIAL_LINE_END		0x0AU
+/** Bytes of a COBS frame staged per write. The frame goes out in whole
+ * blocks, so it holds at least a full block, a code byte and 254 data
+ * bytes, with both delimiters. Blocks are gathered up to this size
+ * before a write. */
+#if !defined(SMP_SERIAL_COBS_TX_BUFSIZE)
+#define SMP_SERIAL_COBS_TX_BUFSIZE	512U
+#endif
+#if SMP_SERIAL_COBS_TX_BUFSIZE < 257U
+#error "SMP_SERIAL_COBS_TX_BUFSIZE must hold a full COBS block"
+#endif
+
+typedef enum {
+	/** Base64 lines with 0x06 0x09 / 0x04 0x14 prefixes. They share the
+	 * console with log output and work with any SMP serial client. */
+	SMP_SERIAL_FRAMING_CONSOLE,
+	/** Binary frames: 0x00, COBS(packet, CRC16), 0x00. Each frame starts
+	 * with its own delimiter. The link must be 8-bit clean. */
+	SMP_SERIAL_FRAMING_COBS,
+	/** Accept both and reply in the framing of the last request. */
+	SMP_SERIAL_FRAMING_AUTO,
+} smp_serial_framing_t;
+
+struct smp_serial_ops {
+	/** Write part of an outgoing frame: one whole line in console
+	 * framing, or whole COBS blocks in COBS framing. A COBS frame may
+	 * take several writes; the first starts with the delimiter and the
+	 * last ends with it. Returns the number of bytes written or a
+	 * negative value on error. */
+	int (*write)(const void *data, size_t len,
+			smp_serial_framing_t framing, void *ctx);
+	/** Provide a buffer of SMP_SERIAL_BUF_SIZE bytes to decode the next
+	 * packet into. It may block. NULL drops the packet. */
+	uint8_t *(*lease)(void *ctx);
+	/** Take a verified packet. The buffer is the one leased, and it is
+	 * the callee's from now on. @p framing is the one it came in. */
+	void (*deliver)(uint8_t *buf, size_t len,
+			smp_serial_framing_t framing, void *ctx);
+};
+
+struct smp_serial_stats {
+	uint32_t rx_packets;
+	uint32_t crc_errors;
+	uint32_t malformed;
+	uint32_t dropped; /* no buffer to decode into */
+};
+
+/**
+ * @brief SMP serial framing, free of any driver.
+ *
+ * Received bytes are fed in as they come, in blocks of any size, and
+ * decoded in place into leased buffers. Outgoing packets are encoded on
+ * the fly and written through the ops.
+ */
+struct smp_serial {
+	const struct smp_serial_ops *ops;
+	void *ctx;
+
+	smp_serial_framing_t framing;
+	smp_serial_framing_t tx_framing; /* resolved for AUTO */
+
+	uint8_t state;
+	uint8_t expected_hdr2;
+	bool line_is_start;
+	bool active;	/* a packet is open */
+	bool bad;	/* drop it at the end of the frame */
+	bool padded;	/* saw the final quantum */
+	uint8_t quantum[4];
+	uint8_t quantum_len;
+	uint8_t len_field[2];
+	uint8_t cobs_code; /* 0 before the first block */
+	uint8_t cobs_left; /* bytes left in the block */
+	uint16_t crc;
+	size_t decoded_len;
+	uint8_t *buf;	/* leased, NULL if none */
+
+	struct smp_serial_stats stats;
+
+	/* TX: one line of [start or cont][base64][end] */
+	uint8_t tx_line[2U + SMP_SERIAL_LINE_MAX + 1U];
+	/* TX: COBS blocks of a binary frame, written as it fills */
+	uint8_t tx_cobs[SMP_SERIAL_COBS_TX_BUFSIZE];
+};
+
+/**
+ * @brief Initialize the framing in console mode.
+ *
+ * @param[in] s Instance to initialize.
+ * @param[in] ops Output and buffer callbacks.
+ * @param[in] ctx Opaque context forwarded to @p ops.
+ */
+void smp_serial_init(struct smp_serial *s, const struct smp_serial_ops *ops,
+		void *ctx);
+
+/**
+ * @brief Select the framing.
+ *
+ * Until a request arrives, SMP_SERIAL_FRAMING_AUTO sends console framing.
+ *
+ * @param[in] s Instance to configure.
+ * @param[in] framing Framing to use from now on.
+ * @return 0 on success, -1 on an unknown framing.
+ */
+int smp_serial_set_framing(struct smp_serial *s, smp_serial_framing_t framing);
+
+/**
+ * @brief Reply in the framing a request came in.
+ *
+ * Has no effect unless the framing is SMP_SERIAL_FRAMING_AUTO. Meant to
+ * be called with the framing passed to deliver, right before the packet
+ * is handled.
+ *
+ * @param[in] s Instance to configure.
+ * @param[in] framing Framing of the request.
+ */
+void smp_serial_set_reply_framing(struct smp_serial *s,
+		smp_serial_framing_t framing);
+
+/**
+ * @brief Run the receiver over a block of received bytes.
+ *
+ * @param[in] s Instance to feed.
+ * @param[in] data Bytes received.
+ * @param[in] datasize Size of @p data in bytes.
+ */
+void smp_serial_feed(struct smp_serial *s, const void *data, size_t datasize);
+
+/**
+ * @brief Drop the frame being received, as after lost bytes.
+ *
+ * A leased buffer is kept for the next frame.
+ *
+ * @param[in] s Instance to reset.
+ */
+void smp_serial_reset(struct smp_serial *s);
+
+/**
+ * @brief Encode and write a packet.
+ *
+ * Not reentrant. The caller serializes sends.
+ *
+ * @param[in] s Instance to send through.
+ * @param[in] data SMP packet bytes.
+ * @param[in] datasize Size of @p data in bytes.
+ * @return 0 on success, -1 on failure.
+ */
+int smp_serial_send(struct smp_serial *s, const void *data, size_t datasize);
+
+/**
+ * @brief Get the receive counters.
+ *
+ * @param[in] s Instance to query.
+ * @param[out] stats Counters since initialization.
+ */
+void smp_serial_get_stats(const struct smp_serial *s,
+		struct smp_serial_stats *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SMP_SERIAL_H */
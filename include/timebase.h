@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @brief Start the high-resolution timebase.
+ *
+ * Call it once from a task, before the first timestamp is taken.
+ *
+ * @return 0 on success, negative value on error.
+ */
+int timebase_init(void);
+
+/**
+ * @brief Monotonic 64-bit tick count since timebase_init().
+ *
+ * The tick is the finest counter the port has: the CPU cycle on nRF52,
+ * the system clock cycle on Zephyr and the microsecond on ESP-IDF. It is
+ * safe to call from interrupt context and keeps counting across
+ * tickless idle.
+ *
+ * @return Ticks since timebase_init().
+ */
+uint64_t timebase_get_ticks(void);
+
+/**
+ * @brief Frequency of timebase_get_ticks() in Hz.
+ *
+ * @return Ticks per second.
+ */
+uint32_t timebase_get_frequency(void);
+
+/**
+ * @brief Microseconds since timebase_init().
+ *
+ * @return Microseconds.
+ */
+uint64_t timebase_get_us(void);
+
+/**
+ * @brief Low 32 bits of timebase_get_us().
+ *
+ * Meant to be passed to logging_init() when records should carry
+ * microsecond timestamps. It wraps every 71 minutes.
+ *
+ * @return Microseconds modulo 2^32.
+ */
+uint32_t timebase_get_us32(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* TIMEBASE_H */
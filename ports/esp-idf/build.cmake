@@ -27,6 +27,11 @@ idf_build_set_property(DEPENDENCIES_LOCK "${CMAKE_BINARY_DIR}/dependencies.lock"
 
 # Register local component that declares esp_wifi_remote dependencies.
 idf_build_component("${CMAKE_CURRENT_LIST_DIR}/components/remote_wifi_host")
+# Register local component that pulls littlefs for the persistent log store.
+if(LOGGING_STORE)
+	list(APPEND COMPONENTS_USED littlefs_host)
+	idf_build_component("${CMAKE_CURRENT_LIST_DIR}/components/littlefs_host")
+endif()
 
 if ($ENV{IDF_VERSION} VERSION_GREATER_EQUAL "5.0.0")
 	list(APPEND COMPONENTS_USED esp_adc)
@@ -59,6 +64,13 @@ configure_file("${IDF_PATH}/tools/cmake/project_description.json.in"
 idf_build_set_property(COMPILE_DEFINITIONS -DxPortIsInsideInterrupt=xPortInIsrContext APPEND)
 idf_build_set_property(C_COMPILE_OPTIONS "-Wno-implicit-function-declaration" APPEND)
 
+# The persistent log store is opt-in like the other LOGGING_* switches.
+# Configure with -DLOGGING_STORE=ON to enable it.
+if(LOGGING_STORE)
+	target_compile_definitions(${PROJECT_EXECUTABLE} PRIVATE LOGGING_STORE)
+	target_link_libraries(${PROJECT_EXECUTABLE} idf::joltwallet__littlefs)
+endif()
+
 target_link_libraries(${PROJECT_EXECUTABLE}
 	idf::esp_psram
 	idf::freertos
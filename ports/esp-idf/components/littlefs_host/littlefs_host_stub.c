@@ -0,0 +1,3 @@
+void littlefs_host_component_stub(void)
+{
+}
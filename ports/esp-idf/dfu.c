@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "libmcu/board.h"
 #include "libmcu/metrics.h"
 #include "mbedtls/sha256.h"
 #include "esp_ota_ops.h"
@@ -19,10 +20,19 @@
 #define FLASH_SECTOR_SIZE	4096U
 #endif
 
+/* Also hash the image as read back from the slot at finish, on top of
+ * the digest taken while writing. Catches bytes that did not make it to
+ * flash as written, at the cost of reading the whole image again. */
+#if !defined(DFU_VERIFY_READBACK)
+#define DFU_VERIFY_READBACK	0
+#endif
+
 #if !defined(MIN)
 #define MIN(a, b)		((a) > (b)? (b) : (a))
 #endif
 
+#define DFU_DIGEST_SIZE	32U
+
 struct dfu {
 	struct dfu_image_header header;
 
@@ -30,6 +40,14 @@ struct dfu {
 	const esp_partition_t *slot;
 	uint8_t *buf;
 	size_t bufsize;
+
+	/* Digest of the bytes written so far, in the order written, which
+	 * is the order they land in the slot. */
+	mbedtls_sha256_context sha;
+	size_t written;
+	bool hashing;
+
+	uint32_t started_at;
 };
 
 static bool is_valid_header(const struct dfu_image_header *header)
@@ -37,16 +55,13 @@ static bool is_valid_header(const struct dfu_image_header *header)
 	return header->magic == 0xC0DEu && header->type == DFU_TYPE_APP;
 }
 
-static bool verify_digest(const struct dfu *dfu)
+static bool read_back_digest(const struct dfu *dfu,
+		uint8_t digest[DFU_DIGEST_SIZE])
 {
-	if (dfu->header.datasize == 0 ||
-			dfu->header.datasize > dfu->slot->size) {
-		return false;
-	}
-
 	mbedtls_sha256_context sha;
 	mbedtls_sha256_init(&sha);
 	size_t chunk = 0;
+	bool ok = false;
 
 	if (mbedtls_sha256_starts(&sha, 0/*sha256*/) != 0) {
 		goto out_free;
@@ -62,16 +77,37 @@ static bool verify_digest(const struct dfu *dfu)
 		}
 	}
 
-	uint8_t digest[32] = { 0, };
-	mbedtls_sha256_finish(&sha, digest);
+	ok = mbedtls_sha256_finish(&sha, digest) == 0;
 out_free:
 	mbedtls_sha256_free(&sha);
+	return ok;
+}
 
-	if (memcmp(dfu->header.signature, digest, sizeof(digest)) == 0) {
-		return true;
+static bool verify_digest(struct dfu *dfu)
+{
+	uint8_t digest[DFU_DIGEST_SIZE] = { 0, };
+
+	if (dfu->header.datasize == 0 ||
+			dfu->header.datasize > dfu->slot->size) {
+		return false;
 	}
 
-	return false;
+	/* Without the running digest, as when hashing failed midway, the
+	 * image is read back instead. */
+	if (dfu->hashing) {
+		if (dfu->written < dfu->header.datasize ||
+				mbedtls_sha256_finish(&dfu->sha, digest) != 0 ||
+				memcmp(dfu->header.signature, digest,
+					sizeof(digest)) != 0) {
+			return false;
+		}
+		if (!DFU_VERIFY_READBACK) {
+			return true;
+		}
+	}
+
+	return read_back_digest(dfu, digest) &&
+		memcmp(dfu->header.signature, digest, sizeof(digest)) == 0;
 }
 
 bool dfu_is_valid_header(const struct dfu_image_header *header)
@@ -82,16 +118,39 @@ bool dfu_is_valid_header(const struct dfu_image_header *header)
 dfu_error_t dfu_write(struct dfu *dfu, uint32_t offset,
 		const void *data, size_t datasize)
 {
-	if (esp_ota_write(dfu->ota_handle, dfu->buf, datasize) != ESP_OK) {
+	/* Writes are sequential. Each block is appended to the slot in the
+	 * order it comes, wherever the offset says it goes. */
+	(void)offset;
+
+	const uint32_t t0 = board_get_time_since_boot_ms();
+
+	if (esp_ota_write(dfu->ota_handle, data, datasize) != ESP_OK) {
 		metrics_increase(DFUIOErrorCount);
 		return DFU_ERROR_IO;
 	}
 
+	/* Only the image is hashed, not any padding after it, just as the
+	 * read-back covers header.datasize bytes of the slot. */
+	const size_t left = dfu->header.datasize -
+		MIN(dfu->written, (size_t)dfu->header.datasize);
+	const size_t hashsize = MIN(datasize, left);
+
+	if (dfu->hashing && hashsize != 0 && mbedtls_sha256_update(&dfu->sha,
+			(const uint8_t *)data, hashsize) != 0) {
+		dfu->hashing = false;
+	}
+
+	dfu->written += datasize;
+	metrics_set_if_max(DFUWriteTimeMax,
+			(int32_t)(board_get_time_since_boot_ms() - t0));
+
 	return DFU_ERROR_NONE;
 }
 
 dfu_error_t dfu_prepare(struct dfu *dfu, const struct dfu_image_header *header)
 {
+	const uint32_t t0 = board_get_time_since_boot_ms();
+
 	memcpy(&dfu->header, header, sizeof(*header));
 
 	if (!is_valid_header(&dfu->header)) {
@@ -112,6 +171,12 @@ dfu_error_t dfu_prepare(struct dfu *dfu, const struct dfu_image_header *header)
 		return DFU_ERROR_INVALID_SLOT;
 	}
 
+	dfu->written = 0;
+	dfu->hashing = mbedtls_sha256_starts(&dfu->sha, 0/*sha256*/) == 0;
+	dfu->started_at = t0;
+	metrics_set(DFUPrepareTime,
+			(int32_t)(board_get_time_since_boot_ms() - t0));
+
 	return DFU_ERROR_NONE;
 }
 
@@ -123,6 +188,7 @@ dfu_error_t dfu_abort(struct dfu *dfu)
 
 dfu_error_t dfu_finish(struct dfu *dfu)
 {
+	const uint32_t t0 = board_get_time_since_boot_ms();
 	esp_err_t err = esp_ota_end(dfu->ota_handle);
 
 	if (err != ESP_OK || !verify_digest(dfu)) {
@@ -137,6 +203,9 @@ dfu_error_t dfu_finish(struct dfu *dfu)
 		return DFU_ERROR_SLOT_UPDATE_FAIL;
 	}
 
+	const uint32_t now = board_get_time_since_boot_ms();
+	metrics_set(DFUFinishTime, (int32_t)(now - t0));
+	metrics_set(DFUUpdateTime, (int32_t)(now - dfu->started_at));
 	metrics_increase(DFUSuccessCount);
 	return DFU_ERROR_NONE;
 }
@@ -193,6 +262,7 @@ struct dfu *dfu_new(size_t data_block_size)
 
 		p->slot = esp_ota_get_next_update_partition(NULL);
 		p->bufsize = data_block_size;
+		mbedtls_sha256_init(&p->sha);
 	}
 
 	return p;
@@ -200,6 +270,7 @@ struct dfu *dfu_new(size_t data_block_size)
 
 void dfu_delete(struct dfu *dfu)
 {
+	mbedtls_sha256_free(&dfu->sha);
 	free(dfu->buf);
 	free(dfu);
 }
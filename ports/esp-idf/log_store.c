@@ -0,0 +1,533 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "log_store.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_littlefs.h"
+#include "esp_rom_crc.h"
+#include "esp_log.h"
+#include "mgmt/mgmt.h"
+#include "cborattr/cborattr.h"
+
+#include "libmcu/board.h"
+#include "libmcu/metrics.h"
+
+#include "logging.h"
+#include "log_lz.h"
+#include "log_staging.h"
+
+#define TAG				"log_store"
+
+#define PARTITION_LABEL			"fs"
+#define BASE_PATH			"/fs"
+#define LOG_DIR				BASE_PATH "/log"
+#define PATH_MAXLEN			32U
+
+#define BLOCK_MAGIC			0x4B4C424CU /* "LBLK" */
+#define STORE_TASK_STACK_SIZE		4096U
+#define STORE_TASK_PRIORITY		2U
+#define STORE_FLUSH_CHECK_MS		(LOG_STORE_FLUSH_MS / 4U)
+#define STORE_FLUSH_WAIT_MS		10U
+
+#define LOG_MGMT_ID_SHOW		0
+#define LOG_MGMT_CHUNK_SIZE		512U
+
+struct block_hdr {
+	uint32_t magic;
+	uint32_t t_first;
+	uint32_t t_last;
+	uint16_t raw_len;
+	uint16_t comp_len;
+	uint32_t crc;
+};
+
+struct block {
+	struct block_hdr hdr;
+	size_t len;
+	uint32_t opened_at;
+	char data[LOG_STORE_BLOCK_SIZE];
+};
+
+/* The block last decompressed into store.raw. A reader walks a block in
+ * LOG_MGMT_CHUNK_SIZE steps, so it is loaded once rather than per step.
+ * Blocks are never rewritten and file numbers never reused, so the copy
+ * stays valid until the next load. */
+struct cached_block {
+	struct block_hdr hdr;
+	uint32_t file;
+	uint32_t block;
+	int len; /* 0 when store.raw holds nothing usable */
+};
+
+struct log_store {
+	struct block blocks[2];
+	struct block *active;
+	struct block *pending; /* handed to the store task, NULL when idle */
+	SemaphoreHandle_t lock;
+	SemaphoreHandle_t io_lock;
+	TaskHandle_t task;
+
+	uint32_t first_file;
+	uint32_t last_file;
+	uint32_t last_file_size;
+
+	uint16_t table[LOG_LZ_TABLE_LEN];
+	uint8_t comp[LOG_LZ_BOUND(LOG_STORE_BLOCK_SIZE)];
+	char raw[LOG_STORE_BLOCK_SIZE];
+	struct cached_block cached;
+};
+
+static struct log_store store;
+
+static void get_path(char *buf, uint32_t file)
+{
+	snprintf(buf, PATH_MAXLEN, LOG_DIR "/%08lx.lz", (unsigned long)file);
+}
+
+static uint32_t now_sec(void)
+{
+	return (uint32_t)time(NULL);
+}
+
+/* Must be called with store.lock held. */
+static bool hand_over_active_block(void)
+{
+	if (store.pending != NULL) {
+		return false;
+	}
+
+	store.pending = store.active;
+	store.active = (store.active == &store.blocks[0])?
+		&store.blocks[1] : &store.blocks[0];
+	store.active->len = 0;
+
+	xTaskNotifyGive(store.task);
+	return true;
+}
+
+static void rotate(void)
+{
+	char path[PATH_MAXLEN];
+
+	store.last_file++;
+	store.last_file_size = 0;
+
+	while (store.last_file - store.first_file >= LOG_STORE_FILES) {
+		get_path(path, store.first_file++);
+		unlink(path);
+	}
+}
+
+static int write_block(struct block *b)
+{
+	char path[PATH_MAXLEN];
+	int err = 0;
+
+	xSemaphoreTake(store.io_lock, portMAX_DELAY);
+
+	size_t comp_len = log_lz_compress(b->data, b->len,
+			store.comp, sizeof(store.comp), store.table);
+
+	b->hdr.magic = BLOCK_MAGIC;
+	b->hdr.raw_len = (uint16_t)b->len;
+	b->hdr.comp_len = (uint16_t)comp_len;
+	b->hdr.crc = esp_rom_crc32_le(0, store.comp, (uint32_t)comp_len);
+
+	const size_t total = sizeof(b->hdr) + comp_len;
+	if (store.last_file_size > 0 &&
+			store.last_file_size + total > LOG_STORE_FILE_SIZE) {
+		rotate();
+	}
+
+	get_path(path, store.last_file);
+	FILE *f = fopen(path, "ab");
+
+	if (f == NULL ||
+			fwrite(&b->hdr, sizeof(b->hdr), 1, f) != 1 ||
+			fwrite(store.comp, 1, comp_len, f) != comp_len) {
+		ESP_LOGE(TAG, "write %s failed", path);
+		err = -EIO;
+	} else {
+		store.last_file_size += (uint32_t)total;
+		metrics_increase_by(LogStoreFlashBytes, (int32_t)total);
+	}
+
+	if (f != NULL) {
+		fclose(f); /* littlefs commits on close */
+	}
+
+	xSemaphoreGive(store.io_lock);
+
+	return err;
+}
+
+static void store_task(void *arg)
+{
+	(void)arg;
+
+	for (;;) {
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STORE_FLUSH_CHECK_MS));
+
+		xSemaphoreTake(store.lock, portMAX_DELAY);
+		if (store.pending == NULL && store.active->len > 0 &&
+				board_get_time_since_boot_ms() -
+				store.active->opened_at >= LOG_STORE_FLUSH_MS) {
+			hand_over_active_block();
+		}
+		struct block *b = store.pending;
+		xSemaphoreGive(store.lock);
+
+		if (b != NULL) {
+			write_block(b);
+
+			xSemaphoreTake(store.lock, portMAX_DELAY);
+			store.pending = NULL;
+			xSemaphoreGive(store.lock);
+		}
+	}
+}
+
+int log_store_write(const char *text, size_t len)
+{
+	if (store.task == NULL) {
+		return -ENODEV;
+	}
+	if (len >= LOG_STORE_BLOCK_SIZE) {
+		len = LOG_STORE_BLOCK_SIZE - 1;
+	}
+
+	xSemaphoreTake(store.lock, portMAX_DELAY);
+
+	struct block *b = store.active;
+
+	if (b->len + len + 1 > sizeof(b->data)) {
+		if (!hand_over_active_block()) {
+			xSemaphoreGive(store.lock);
+			metrics_increase(LogStoreDropCount);
+			return -ENOSPC;
+		}
+		b = store.active;
+	}
+
+	if (b->len == 0) {
+		b->hdr.t_first = now_sec();
+		b->opened_at = board_get_time_since_boot_ms();
+	}
+
+	memcpy(&b->data[b->len], text, len);
+	b->data[b->len + len] = '\n';
+	b->len += len + 1;
+	b->hdr.t_last = now_sec();
+
+	xSemaphoreGive(store.lock);
+
+	metrics_increase(LogStoreRecordCount);
+
+	return 0;
+}
+
+int log_store_flush(void)
+{
+	if (store.task == NULL) {
+		return -ENODEV;
+	}
+
+	for (int handed = 0; !handed;) {
+		xSemaphoreTake(store.lock, portMAX_DELAY);
+		handed = store.active->len == 0 || hand_over_active_block();
+		xSemaphoreGive(store.lock);
+
+		if (!handed) {
+			vTaskDelay(pdMS_TO_TICKS(STORE_FLUSH_WAIT_MS));
+		}
+	}
+
+	while (__atomic_load_n(&store.pending, __ATOMIC_ACQUIRE) != NULL) {
+		vTaskDelay(pdMS_TO_TICKS(STORE_FLUSH_WAIT_MS));
+	}
+
+	return 0;
+}
+
+static void next_file(struct log_store_cursor *cursor)
+{
+	cursor->file++;
+	cursor->block = 0;
+	cursor->pos = 0;
+}
+
+static void next_block(struct log_store_cursor *cursor,
+		const struct block_hdr *hdr)
+{
+	cursor->block += (uint32_t)(sizeof(*hdr) + hdr->comp_len);
+	cursor->pos = 0;
+}
+
+/* Reads and decompresses the block at the cursor into store.raw, unless
+ * it is there already. Returns the decompressed size, 0 at the end of the
+ * file, or negative value if the block is damaged. */
+static int load_block(const struct log_store_cursor *cursor,
+		struct block_hdr *hdr)
+{
+	struct cached_block *cached = &store.cached;
+	char path[PATH_MAXLEN];
+	int rc = 0;
+
+	if (cached->len > 0 && cached->file == cursor->file &&
+			cached->block == cursor->block) {
+		*hdr = cached->hdr;
+		return cached->len;
+	}
+
+	get_path(path, cursor->file);
+	FILE *f = fopen(path, "rb");
+
+	if (f == NULL) {
+		return 0;
+	}
+
+	if (fseek(f, (long)cursor->block, SEEK_SET) != 0 ||
+			fread(hdr, sizeof(*hdr), 1, f) != 1) {
+		goto out;
+	}
+	if (hdr->magic != BLOCK_MAGIC || hdr->comp_len > sizeof(store.comp) ||
+			fread(store.comp, 1, hdr->comp_len, f) != hdr->comp_len ||
+			esp_rom_crc32_le(0, store.comp, hdr->comp_len) != hdr->crc) {
+		rc = -EIO;
+		goto out;
+	}
+
+	cached->len = 0;
+	rc = log_lz_decompress(store.comp, hdr->comp_len,
+			store.raw, sizeof(store.raw));
+	if (rc > 0) {
+		*cached = (struct cached_block) {
+			.hdr = *hdr,
+			.file = cursor->file,
+			.block = cursor->block,
+			.len = rc,
+		};
+	}
+out:
+	fclose(f);
+	return rc;
+}
+
+int log_store_read(struct log_store_cursor *cursor,
+		uint32_t since, uint32_t until, void *buf, size_t bufsize)
+{
+	struct block_hdr hdr;
+	int rc = 0;
+
+	xSemaphoreTake(store.io_lock, portMAX_DELAY);
+
+	if (cursor->file < store.first_file) {
+		cursor->file = store.first_file;
+		cursor->block = 0;
+		cursor->pos = 0;
+	}
+
+	while (cursor->file <= store.last_file) {
+		int len = load_block(cursor, &hdr);
+
+		if (len <= 0) { /* end of file, or a torn tail after reset */
+			next_file(cursor);
+			continue;
+		}
+		if (hdr.t_last < since || cursor->pos >= (uint32_t)len) {
+			next_block(cursor, &hdr);
+			continue;
+		}
+		if (hdr.t_first > until) {
+			cursor->file = store.last_file + 1;
+			break;
+		}
+
+		size_t n = (size_t)len - cursor->pos;
+		n = (n < bufsize)? n : bufsize;
+		memcpy(buf, &store.raw[cursor->pos], n);
+		cursor->pos += (uint32_t)n;
+		rc = (int)n;
+		break;
+	}
+
+	xSemaphoreGive(store.io_lock);
+
+	return rc;
+}
+
+static int log_mgmt_show(struct mgmt_ctxt *ctxt)
+{
+	static uint8_t chunk[LOG_MGMT_CHUNK_SIZE];
+	unsigned long long since = 0;
+	unsigned long long until = UINT32_MAX;
+	unsigned long long file = 0;
+	unsigned long long block = 0;
+	unsigned long long pos = 0;
+	const struct cbor_attr_t attrs[] = {
+		{ .attribute = "since", .type = CborAttrUnsignedIntegerType,
+			.addr.uinteger = &since, .nodefault = true },
+		{ .attribute = "until", .type = CborAttrUnsignedIntegerType,
+			.addr.uinteger = &until, .nodefault = true },
+		{ .attribute = "file", .type = CborAttrUnsignedIntegerType,
+			.addr.uinteger = &file, .nodefault = true },
+		{ .attribute = "block", .type = CborAttrUnsignedIntegerType,
+			.addr.uinteger = &block, .nodefault = true },
+		{ .attribute = "pos", .type = CborAttrUnsignedIntegerType,
+			.addr.uinteger = &pos, .nodefault = true },
+		{ .attribute = NULL },
+	};
+
+	if (cbor_read_object(&ctxt->it, attrs) != 0) {
+		return MGMT_ERR_EINVAL;
+	}
+
+	struct log_store_cursor cursor = {
+		.file = (uint32_t)file,
+		.block = (uint32_t)block,
+		.pos = (uint32_t)pos,
+	};
+	int len = log_store_read(&cursor, (uint32_t)since, (uint32_t)until,
+			chunk, sizeof(chunk));
+	if (len < 0) {
+		return MGMT_ERR_EUNKNOWN;
+	}
+
+	CborError err = CborNoError;
+	err |= cbor_encode_text_stringz(&ctxt->encoder, "data");
+	err |= cbor_encode_byte_string(&ctxt->encoder, chunk, (size_t)len);
+	err |= cbor_encode_text_stringz(&ctxt->encoder, "file");
+	err |= cbor_encode_uint(&ctxt->encoder, cursor.file);
+	err |= cbor_encode_text_stringz(&ctxt->encoder, "block");
+	err |= cbor_encode_uint(&ctxt->encoder, cursor.block);
+	err |= cbor_encode_text_stringz(&ctxt->encoder, "pos");
+	err |= cbor_encode_uint(&ctxt->encoder, cursor.pos);
+	err |= cbor_encode_text_stringz(&ctxt->encoder, "done");
+	err |= cbor_encode_boolean(&ctxt->encoder, len == 0);
+
+	return (err == CborNoError)? 0 : MGMT_ERR_ENOMEM;
+}
+
+static const struct mgmt_handler log_mgmt_handlers[] = {
+	[LOG_MGMT_ID_SHOW] = { .mh_read = log_mgmt_show, .mh_write = NULL },
+};
+
+static struct mgmt_group log_mgmt_group = {
+	.mg_handlers = log_mgmt_handlers,
+	.mg_handlers_count = sizeof(log_mgmt_handlers) /
+		sizeof(log_mgmt_handlers[0]),
+	.mg_group_id = MGMT_GROUP_ID_LOG,
+};
+
+static size_t write_store(const void *data, size_t size)
+{
+	size_t bufsize;
+	char *buf = log_staging_acquire(&bufsize);
+	unused(size);
+
+	if (buf == NULL) {
+		metrics_increase(LogStoreDropCount);
+		return 0;
+	}
+
+	size_t len = logging_stringify(buf, bufsize, data);
+	int err = log_store_write(buf, len);
+	log_staging_release(buf);
+
+	return err == 0? len : 0;
+}
+
+static void scan_files(void)
+{
+	DIR *dir = opendir(LOG_DIR);
+	struct dirent *entry;
+	bool found = false;
+
+	store.first_file = 1;
+	store.last_file = 1;
+	store.last_file_size = 0;
+
+	if (dir == NULL) {
+		mkdir(LOG_DIR, 0755);
+		return;
+	}
+
+	while ((entry = readdir(dir)) != NULL) {
+		char *end;
+		uint32_t seq = (uint32_t)strtoul(entry->d_name, &end, 16);
+
+		if (end == entry->d_name || strcmp(end, ".lz") != 0) {
+			continue;
+		}
+		if (!found || seq < store.first_file) {
+			store.first_file = seq;
+		}
+		if (!found || seq > store.last_file) {
+			store.last_file = seq;
+		}
+		found = true;
+	}
+	closedir(dir);
+
+	if (found) {
+		char path[PATH_MAXLEN];
+		struct stat st;
+
+		get_path(path, store.last_file);
+		if (stat(path, &st) == 0) {
+			store.last_file_size = (uint32_t)st.st_size;
+		}
+	}
+}
+
+int log_store_init(void)
+{
+	static struct logging_backend log_store = {
+		.write = write_store,
+	};
+
+	esp_err_t err = esp_vfs_littlefs_register(&(esp_vfs_littlefs_conf_t) {
+		.base_path = BASE_PATH,
+		.partition_label = PARTITION_LABEL,
+		/* A failed mount may be a transient fault or a layout this
+		 * build does not know. Formatting would wipe the logs that
+		 * explain it, so the store stays off instead. */
+		.format_if_mount_failed = false,
+	});
+	if (err != ESP_OK) {
+		ESP_LOGE(TAG, "mount: %s", esp_err_to_name(err));
+		return -ENODEV;
+	}
+
+	scan_files();
+
+	store.active = &store.blocks[0];
+	store.lock = xSemaphoreCreateMutex();
+	store.io_lock = xSemaphoreCreateMutex();
+	if (store.lock == NULL || store.io_lock == NULL ||
+			xTaskCreate(store_task, "log_store",
+					STORE_TASK_STACK_SIZE, NULL,
+					STORE_TASK_PRIORITY,
+					&store.task) != pdPASS) {
+		return -ENOMEM;
+	}
+
+	mgmt_register_group(&log_mgmt_group);
+
+	return logging_add_backend(&log_store);
+}
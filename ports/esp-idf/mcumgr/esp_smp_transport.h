@@ -13,23 +13,56 @@ extern "C" {
 
 #include <stddef.h>
 #include "libmcu/mgmt_transport.h"
+#include "smp_serial.h"
+
+/** See smp_serial_framing_t. */
+typedef smp_serial_framing_t esp_smp_framing_t;
+
+#define ESP_SMP_FRAMING_CONSOLE		SMP_SERIAL_FRAMING_CONSOLE
+#define ESP_SMP_FRAMING_COBS		SMP_SERIAL_FRAMING_COBS
+#define ESP_SMP_FRAMING_AUTO		SMP_SERIAL_FRAMING_AUTO
+
+#if !defined(ESP_SMP_FRAMING_DEFAULT)
+#define ESP_SMP_FRAMING_DEFAULT		ESP_SMP_FRAMING_CONSOLE
+#endif
+
+/** Requests received and held while earlier ones are handled. A host may
+ * have this many in flight before the receiver stalls on a free slot. */
+#if !defined(ESP_SMP_RX_WINDOW)
+#define ESP_SMP_RX_WINDOW		4U
+#endif
 
 /**
  * @brief Initialise the ESP SMP transport.
  *
- * Installs the USB-JTAG (or UART) driver and starts the receive task.
+ * Installs the USB-JTAG (or UART) driver and starts the receive task and
+ * the task handing packets to @p on_recv. Up to ESP_SMP_RX_WINDOW packets
+ * queue between them, in order.
  * The physical medium is selected at compile time via CONFIG_ESP_CONSOLE_*:
  *   CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG → usb_serial_jtag driver
  *   otherwise                          → uart_vfs / stdin VFS
  *
- * @param[in] on_recv  Called for each complete decoded SMP packet.
+ * @param[in] on_recv  Called for each complete decoded SMP packet, from
+ *                     the handler task. The packet is decoded in place
+ *                     into a slot of the window and stays valid only
+ *                     until the call returns.
  * @param[in] ctx      Opaque context forwarded to @p on_recv.
  * @return 0 on success, negative errno on failure.
  */
 int esp_smp_transport_init(mgmt_transport_rx_callback_t on_recv, void *ctx);
 
 /**
- * @brief Transmit a raw SMP packet (Base64 + CRC framing applied internally).
+ * @brief Select the framing of the port.
+ *
+ * Until a request arrives, ESP_SMP_FRAMING_AUTO sends console framing.
+ *
+ * @param[in] framing Framing to use from now on.
+ * @return 0 on success, -1 on an unknown framing.
+ */
+int esp_smp_transport_set_framing(esp_smp_framing_t framing);
+
+/**
+ * @brief Transmit a raw SMP packet (framing and CRC applied internally).
  *
  * @param[in] data  SMP packet bytes.
  * @param[in] len   Packet length in bytes.
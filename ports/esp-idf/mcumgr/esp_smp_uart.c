@@ -8,231 +8,337 @@
 
 #include <stdlib.h>
 #include <string.h>
-#include <fcntl.h>
-#include <unistd.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "driver/uart.h"
 #include "driver/usb_serial_jtag.h"
 #include "driver/uart_vfs.h"
-#include "mbedtls/base64.h"
+#include "driver/usb_serial_jtag_vfs.h"
 #include "esp_log.h"
 #include "mgmt/mgmt.h"
-#include "libmcu/crc16.h"
+
+#include "libmcu/metrics.h"
+
+#include "console_sync.h"
 
 #define TAG "smp_transport"
 
-#define SMP_RX_BUF_SIZE     2048U
-#define SMP_TX_BUF_SIZE     (MGMT_MAX_MTU + MGMT_HDR_SIZE + 4U)
-#define SMP_BASE64_BUF_SIZE ((SMP_TX_BUF_SIZE * 4U / 3U) + 4U)
-#define SMP_BASE64_LINE_MAX 128U
-#define SMP_LINE_BUF_SIZE   (2U + SMP_BASE64_LINE_MAX + 1U)
+#if SMP_SERIAL_PKT_MAX < MGMT_MAX_MTU + MGMT_HDR_SIZE
+#error "SMP_SERIAL_PKT_MAX must hold a whole mgmt packet"
+#endif
+
+#define SMP_RX_TASK_STACK   4096U
+#define SMP_RX_TASK_PRIO    5U
+/* Below the receiver, so frames keep being parsed while a handler waits
+ * on flash. */
+#define SMP_MGMT_TASK_STACK 8192U
+#define SMP_MGMT_TASK_PRIO  4U
+/* Larger than the UART hardware FIFO and a USB-Serial-JTAG packet, so one
+ * read drains whatever the driver has buffered at that moment. */
+#define SMP_RX_BLOCK_SIZE   256U
 #if !CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
 #define SMP_UART_DRV_BUF    2048U
 #define SMP_UART_NUM        0
+#define SMP_UART_EVT_QLEN   16
+#define SMP_UART_PAT_QLEN   16
+/* Bound on the wait for more bytes when no event queue is available. */
+#define SMP_UART_READ_MS    10U
 #endif
 
-#define SMP_FRAME_START_1   0x06U
-#define SMP_FRAME_START_2   0x09U
-#define SMP_FRAME_CONT_1    0x04U
-#define SMP_FRAME_CONT_2    0x14U
-#define SMP_FRAME_END       0x0AU
-
-enum rx_state {
-	WAIT_HDR1,
-	WAIT_HDR2,
-	PAYLOAD,
+/* A packet waiting for the handler, and the framing to reply in. */
+struct rx_msg {
+	uint8_t                      slot;
+	uint8_t                      framing;
+	uint16_t                     len;
 };
 
 struct esp_smp_ctx {
 	mgmt_transport_rx_callback_t on_recv;
 	void                        *recv_ctx;
 	TaskHandle_t                 rx_task;
-	/* RX */
-	uint8_t                      rx_frame[SMP_RX_BUF_SIZE];
-	size_t                       rx_frame_len;
-	uint8_t                      decoded[SMP_RX_BUF_SIZE];
-	/* TX */
-	uint8_t                      tx_frame[SMP_TX_BUF_SIZE];
-	uint8_t                      tx_base64[SMP_BASE64_BUF_SIZE];
-	uint8_t                      tx_line[SMP_LINE_BUF_SIZE];
+	TaskHandle_t                 mgmt_task;
+	QueueHandle_t                free_q;
+	QueueHandle_t                ready_q;
+	uint32_t                     inflight;
+	/* Console lines of the frame being sent are still in stdio. */
+	bool                         console_unflushed;
+	/* A binary frame is being written, with the console held. */
+	bool                         console_held;
+#if !CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+	QueueHandle_t                uart_events;
+#endif
+	struct smp_serial            serial;
+	/* Counters of the framing already added to metrics. */
+	struct smp_serial_stats      reported;
+	uint8_t                      rx_block[SMP_RX_BLOCK_SIZE];
+	/* Packets are decoded in place into a leased slot, which is handed
+	 * to the handler task as is and comes back once handled. */
+	uint8_t                      rx_slot[ESP_SMP_RX_WINDOW]
+	                                    [SMP_SERIAL_BUF_SIZE];
 };
 
 static struct esp_smp_ctx s_ctx;
 
-static int phy_write(const uint8_t *data, size_t len)
+static int write_driver(const void *data, size_t len)
 {
 #if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
-	int n = usb_serial_jtag_write_bytes(data, len, portMAX_DELAY);
+	return usb_serial_jtag_write_bytes(data, len, portMAX_DELAY);
 #else
-	int n = uart_write_bytes((uart_port_t)SMP_UART_NUM,
-			(const char *)data, len);
+	return uart_write_bytes((uart_port_t)SMP_UART_NUM, data, len);
 #endif
-	return (n == (int)len) ? 0 : -1;
 }
 
-int esp_smp_transport_send(const void *data, size_t len)
+/* Binary frames go to the driver rather than stdio, whose line-ending
+ * translation would corrupt them. A frame comes in several writes, from
+ * the one opening with the delimiter to the one closing with it, and the
+ * console is held in between so that no log line lands inside it.
+ * Console lines go through the console lock, in between log lines. */
+static int write_phy(const void *data, size_t len,
+		smp_serial_framing_t framing, void *arg)
 {
-	struct esp_smp_ctx *ctx = &s_ctx;
+	struct esp_smp_ctx *ctx = (struct esp_smp_ctx *)arg;
+	const uint8_t *p = (const uint8_t *)data;
 
-	if (len > MGMT_MAX_MTU + MGMT_HDR_SIZE) {
-		return -1;
+	if (framing == SMP_SERIAL_FRAMING_CONSOLE) {
+		ctx->console_unflushed = true;
+		return console_sync_write(data, len);
+	}
+
+	if (len > 0 && p[0] == 0 && !ctx->console_held) {
+		console_sync_lock();
+		ctx->console_held = true;
 	}
 
-	/* Raw frame: [len_hi][len_lo][payload...][crc_hi][crc_lo] */
-	ctx->tx_frame[0] = (uint8_t)(len >> 8);
-	ctx->tx_frame[1] = (uint8_t)(len & 0xFFU);
-	memcpy(ctx->tx_frame + 2, data, len);
-	uint16_t crc = crc16_xmodem(data, len);
-	ctx->tx_frame[2 + len]     = (uint8_t)(crc >> 8);
-	ctx->tx_frame[2 + len + 1] = (uint8_t)(crc & 0xFFU);
-
-	size_t total_raw = 2U + len + 2U;
-	size_t base64_len = 0;
-	mbedtls_base64_encode(ctx->tx_base64, sizeof(ctx->tx_base64),
-			&base64_len, ctx->tx_frame, total_raw);
-
-	size_t offset = 0;
-	bool first = true;
-	while (offset < base64_len) {
-		size_t chunk = base64_len - offset;
-		if (chunk > SMP_BASE64_LINE_MAX) {
-			chunk = SMP_BASE64_LINE_MAX;
+	const int rc = write_driver(data, len);
+
+	if (len > 0 && p[len - 1] == 0 && ctx->console_held) {
+		ctx->console_held = false;
+		console_sync_unlock();
+	}
+
+	return rc;
+}
+
+/* Waits for a free slot. Time spent here is time the host has more
+ * requests in flight than the device can hold. */
+static uint8_t *lease_slot(void *arg)
+{
+	struct esp_smp_ctx *ctx = (struct esp_smp_ctx *)arg;
+	uint8_t slot;
+
+	if (xQueueReceive(ctx->free_q, &slot, 0) != pdTRUE) {
+		const TickType_t t0 = xTaskGetTickCount();
+		xQueueReceive(ctx->free_q, &slot, portMAX_DELAY);
+		metrics_increase_by(SMPRxStallTime, (int32_t)
+			((xTaskGetTickCount() - t0) * portTICK_PERIOD_MS));
+	}
+
+	return ctx->rx_slot[slot];
+}
+
+/* Hands the leased slot over to the handler task and returns to parsing
+ * right away, so the host may send the next request before the reply to
+ * this one. Requests are handled in order. */
+static void deliver(uint8_t *buf, size_t len, smp_serial_framing_t framing,
+		void *arg)
+{
+	struct esp_smp_ctx *ctx = (struct esp_smp_ctx *)arg;
+	const struct rx_msg msg = {
+		.slot = (uint8_t)((size_t)(buf - ctx->rx_slot[0]) /
+				SMP_SERIAL_BUF_SIZE),
+		.framing = (uint8_t)framing,
+		.len = (uint16_t)len,
+	};
+
+	const uint32_t window = __atomic_add_fetch(&ctx->inflight, 1,
+			__ATOMIC_RELAXED);
+	metrics_set_if_max(SMPWindowMax, (int32_t)window);
+	metrics_increase(SMPRxCount);
+
+	xQueueSend(ctx->ready_q, &msg, portMAX_DELAY);
+}
+
+static const struct smp_serial_ops serial_ops = {
+	.write = write_phy,
+	.lease = lease_slot,
+	.deliver = deliver,
+};
+
+static void mgmt_task(void *param)
+{
+	struct esp_smp_ctx *ctx = (struct esp_smp_ctx *)param;
+	struct rx_msg msg;
+
+	while (1) {
+		if (xQueueReceive(ctx->ready_q, &msg, portMAX_DELAY) != pdTRUE) {
+			continue;
 		}
-		size_t line_len = 0;
-		ctx->tx_line[line_len++] = first ? SMP_FRAME_START_1 : SMP_FRAME_CONT_1;
-		ctx->tx_line[line_len++] = first ? SMP_FRAME_START_2 : SMP_FRAME_CONT_2;
-		memcpy(ctx->tx_line + line_len, ctx->tx_base64 + offset, chunk);
-		line_len += chunk;
-		ctx->tx_line[line_len++] = SMP_FRAME_END;
-		if (phy_write(ctx->tx_line, line_len) != 0) {
-			return -1;
+
+		smp_serial_set_reply_framing(&ctx->serial,
+				(smp_serial_framing_t)msg.framing);
+
+		if (ctx->on_recv) {
+			ctx->on_recv(ctx->rx_slot[msg.slot], msg.len,
+					ctx->recv_ctx);
 		}
-		first = false;
-		offset += chunk;
+
+		__atomic_sub_fetch(&ctx->inflight, 1, __ATOMIC_RELAXED);
+		xQueueSend(ctx->free_q, &msg.slot, 0);
 	}
-	return 0;
 }
 
-static bool process_rx_frame(struct esp_smp_ctx *ctx)
+int esp_smp_transport_send(const void *data, size_t len)
 {
-	if (ctx->rx_frame_len == 0U || (ctx->rx_frame_len & 0x3U) != 0U) {
-		return false;
+	const int rc = smp_serial_send(&s_ctx.serial, data, len);
+
+	/* A write that failed may have left a binary frame open. */
+	if (s_ctx.console_held) {
+		s_ctx.console_held = false;
+		console_sync_unlock();
 	}
 
-	size_t decoded_len = 0;
-	int ret = mbedtls_base64_decode(ctx->decoded, sizeof(ctx->decoded),
-			&decoded_len, ctx->rx_frame, ctx->rx_frame_len);
-	if (ret != 0 || decoded_len < 4U) {
-		return false;
+	/* Under the watermark and periodic policies the lines of a reply
+	 * would sit in stdio until some later log line pushed them out. The
+	 * host waits on the whole frame, so it goes out as soon as it ends. */
+	if (s_ctx.console_unflushed) {
+		s_ctx.console_unflushed = false;
+		console_sync_flush();
 	}
 
-	uint16_t pkt_len = ((uint16_t)ctx->decoded[0] << 8) | ctx->decoded[1];
-	if (decoded_len < (size_t)pkt_len + 2U) {
-		/* Partial packet — continuation frames still pending. */
-		return false;
+	return rc;
+}
+
+int esp_smp_transport_set_framing(esp_smp_framing_t framing)
+{
+	return smp_serial_set_framing(&s_ctx.serial, framing);
+}
+
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+static int read_block(struct esp_smp_ctx *ctx)
+{
+	/* Returns as soon as anything is in the driver ring buffer. */
+	return usb_serial_jtag_read_bytes(ctx->rx_block,
+			sizeof(ctx->rx_block), portMAX_DELAY);
+}
+#else
+static int read_block(struct esp_smp_ctx *ctx)
+{
+	const uart_port_t port = (uart_port_t)SMP_UART_NUM;
+	uart_event_t evt;
+	size_t avail = 0;
+
+	if (ctx->uart_events == NULL) {
+		return uart_read_bytes(port, ctx->rx_block,
+				sizeof(ctx->rx_block),
+				pdMS_TO_TICKS(SMP_UART_READ_MS));
 	}
-	if (decoded_len != (size_t)pkt_len + 2U) {
-		ctx->rx_frame_len = 0;
-		return false;
+
+	/* Data events fire on FIFO thresholds and RX timeouts, and the
+	 * pattern event right on a frame terminator, so a complete line is
+	 * handled without waiting for the RX timeout. */
+	if (xQueueReceive(ctx->uart_events, &evt, portMAX_DELAY) != pdTRUE) {
+		return 0;
 	}
 
-	const uint8_t *pkt_data = ctx->decoded + 2;
-	if (crc16_xmodem(pkt_data, pkt_len) != 0U) {
-		ESP_LOGE(TAG, "CRC mismatch");
-		ctx->rx_frame_len = 0;
-		return true;
+	switch (evt.type) {
+	case UART_PATTERN_DET:
+		(void)uart_pattern_pop_pos(port);
+		break;
+	case UART_DATA:
+		break;
+	case UART_FIFO_OVF: /* fall through */
+	case UART_BUFFER_FULL:
+		ESP_LOGE(TAG, "rx overflow");
+		uart_flush_input(port);
+		xQueueReset(ctx->uart_events);
+		smp_serial_reset(&ctx->serial);
+		return 0;
+	default:
+		return 0;
 	}
 
-	if (pkt_len < 2U) {
-		ctx->rx_frame_len = 0;
-		return true;
+	if (uart_get_buffered_data_len(port, &avail) != ESP_OK || avail == 0) {
+		return 0;
 	}
 
-	if (ctx->on_recv) {
-		ctx->on_recv(pkt_data, pkt_len - 2U, ctx->recv_ctx);
+	return uart_read_bytes(port, ctx->rx_block,
+			(avail < sizeof(ctx->rx_block))?
+				(uint32_t)avail : sizeof(ctx->rx_block), 0);
+}
+#endif
+
+/* The framing keeps its own counters, which go to metrics as they move.
+ * Only the receive task feeds the framing, so it alone reads them. */
+static void report_rx_errors(struct esp_smp_ctx *ctx)
+{
+	struct smp_serial_stats now;
+
+	smp_serial_get_stats(&ctx->serial, &now);
+
+	if (now.crc_errors != ctx->reported.crc_errors) {
+		metrics_increase_by(SMPRxCRCErrorCount, (int32_t)
+				(now.crc_errors - ctx->reported.crc_errors));
+	}
+	if (now.malformed != ctx->reported.malformed) {
+		metrics_increase_by(SMPRxMalformedCount, (int32_t)
+				(now.malformed - ctx->reported.malformed));
+	}
+	if (now.dropped != ctx->reported.dropped) {
+		metrics_increase_by(SMPRxDropCount, (int32_t)
+				(now.dropped - ctx->reported.dropped));
 	}
 
-	ctx->rx_frame_len = 0;
-	return true;
+	ctx->reported = now;
 }
 
 static void rx_task(void *param)
 {
 	struct esp_smp_ctx *ctx = (struct esp_smp_ctx *)param;
-	uint8_t byte;
-	enum rx_state state = WAIT_HDR1;
-	uint8_t expected_hdr2 = 0;
-	bool line_is_start = false;
-#if !CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
-	const int stdin_fd = fileno(stdin);
-#endif
 
 	while (1) {
-		int rc;
-#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
-		rc = usb_serial_jtag_read_bytes(&byte, 1, portMAX_DELAY);
-#else
-		rc = read(stdin_fd, &byte, 1);
-#endif
-		if (rc != 1) {
-			continue;
-		}
+		const int rc = read_block(ctx);
 
-		switch (state) {
-		case WAIT_HDR1:
-			if (byte == SMP_FRAME_START_1) {
-				expected_hdr2 = SMP_FRAME_START_2;
-				line_is_start = true;
-				state = WAIT_HDR2;
-			} else if (byte == SMP_FRAME_CONT_1) {
-				expected_hdr2 = SMP_FRAME_CONT_2;
-				line_is_start = false;
-				state = WAIT_HDR2;
-			}
-			break;
-
-		case WAIT_HDR2:
-			if (byte == expected_hdr2) {
-				if (line_is_start) {
-					ctx->rx_frame_len = 0;
-				} else if (ctx->rx_frame_len == 0U) {
-					state = WAIT_HDR1;
-					break;
-				}
-				state = PAYLOAD;
-			} else {
-				state = WAIT_HDR1;
-			}
-			break;
-
-		case PAYLOAD:
-			if (byte == SMP_FRAME_END) {
-				(void)process_rx_frame(ctx);
-				state = WAIT_HDR1;
-				break;
-			}
-			if (ctx->rx_frame_len < sizeof(ctx->rx_frame)) {
-				ctx->rx_frame[ctx->rx_frame_len++] = byte;
-			} else {
-				ESP_LOGE(TAG, "frame overflow");
-				ctx->rx_frame_len = 0;
-				state = WAIT_HDR1;
-			}
-			break;
-
-		default:
-			state = WAIT_HDR1;
-			break;
+		if (rc > 0) {
+			smp_serial_feed(&ctx->serial, ctx->rx_block,
+					(size_t)rc);
+			report_rx_errors(ctx);
 		}
 	}
 }
 
+static int create_pipeline(struct esp_smp_ctx *ctx)
+{
+	ctx->inflight = 0;
+	ctx->free_q = xQueueCreate(ESP_SMP_RX_WINDOW, sizeof(uint8_t));
+	ctx->ready_q = xQueueCreate(ESP_SMP_RX_WINDOW, sizeof(struct rx_msg));
+
+	if (ctx->free_q == NULL || ctx->ready_q == NULL) {
+		return -1;
+	}
+
+	for (uint8_t i = 0; i < ESP_SMP_RX_WINDOW; i++) {
+		xQueueSend(ctx->free_q, &i, 0);
+	}
+
+	if (xTaskCreate(mgmt_task, "smp_mgmt", SMP_MGMT_TASK_STACK, ctx,
+			SMP_MGMT_TASK_PRIO, &ctx->mgmt_task) != pdPASS ||
+			xTaskCreate(rx_task, "smp_rx", SMP_RX_TASK_STACK, ctx,
+			SMP_RX_TASK_PRIO, &ctx->rx_task) != pdPASS) {
+		return -1;
+	}
+
+	return 0;
+}
+
 int esp_smp_transport_init(mgmt_transport_rx_callback_t on_recv, void *ctx)
 {
 	s_ctx.on_recv  = on_recv;
 	s_ctx.recv_ctx = ctx;
+	smp_serial_init(&s_ctx.serial, &serial_ops, &s_ctx);
+	s_ctx.reported = (struct smp_serial_stats) { 0, };
+	smp_serial_set_framing(&s_ctx.serial, ESP_SMP_FRAMING_DEFAULT);
 
 #if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
 	if (!usb_serial_jtag_is_driver_installed()) {
@@ -245,26 +351,39 @@ int esp_smp_transport_init(mgmt_transport_rx_callback_t on_recv, void *ctx)
 			return -1;
 		}
 	}
+	usb_serial_jtag_vfs_use_driver();
+	/* Console frames go out through stdio, where the default CRLF
+	 * translation would turn every frame terminator into "\r\n". */
+	usb_serial_jtag_vfs_set_rx_line_endings(ESP_LINE_ENDINGS_LF);
+	usb_serial_jtag_vfs_set_tx_line_endings(ESP_LINE_ENDINGS_LF);
 #else
+	/* A driver installed by someone else comes without our event
+	 * queue, in which case reads fall back to a bounded wait. */
 	if (!uart_is_driver_installed((uart_port_t)SMP_UART_NUM)) {
 		esp_err_t err = uart_driver_install((uart_port_t)SMP_UART_NUM,
-				SMP_UART_DRV_BUF, SMP_UART_DRV_BUF, 0, NULL, 0);
+				SMP_UART_DRV_BUF, SMP_UART_DRV_BUF,
+				SMP_UART_EVT_QLEN, &s_ctx.uart_events, 0);
 		if (err != ESP_OK) {
 			ESP_LOGE(TAG, "uart_driver_install: %s",
 					esp_err_to_name(err));
 			return -1;
 		}
+		uart_enable_pattern_det_baud_intr((uart_port_t)SMP_UART_NUM,
+				(char)SMP_SERIAL_LINE_END, 1, 9, 0, 0);
+		uart_pattern_queue_reset((uart_port_t)SMP_UART_NUM,
+				SMP_UART_PAT_QLEN);
 	}
 	uart_vfs_dev_use_driver(SMP_UART_NUM);
-	int flags = fcntl(fileno(stdin), F_GETFL, 0);
-	if (flags >= 0 && (flags & O_NONBLOCK)) {
-		fcntl(fileno(stdin), F_SETFL, flags & ~O_NONBLOCK);
-	}
 	uart_vfs_dev_port_set_rx_line_endings(SMP_UART_NUM, ESP_LINE_ENDINGS_LF);
 	uart_vfs_dev_port_set_tx_line_endings(SMP_UART_NUM, ESP_LINE_ENDINGS_LF);
 #endif
 
-	xTaskCreate(rx_task, "smp_rx", 8192, &s_ctx, 5, &s_ctx.rx_task);
+	if (create_pipeline(&s_ctx) != 0) {
+		ESP_LOGE(TAG, "out of memory");
+		esp_smp_transport_deinit();
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -274,4 +393,16 @@ void esp_smp_transport_deinit(void)
 		vTaskDelete(s_ctx.rx_task);
 		s_ctx.rx_task = NULL;
 	}
+	if (s_ctx.mgmt_task) {
+		vTaskDelete(s_ctx.mgmt_task);
+		s_ctx.mgmt_task = NULL;
+	}
+	if (s_ctx.free_q) {
+		vQueueDelete(s_ctx.free_q);
+		s_ctx.free_q = NULL;
+	}
+	if (s_ctx.ready_q) {
+		vQueueDelete(s_ctx.ready_q);
+		s_ctx.ready_q = NULL;
+	}
 }
@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "timebase.h"
+#include "esp_timer.h"
+
+/* esp_cpu_get_cycle_count() is per core and changes rate with dynamic
+ * frequency scaling, so it cannot order records logged from both cores.
+ * esp_timer is 64-bit, shared and keeps counting in light sleep. */
+
+int timebase_init(void)
+{
+	return 0;
+}
+
+uint64_t timebase_get_ticks(void)
+{
+	return (uint64_t)esp_timer_get_time();
+}
+
+uint32_t timebase_get_frequency(void)
+{
+	return 1000000U;
+}
@@ -189,6 +189,12 @@ standard names - or at least those used in the unmodified vector table. */
         #include <stdint.h>
         extern uint32_t SystemCoreClock;
     #endif
+
+    /* Keep the DWT-based timebase counting across tickless idle. */
+    void timebase_enter_sleep(void);
+    void timebase_exit_sleep(void);
+    #define configPRE_SLEEP_PROCESSING(x)   timebase_enter_sleep()
+    #define configPOST_SLEEP_PROCESSING(x)  timebase_exit_sleep()
 #endif /* !assembler */
 
 /** Implementation note:  Use this with caution and set this to 1 ONLY for debugging
@@ -0,0 +1,97 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "console_emerg.h"
+
+#include <stdint.h>
+
+#include "app_error.h"
+#include "nrf_strerror.h"
+#include "nrf.h"
+
+#include "libmcu/assert.h"
+#include "libmcu/fault.h"
+
+static void halt(void)
+{
+	NRF_BREAKPOINT_COND;
+
+#if !defined(DEBUG)
+	NVIC_SystemReset();
+#else
+	for (;;) {
+		__WFE();
+	}
+#endif
+}
+
+/* Replaces the weak hook of libmcu's armcm assert.c. The console lock
+ * may be held by the task that asserted, so only the emergency path is
+ * used. */
+void libmcu_assertion_failed(const uintptr_t *pc, const uintptr_t *lr)
+{
+	__disable_irq();
+	console_emerg_panic();
+	console_emerg_printf("ASSERTION FAILED PC 0x%08lx LR 0x%08lx\n",
+			(unsigned long)(uintptr_t)pc,
+			(unsigned long)(uintptr_t)lr);
+	halt();
+}
+
+/* Replaces the weak hook libmcu's armcm fault.c calls from the hard fault
+ * handler. The fault status is written out before the handler goes on to
+ * report and reset. */
+void fault_save(const struct fault_context *ctx)
+{
+	(void)ctx;
+
+	__disable_irq();
+	console_emerg_panic();
+	console_emerg_printf("HARD FAULT CFSR 0x%08lx HFSR 0x%08lx "
+			"MMFAR 0x%08lx BFAR 0x%08lx\n",
+			(unsigned long)SCB->CFSR, (unsigned long)SCB->HFSR,
+			(unsigned long)SCB->MMFAR, (unsigned long)SCB->BFAR);
+}
+
+/* Replaces the weak handler of the SDK, which reports through NRF_LOG. It
+ * may run in any context with the console lock held by whoever was
+ * interrupted, so only the emergency path is used. */
+void app_error_fault_handler(uint32_t id, uint32_t pc, uint32_t info)
+{
+	__disable_irq();
+	console_emerg_panic();
+
+	switch (id) {
+	case NRF_FAULT_ID_SDK_ASSERT: {
+		const assert_info_t *p = (const assert_info_t *)(uintptr_t)info;
+		console_emerg_printf("ASSERTION FAILED at %s:%lu\n",
+				(const char *)p->p_file_name,
+				(unsigned long)p->line_num);
+		break;
+	}
+	case NRF_FAULT_ID_SDK_ERROR: {
+		const error_info_t *p = (const error_info_t *)(uintptr_t)info;
+		console_emerg_printf("ERROR %lu [%s] at %s:%lu PC 0x%08lx\n",
+				(unsigned long)p->err_code,
+				nrf_strerror_get(p->err_code),
+				(const char *)p->p_file_name,
+				(unsigned long)p->line_num,
+				(unsigned long)pc);
+		break;
+	}
+	default:
+		console_emerg_printf("FAULT 0x%08lx at 0x%08lx\n",
+				(unsigned long)id, (unsigned long)pc);
+		break;
+	}
+
+#if !defined(DEBUG)
+	halt();
+#else
+	NRF_BREAKPOINT_COND;
+	app_error_save_and_stop(id, pc, info);
+#endif
+}
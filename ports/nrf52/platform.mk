@@ -94,7 +94,8 @@ NRF_SRCS = \
 	\
 	$(SDK_ROOT)/components/ble/ble_services/ble_nus/ble_nus.c \
 	\
-	$(wildcard $(PORT_ROOT)/*.c) \
+	$(filter-out $(PORT_ROOT)/smp_ble.c $(PORT_ROOT)/smp_uart.c, \
+		$(wildcard $(PORT_ROOT)/*.c)) \
 	$(wildcard $(PORT_ROOT)/*.cpp) \
 	\
 	$(LIBMCU_ROOT)/ports/freertos/board.c \
@@ -181,6 +182,41 @@ NRF_DEFS = \
 	__STACK_SIZE=8192 \
 	_POSIX_C_SOURCE=200809L \
 
+# SMP over BLE GATT is opt-in. Build with SMP_BLE=1 to enable it.
+ifeq ($(SMP_BLE), 1)
+NRF_SRCS += $(PORT_ROOT)/smp_ble.c
+NRF_DEFS += SMP_BLE
+endif
+
+# SMP over UARTE1 is opt-in. Build with SMP_UART=1 to enable it.
+ifeq ($(SMP_UART), 1)
+NRF_SRCS += \
+	$(SDK_ROOT)/components/libraries/libuarte/nrf_libuarte_async.c \
+	$(SDK_ROOT)/components/libraries/libuarte/nrf_libuarte_drv.c \
+	$(SDK_ROOT)/components/libraries/queue/nrf_queue.c \
+	$(SDK_ROOT)/modules/nrfx/drivers/src/nrfx_timer.c \
+	$(PORT_ROOT)/smp_uart.c \
+
+NRF_INCS += \
+	$(SDK_ROOT)/components/libraries/libuarte \
+	$(SDK_ROOT)/components/libraries/queue \
+
+NRF_DEFS += \
+	SMP_UART \
+	PPI_ENABLED=1 \
+	TIMER_ENABLED=1 \
+	TIMER1_ENABLED=1 \
+	RTC2_ENABLED=1 \
+	NRFX_PPI_ENABLED=1 \
+	NRFX_TIMER_ENABLED=1 \
+	NRFX_TIMER1_ENABLED=1 \
+	NRFX_RTC_ENABLED=1 \
+	NRFX_RTC2_ENABLED=1 \
+	NRF_QUEUE_ENABLED=1 \
+	NRF_LIBUARTE_DRV_UARTE1=1 \
+
+endif
+
 $(addprefix $(OUTDIR)/, $(NRF_SRCS:%=%.o)): CFLAGS+=-Wno-error
 
 INCS += $(NRF_INCS)
@@ -0,0 +1,544 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "smp_ble.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "ble.h"
+#include "ble_advertising.h"
+#include "ble_srv_common.h"
+#include "nrf_ble_gatt.h"
+#include "nrf_sdh_ble.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "libmcu/metrics.h"
+
+#include "smp_frag.h"
+
+#define SMP_BLE_CONN_CFG_TAG		1
+#define SMP_BLE_OBSERVER_PRIO		3
+#define SMP_BLE_TASK_STACK_SIZE		4096U
+#define SMP_BLE_TASK_PRIORITY		2U
+/* A notification that is not acknowledged within a few supervision
+ * timeouts never will be. */
+#define SMP_BLE_TX_TIMEOUT_MS		10000U
+
+#define ATT_NOTIFY_HDR_SIZE		3U
+
+/* 7.5 to 15 ms with no latency. The shorter, the more connection events
+ * per second to carry notifications in. */
+#define CONN_INTERVAL_MIN		6U
+#define CONN_INTERVAL_MAX		12U
+#define CONN_SUP_TIMEOUT		400U
+#define ADV_INTERVAL			64U
+
+/* 8D53DC1D-1DB7-4CD3-868B-8A527460AA84, little-endian. Bytes 12 and 13
+ * are the 16-bit part. */
+#define SMP_SERVICE_UUID_BASE		{ 0x84, 0xAA, 0x60, 0x74, 0x52, 0x8A, \
+		0x8B, 0x86, 0xD3, 0x4C, 0xB7, 0x1D, 0x00, 0x00, 0x53, 0x8D }
+#define SMP_SERVICE_UUID		0xDC1DU
+/* DA2E7828-FBCE-4E01-AE9E-261174997C48 */
+#define SMP_CHAR_UUID_BASE		{ 0x48, 0x7C, 0x99, 0x74, 0x11, 0x26, \
+		0x9E, 0xAE, 0x01, 0x4E, 0xCE, 0xFB, 0x00, 0x00, 0x2E, 0xDA }
+#define SMP_CHAR_UUID			0x7828U
+
+struct rx_msg {
+	uint8_t idx;
+	uint16_t len;
+};
+
+struct smp_ble_ctx {
+	mgmt_transport_rx_callback_t on_recv;
+	void *on_recv_ctx;
+
+	TaskHandle_t task;
+	QueueHandle_t free_q;
+	QueueHandle_t ready_q;
+	SemaphoreHandle_t tx_lock;
+	SemaphoreHandle_t tx_done;
+
+	ble_uuid_t service_uuid;
+	uint16_t service_handle;
+	ble_gatts_char_handles_t char_handles;
+
+	uint16_t conn_handle;
+	uint16_t payload_max;
+
+	/* Fragments are reassembled in place and the packet is copied to a
+	 * free slot once complete, so a packet arriving while every slot is
+	 * busy is dropped as a whole without losing track of the next. */
+	struct smp_reasm reasm;
+	uint8_t reasm_buf[SMP_BLE_RX_BUF_SIZE];
+	uint8_t rx_buf[SMP_BLE_RX_BUF_COUNT][SMP_BLE_RX_BUF_SIZE];
+
+	bool enabled;
+	bool active;
+};
+
+NRF_BLE_GATT_DEF(m_gatt);
+BLE_ADVERTISING_DEF(m_adv);
+
+static struct smp_ble_ctx m_ctx = {
+	.conn_handle = BLE_CONN_HANDLE_INVALID,
+};
+
+static uint16_t get_conn_handle(void)
+{
+	return __atomic_load_n(&m_ctx.conn_handle, __ATOMIC_ACQUIRE);
+}
+
+static void on_write(const uint8_t *data, size_t len)
+{
+	const int rc = smp_reasm_feed(&m_ctx.reasm, data, len);
+
+	if (rc < 0) {
+		metrics_increase(SMPRxDropCount);
+		return;
+	} else if (rc == 0) {
+		return;
+	}
+
+	struct rx_msg msg = { .len = (uint16_t)rc };
+
+	if (xQueueReceive(m_ctx.free_q, &msg.idx, 0) != pdTRUE) {
+		/* The peer times out and retries. Reset now rather than on the
+		 * next write so the buffer never holds a stale packet. */
+		smp_reasm_reset(&m_ctx.reasm);
+		metrics_increase(SMPRxDropCount);
+		return;
+	}
+
+	memcpy(m_ctx.rx_buf[msg.idx], m_ctx.reasm_buf, msg.len);
+	smp_reasm_reset(&m_ctx.reasm);
+	xQueueSend(m_ctx.ready_q, &msg, 0);
+}
+
+static void on_connected(const ble_gap_evt_t *evt)
+{
+	const ble_gap_phys_t phys = {
+		.tx_phys = BLE_GAP_PHY_2MBPS,
+		.rx_phys = BLE_GAP_PHY_2MBPS,
+	};
+
+	smp_reasm_reset(&m_ctx.reasm);
+	__atomic_store_n(&m_ctx.payload_max,
+			(uint16_t)(BLE_GATT_ATT_MTU_DEFAULT - ATT_NOTIFY_HDR_SIZE),
+			__ATOMIC_RELAXED);
+	__atomic_store_n(&m_ctx.conn_handle, evt->conn_handle,
+			__ATOMIC_RELEASE);
+
+	/* Twice the air rate, if the peer supports it. */
+	(void)sd_ble_gap_phy_update(evt->conn_handle, &phys);
+}
+
+static void on_disconnected(void)
+{
+	__atomic_store_n(&m_ctx.conn_handle, BLE_CONN_HANDLE_INVALID,
+			__ATOMIC_RELEASE);
+	smp_reasm_reset(&m_ctx.reasm);
+	/* Wakes a sender waiting for room in the notification queue. */
+	xSemaphoreGive(m_ctx.tx_done);
+
+	(void)ble_advertising_start(&m_adv, BLE_ADV_MODE_FAST);
+}
+
+static void on_ble_evt(ble_evt_t const *evt, void *ctx)
+{
+	(void)ctx;
+
+	if (!m_ctx.active) {
+		return;
+	}
+
+	switch (evt->header.evt_id) {
+	case BLE_GAP_EVT_CONNECTED:
+		on_connected(&evt->evt.gap_evt);
+		break;
+	case BLE_GAP_EVT_DISCONNECTED:
+		on_disconnected();
+		break;
+	case BLE_GAP_EVT_PHY_UPDATE_REQUEST: {
+		const ble_gap_phys_t phys = {
+			.tx_phys = BLE_GAP_PHY_AUTO,
+			.rx_phys = BLE_GAP_PHY_AUTO,
+		};
+		(void)sd_ble_gap_phy_update(evt->evt.gap_evt.conn_handle,
+				&phys);
+		break;
+	}
+	case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
+		(void)sd_ble_gap_sec_params_reply(evt->evt.gap_evt.conn_handle,
+				BLE_GAP_SEC_STATUS_PAIRING_NOT_SUPP,
+				NULL, NULL);
+		break;
+	case BLE_GATTS_EVT_SYS_ATTR_MISSING:
+		(void)sd_ble_gatts_sys_attr_set(evt->evt.gatts_evt.conn_handle,
+				NULL, 0, 0);
+		break;
+	case BLE_GATTS_EVT_WRITE: {
+		const ble_gatts_evt_write_t *p = &evt->evt.gatts_evt.params.write;
+		if (p->handle == m_ctx.char_handles.value_handle) {
+			on_write(p->data, p->len);
+		}
+		break;
+	}
+	case BLE_GATTS_EVT_HVN_TX_COMPLETE:
+		xSemaphoreGive(m_ctx.tx_done);
+		break;
+	case BLE_GATTC_EVT_TIMEOUT:
+		(void)sd_ble_gap_disconnect(evt->evt.gattc_evt.conn_handle,
+				BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+		break;
+	case BLE_GATTS_EVT_TIMEOUT:
+		(void)sd_ble_gap_disconnect(evt->evt.gatts_evt.conn_handle,
+				BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+		break;
+	default:
+		break;
+	}
+}
+
+NRF_SDH_BLE_OBSERVER(m_smp_ble_obs, SMP_BLE_OBSERVER_PRIO, on_ble_evt, NULL);
+
+static void on_gatt_evt(nrf_ble_gatt_t *gatt, nrf_ble_gatt_evt_t const *evt)
+{
+	(void)gatt;
+
+	if (evt->evt_id == NRF_BLE_GATT_EVT_ATT_MTU_UPDATED &&
+			evt->conn_handle == get_conn_handle()) {
+		__atomic_store_n(&m_ctx.payload_max, (uint16_t)
+				(evt->params.att_mtu_effective -
+				ATT_NOTIFY_HDR_SIZE), __ATOMIC_RELAXED);
+	}
+}
+
+static void on_adv_evt(ble_adv_evt_t evt)
+{
+	(void)evt;
+}
+
+static void rx_task(void *arg)
+{
+	(void)arg;
+
+	struct rx_msg msg;
+
+	for (;;) {
+		if (xQueueReceive(m_ctx.ready_q, &msg, portMAX_DELAY)
+				!= pdTRUE) {
+			continue;
+		}
+
+		m_ctx.on_recv(m_ctx.rx_buf[msg.idx], msg.len,
+				m_ctx.on_recv_ctx);
+		xQueueSend(m_ctx.free_q, &msg.idx, 0);
+	}
+}
+
+static int enable_stack(void)
+{
+	uint32_t ram_start = 0;
+	ble_cfg_t cfg;
+
+	if (nrf_sdh_ble_default_cfg_set(SMP_BLE_CONN_CFG_TAG, &ram_start)
+			!= NRF_SUCCESS) {
+		return -EIO;
+	}
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.conn_cfg.conn_cfg_tag = SMP_BLE_CONN_CFG_TAG;
+	cfg.conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size =
+		SMP_BLE_HVN_TX_QUEUE_SIZE;
+	if (sd_ble_cfg_set(BLE_CONN_CFG_GATTS, &cfg, ram_start)
+			!= NRF_SUCCESS) {
+		return -EIO;
+	}
+
+	if (nrf_sdh_ble_enable(&ram_start) != NRF_SUCCESS) {
+		return -ENOMEM; /* RAM start in the linker script too low */
+	}
+
+	/* Lets a connection event run on for as long as there is data and
+	 * no other radio activity, instead of one packet pair per event. */
+	ble_opt_t opt;
+	memset(&opt, 0, sizeof(opt));
+	opt.common_opt.conn_evt_ext.enable = 1;
+	if (sd_ble_opt_set(BLE_COMMON_OPT_CONN_EVT_EXT, &opt) != NRF_SUCCESS) {
+		return -EIO;
+	}
+
+	if (nrf_ble_gatt_init(&m_gatt, on_gatt_evt) != NRF_SUCCESS ||
+			nrf_ble_gatt_att_mtu_periph_set(&m_gatt,
+				NRF_SDH_BLE_GATT_MAX_MTU_SIZE) != NRF_SUCCESS) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int setup_gap(void)
+{
+	ble_gap_conn_sec_mode_t sec_mode;
+	const ble_gap_conn_params_t conn_params = {
+		.min_conn_interval = CONN_INTERVAL_MIN,
+		.max_conn_interval = CONN_INTERVAL_MAX,
+		.slave_latency = 0,
+		.conn_sup_timeout = CONN_SUP_TIMEOUT,
+	};
+
+	BLE_GAP_CONN_SEC_MODE_SET_OPEN(&sec_mode);
+
+	if (sd_ble_gap_device_name_set(&sec_mode,
+			(const uint8_t *)SMP_BLE_DEVICE_NAME,
+			(uint16_t)strlen(SMP_BLE_DEVICE_NAME)) != NRF_SUCCESS ||
+			sd_ble_gap_ppcp_set(&conn_params) != NRF_SUCCESS) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int add_service(void)
+{
+	ble_uuid128_t service_base = { .uuid128 = SMP_SERVICE_UUID_BASE };
+	ble_uuid128_t char_base = { .uuid128 = SMP_CHAR_UUID_BASE };
+	uint8_t char_type;
+
+	m_ctx.service_uuid.uuid = SMP_SERVICE_UUID;
+
+	if (sd_ble_uuid_vs_add(&service_base, &m_ctx.service_uuid.type)
+			!= NRF_SUCCESS ||
+			sd_ble_uuid_vs_add(&char_base, &char_type)
+			!= NRF_SUCCESS) {
+		return -EIO;
+	}
+
+	if (sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY,
+			&m_ctx.service_uuid, &m_ctx.service_handle)
+			!= NRF_SUCCESS) {
+		return -EIO;
+	}
+
+	ble_add_char_params_t params = {
+		.uuid = SMP_CHAR_UUID,
+		.uuid_type = char_type,
+		.max_len = NRF_SDH_BLE_GATT_MAX_MTU_SIZE - ATT_NOTIFY_HDR_SIZE,
+		.is_var_len = true,
+		.char_props = {
+			.write_wo_resp = 1,
+			.notify = 1,
+		},
+		.read_access = SEC_OPEN,
+		.write_access = SEC_OPEN,
+		.cccd_write_access = SEC_OPEN,
+	};
+
+	if (characteristic_add(m_ctx.service_handle, &params,
+			&m_ctx.char_handles) != NRF_SUCCESS) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int start_advertising(void)
+{
+	ble_advertising_init_t init;
+
+	memset(&init, 0, sizeof(init));
+	init.advdata.flags = BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE;
+	init.advdata.uuids_complete.uuid_cnt = 1;
+	init.advdata.uuids_complete.p_uuids = &m_ctx.service_uuid;
+	init.srdata.name_type = BLE_ADVDATA_FULL_NAME;
+	init.config.ble_adv_fast_enabled = true;
+	init.config.ble_adv_fast_interval = ADV_INTERVAL;
+	init.config.ble_adv_fast_timeout = BLE_GAP_ADV_TIMEOUT_GENERAL_UNLIMITED;
+	/* Restarted by on_disconnected(), only while the transport is up. */
+	init.config.ble_adv_on_disconnect_disabled = true;
+	init.evt_handler = on_adv_evt;
+
+	if (ble_advertising_init(&m_adv, &init) != NRF_SUCCESS) {
+		return -EIO;
+	}
+
+	ble_advertising_conn_cfg_tag_set(&m_adv, SMP_BLE_CONN_CFG_TAG);
+
+	if (ble_advertising_start(&m_adv, BLE_ADV_MODE_FAST) != NRF_SUCCESS) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int create_resources(void)
+{
+	m_ctx.free_q = xQueueCreate(SMP_BLE_RX_BUF_COUNT, sizeof(uint8_t));
+	m_ctx.ready_q = xQueueCreate(SMP_BLE_RX_BUF_COUNT,
+			sizeof(struct rx_msg));
+	m_ctx.tx_lock = xSemaphoreCreateMutex();
+	m_ctx.tx_done = xSemaphoreCreateBinary();
+
+	if (m_ctx.free_q == NULL || m_ctx.ready_q == NULL ||
+			m_ctx.tx_lock == NULL || m_ctx.tx_done == NULL) {
+		return -ENOMEM;
+	}
+
+	for (uint8_t i = 0; i < SMP_BLE_RX_BUF_COUNT; i++) {
+		xQueueSend(m_ctx.free_q, &i, 0);
+	}
+
+	if (xTaskCreate(rx_task, "smp_ble",
+			SMP_BLE_TASK_STACK_SIZE / sizeof(StackType_t), NULL,
+			SMP_BLE_TASK_PRIORITY, &m_ctx.task) != pdPASS) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void release_resources(void)
+{
+	if (m_ctx.task != NULL) {
+		vTaskDelete(m_ctx.task);
+		m_ctx.task = NULL;
+	}
+	if (m_ctx.free_q != NULL) {
+		vQueueDelete(m_ctx.free_q);
+		m_ctx.free_q = NULL;
+	}
+	if (m_ctx.ready_q != NULL) {
+		vQueueDelete(m_ctx.ready_q);
+		m_ctx.ready_q = NULL;
+	}
+	if (m_ctx.tx_lock != NULL) {
+		vSemaphoreDelete(m_ctx.tx_lock);
+		m_ctx.tx_lock = NULL;
+	}
+	if (m_ctx.tx_done != NULL) {
+		vSemaphoreDelete(m_ctx.tx_done);
+		m_ctx.tx_done = NULL;
+	}
+}
+
+int smp_ble_transport_send(const void *data, size_t len)
+{
+	if (!m_ctx.active || get_conn_handle() == BLE_CONN_HANDLE_INVALID) {
+		return -1;
+	}
+
+	struct smp_frag frag;
+	const void *chunk;
+	size_t chunk_len;
+	int err = 0;
+
+	xSemaphoreTake(m_ctx.tx_lock, portMAX_DELAY);
+	smp_frag_init(&frag, data, len);
+
+	/* The SoftDevice takes notifications until its queue is full and
+	 * sends as many as fit in each connection event. Only then is it
+	 * worth waiting, for the first one to be acknowledged. */
+	while ((chunk = smp_frag_peek(&frag, __atomic_load_n(
+			&m_ctx.payload_max, __ATOMIC_RELAXED),
+			&chunk_len)) != NULL) {
+		uint16_t hvx_len = (uint16_t)chunk_len;
+		const ble_gatts_hvx_params_t hvx = {
+			.handle = m_ctx.char_handles.value_handle,
+			.type = BLE_GATT_HVX_NOTIFICATION,
+			.p_len = &hvx_len,
+			.p_data = (const uint8_t *)chunk,
+		};
+		const uint16_t conn_handle = get_conn_handle();
+
+		if (conn_handle == BLE_CONN_HANDLE_INVALID) {
+			err = -1;
+			break;
+		}
+
+		const ret_code_t rc = sd_ble_gatts_hvx(conn_handle, &hvx);
+
+		if (rc == NRF_SUCCESS) {
+			smp_frag_consume(&frag, hvx_len);
+		} else if (rc != NRF_ERROR_RESOURCES ||
+				xSemaphoreTake(m_ctx.tx_done,
+					pdMS_TO_TICKS(SMP_BLE_TX_TIMEOUT_MS))
+				!= pdTRUE) {
+			err = -1;
+			break;
+		}
+	}
+
+	xSemaphoreGive(m_ctx.tx_lock);
+
+	return err;
+}
+
+int smp_ble_transport_init(mgmt_transport_rx_callback_t on_recv, void *ctx)
+{
+	int err;
+
+	if (on_recv == NULL) {
+		return -EINVAL;
+	}
+	if (m_ctx.active) {
+		return -EALREADY;
+	}
+
+	m_ctx.on_recv = on_recv;
+	m_ctx.on_recv_ctx = ctx;
+	smp_reasm_init(&m_ctx.reasm, m_ctx.reasm_buf, sizeof(m_ctx.reasm_buf));
+
+	if ((err = create_resources()) != 0) {
+		release_resources();
+		return err;
+	}
+
+	if (!m_ctx.enabled) {
+		if ((err = enable_stack()) != 0 || (err = setup_gap()) != 0 ||
+				(err = add_service()) != 0) {
+			release_resources();
+			return err;
+		}
+		m_ctx.enabled = true;
+	}
+
+	m_ctx.active = true;
+
+	if ((err = start_advertising()) != 0) {
+		m_ctx.active = false;
+		release_resources();
+		return err;
+	}
+
+	return 0;
+}
+
+void smp_ble_transport_deinit(void)
+{
+	if (!m_ctx.active) {
+		return;
+	}
+
+	const uint16_t conn_handle = get_conn_handle();
+
+	m_ctx.active = false;
+
+	if (conn_handle != BLE_CONN_HANDLE_INVALID) {
+		(void)sd_ble_gap_disconnect(conn_handle,
+				BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+		__atomic_store_n(&m_ctx.conn_handle, BLE_CONN_HANDLE_INVALID,
+				__ATOMIC_RELEASE);
+	}
+	(void)sd_ble_gap_adv_stop(m_adv.adv_handle);
+
+	xSemaphoreTake(m_ctx.tx_lock, portMAX_DELAY);
+	release_resources();
+}
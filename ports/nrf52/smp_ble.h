@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SMP_BLE_H
+#define SMP_BLE_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "libmcu/mgmt_transport.h"
+
+/** Largest SMP packet accepted, header included. */
+#if !defined(SMP_BLE_RX_BUF_SIZE)
+#define SMP_BLE_RX_BUF_SIZE		1032U
+#endif
+/** Packets received while earlier ones are still being handled. */
+#if !defined(SMP_BLE_RX_BUF_COUNT)
+#define SMP_BLE_RX_BUF_COUNT		2U
+#endif
+/** Notifications the SoftDevice may hold at once. The more there are, the
+ * more of them go out in a single connection event. The SoftDevice RAM
+ * for them is reserved in nrf52840.ld. */
+#if !defined(SMP_BLE_HVN_TX_QUEUE_SIZE)
+#define SMP_BLE_HVN_TX_QUEUE_SIZE	8U
+#endif
+#if !defined(SMP_BLE_DEVICE_NAME)
+#define SMP_BLE_DEVICE_NAME		"MADI"
+#endif
+
+/**
+ * @brief Initialise the SMP GATT transport.
+ *
+ * Enables the BLE stack on first use, adds the SMP service and starts
+ * advertising it. Must be called once the scheduler is running, as the
+ * SoftDevice events are handled by its task.
+ *
+ * Packets are reassembled from writes to the SMP characteristic and sent
+ * back as notifications, split to the ATT MTU negotiated by the peer.
+ *
+ * @param[in] on_recv  Called for each complete SMP packet, from the
+ *                     transport task.
+ * @param[in] ctx      Opaque context forwarded to @p on_recv.
+ * @return 0 on success, negative errno on failure.
+ */
+int smp_ble_transport_init(mgmt_transport_rx_callback_t on_recv, void *ctx);
+
+/**
+ * @brief Send an SMP packet to the connected peer.
+ *
+ * Blocks while the notification queue of the SoftDevice is full.
+ *
+ * @param[in] data  SMP packet bytes.
+ * @param[in] len   Packet length in bytes.
+ * @return 0 on success, -1 if not connected or notifications are not
+ *         enabled by the peer.
+ */
+int smp_ble_transport_send(const void *data, size_t len);
+
+/**
+ * @brief Drop the connection, stop advertising and release the task.
+ *
+ * The BLE stack is left enabled.
+ */
+void smp_ble_transport_deinit(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SMP_BLE_H */
@@ -0,0 +1,480 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "smp_uart.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "boards.h"
+#include "nrf_libuarte_async.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "libmcu/metrics.h"
+
+#define SMP_UART_RX_TASK_STACK_SIZE	2048U
+#define SMP_UART_RX_TASK_PRIORITY	2U
+/* Below the receiver, so frames keep being parsed while a handler waits
+ * on flash. */
+#define SMP_UART_MGMT_TASK_STACK_SIZE	4096U
+#define SMP_UART_MGMT_TASK_PRIORITY	1U
+/* A DMA buffer comes in as one chunk when the line is busy, or as many
+ * when it goes idle in between. */
+#define SMP_UART_RX_CHUNK_QLEN		(SMP_UART_RX_CHUNK_COUNT * 2U)
+/* Chunks the queue has no room for are held back, merged while they are
+ * contiguous, so there is at most one span per DMA buffer. */
+#define SMP_UART_RX_BACKLOG_LEN		SMP_UART_RX_CHUNK_COUNT
+
+/* Bytes are counted by TIMER1 through PPI, with no interrupt per byte,
+ * and the idle timeout runs on RTC2. TIMER0 and RTC0 belong to the
+ * SoftDevice and RTC1 to the FreeRTOS tick. The timer and RTC interrupts
+ * run one level above this one. */
+#define SMP_UART_IRQ_PRIORITY		APP_IRQ_PRIORITY_LOW
+
+NRF_LIBUARTE_ASYNC_DEFINE(m_uart, 1, 1, 2, NRF_LIBUARTE_PERIPHERAL_NOT_USED,
+		SMP_UART_RX_CHUNK_SIZE, SMP_UART_RX_CHUNK_COUNT);
+
+/* Received bytes in a DMA buffer, to be freed once fed. Bytes were lost
+ * right before a chunk marked lost. */
+struct rx_chunk {
+	uint8_t *data;
+	uint16_t len;
+	bool lost;
+};
+
+/* A packet waiting for the handler, and the framing to reply in. */
+struct rx_msg {
+	uint8_t slot;
+	uint8_t framing;
+	uint16_t len;
+};
+
+struct smp_uart_ctx {
+	mgmt_transport_rx_callback_t on_recv;
+	void *on_recv_ctx;
+
+	TaskHandle_t rx_task;
+	TaskHandle_t mgmt_task;
+	QueueHandle_t chunk_q;
+	QueueHandle_t free_q;
+	QueueHandle_t ready_q;
+	SemaphoreHandle_t tx_lock;
+	SemaphoreHandle_t tx_done;
+	uint32_t inflight;
+
+	/* Owned by the UART interrupts, or the receive task with them
+	 * masked. */
+	struct rx_chunk backlog[SMP_UART_RX_BACKLOG_LEN];
+	uint8_t backlog_head;
+	uint8_t backlog_count;
+	bool rx_lost;
+	/* Owned by the receive task: bytes of the current DMA buffer handed
+	 * back so far. */
+	size_t rx_freed;
+
+	struct smp_serial serial;
+	struct smp_serial_stats reported; /* already added to metrics */
+	/* Packets are decoded in place into a leased slot, which is handed
+	 * to the handler task as is and comes back once handled. */
+	uint8_t rx_slot[SMP_UART_RX_WINDOW][SMP_SERIAL_BUF_SIZE];
+
+	bool active;
+};
+
+static struct smp_uart_ctx m_ctx;
+
+static struct rx_chunk *get_backlog_tail(void)
+{
+	if (m_ctx.backlog_count == 0) {
+		return NULL;
+	}
+
+	return &m_ctx.backlog[(m_ctx.backlog_head + m_ctx.backlog_count - 1U)
+			% SMP_UART_RX_BACKLOG_LEN];
+}
+
+/* Nothing is freed here. A chunk stays in its DMA buffer until the
+ * receive task has fed it, so one the queue has no room for is merely
+ * late. A loss in the middle of a merged span goes unmarked; the frame it
+ * breaks fails its CRC instead. */
+static void hold_back(const struct rx_chunk *chunk)
+{
+	struct rx_chunk *tail = get_backlog_tail();
+
+	if (tail != NULL && chunk->data == tail->data + tail->len &&
+			(size_t)tail->len + chunk->len <= UINT16_MAX) {
+		tail->len = (uint16_t)(tail->len + chunk->len);
+		return;
+	}
+
+	/* Spans are no more than the buffers libuarte hands out. */
+	configASSERT(m_ctx.backlog_count < SMP_UART_RX_BACKLOG_LEN);
+	if (m_ctx.backlog_count < SMP_UART_RX_BACKLOG_LEN) {
+		m_ctx.backlog[(m_ctx.backlog_head + m_ctx.backlog_count) %
+				SMP_UART_RX_BACKLOG_LEN] = *chunk;
+		m_ctx.backlog_count++;
+	}
+}
+
+/* Queues what was held back, oldest first, for as long as there is room.
+ * @p woken may be NULL from the receive task. */
+static void release_backlog(BaseType_t *woken)
+{
+	while (m_ctx.backlog_count != 0 && xQueueSendFromISR(m_ctx.chunk_q,
+			&m_ctx.backlog[m_ctx.backlog_head], woken) == pdTRUE) {
+		m_ctx.backlog_head = (uint8_t)((m_ctx.backlog_head + 1U) %
+				SMP_UART_RX_BACKLOG_LEN);
+		m_ctx.backlog_count--;
+	}
+}
+
+/* Called from the UARTE interrupt and the RX timeout interrupt, never both
+ * at once as the latter masks the former. */
+static void on_uart_evt(void *ctx, nrf_libuarte_async_evt_t *evt)
+{
+	(void)ctx;
+
+	BaseType_t woken = pdFALSE;
+	struct rx_chunk chunk;
+
+	switch (evt->type) {
+	case NRF_LIBUARTE_ASYNC_EVT_RX_DATA:
+		chunk = (struct rx_chunk) {
+			.data = evt->data.rxtx.p_data,
+			.len = (uint16_t)evt->data.rxtx.length,
+			.lost = m_ctx.rx_lost,
+		};
+		m_ctx.rx_lost = false;
+		/* Every idle gap adds a chunk, so the queue fills up if the
+		 * receiver is held long enough. Chunks then wait in line
+		 * behind those held back before. */
+		release_backlog(&woken);
+		if (m_ctx.backlog_count != 0 || xQueueSendFromISR(
+				m_ctx.chunk_q, &chunk, &woken) != pdTRUE) {
+			hold_back(&chunk);
+		}
+		break;
+	case NRF_LIBUARTE_ASYNC_EVT_TX_DONE:
+		xSemaphoreGiveFromISR(m_ctx.tx_done, &woken);
+		break;
+	case NRF_LIBUARTE_ASYNC_EVT_ERROR: /* fall through */
+	case NRF_LIBUARTE_ASYNC_EVT_OVERRUN_ERROR:
+		m_ctx.rx_lost = true;
+		break;
+	default:
+		break;
+	}
+
+	portYIELD_FROM_ISR(woken);
+}
+
+/* EasyDMA reads straight from the encoder buffer, which is reused for the
+ * next line, so each write waits for its transfer to finish. */
+static int write_phy(const void *data, size_t len,
+		smp_serial_framing_t framing, void *arg)
+{
+	(void)framing;
+	(void)arg;
+
+	if (nrf_libuarte_async_tx(&m_uart, (uint8_t *)(uintptr_t)data, len)
+			!= NRF_SUCCESS) {
+		return -1;
+	}
+
+	xSemaphoreTake(m_ctx.tx_done, portMAX_DELAY);
+
+	return (int)len;
+}
+
+/* Waits for a free slot. Meanwhile DMA buffers are not handed back, and
+ * once they run out the receiver deasserts RTS. */
+static uint8_t *lease_slot(void *arg)
+{
+	struct smp_uart_ctx *ctx = (struct smp_uart_ctx *)arg;
+	uint8_t slot;
+
+	if (xQueueReceive(ctx->free_q, &slot, 0) != pdTRUE) {
+		const TickType_t t0 = xTaskGetTickCount();
+		xQueueReceive(ctx->free_q, &slot, portMAX_DELAY);
+		metrics_increase_by(SMPRxStallTime, (int32_t)
+			((xTaskGetTickCount() - t0) * portTICK_PERIOD_MS));
+	}
+
+	return ctx->rx_slot[slot];
+}
+
+static void deliver(uint8_t *buf, size_t len, smp_serial_framing_t framing,
+		void *arg)
+{
+	struct smp_uart_ctx *ctx = (struct smp_uart_ctx *)arg;
+	const struct rx_msg msg = {
+		.slot = (uint8_t)((size_t)(buf - ctx->rx_slot[0]) /
+				SMP_SERIAL_BUF_SIZE),
+		.framing = (uint8_t)framing,
+		.len = (uint16_t)len,
+	};
+
+	const uint32_t window = __atomic_add_fetch(&ctx->inflight, 1,
+			__ATOMIC_RELAXED);
+	metrics_set_if_max(SMPWindowMax, (int32_t)window);
+	metrics_increase(SMPRxCount);
+
+	xQueueSend(ctx->ready_q, &msg, portMAX_DELAY);
+}
+
+static const struct smp_serial_ops serial_ops = {
+	.write = write_phy,
+	.lease = lease_slot,
+	.deliver = deliver,
+};
+
+/* The framing keeps its own counters, which go to metrics as they move.
+ * Only the receive task feeds the framing, so it alone reads them. */
+static void report_rx_errors(struct smp_uart_ctx *ctx)
+{
+	struct smp_serial_stats now;
+
+	smp_serial_get_stats(&ctx->serial, &now);
+
+	if (now.crc_errors != ctx->reported.crc_errors) {
+		metrics_increase_by(SMPRxCRCErrorCount, (int32_t)
+				(now.crc_errors - ctx->reported.crc_errors));
+	}
+	if (now.malformed != ctx->reported.malformed) {
+		metrics_increase_by(SMPRxMalformedCount, (int32_t)
+				(now.malformed - ctx->reported.malformed));
+	}
+	if (now.dropped != ctx->reported.dropped) {
+		metrics_increase_by(SMPRxDropCount, (int32_t)
+				(now.dropped - ctx->reported.dropped));
+	}
+
+	ctx->reported = now;
+}
+
+/* libuarte takes bytes back in the order they came and returns a buffer
+ * once all of it is back, working out its start from the last free. A
+ * merged span crosses into the next buffer only when that one lies right
+ * after in memory, so it is handed back a buffer at a time. */
+static void free_in_order(struct smp_uart_ctx *ctx, uint8_t *data,
+		size_t len)
+{
+	while (len != 0) {
+		size_t n = SMP_UART_RX_CHUNK_SIZE - ctx->rx_freed;
+		n = (n < len)? n : len;
+
+		nrf_libuarte_async_rx_free(&m_uart, data, n);
+
+		ctx->rx_freed = (ctx->rx_freed + n) % SMP_UART_RX_CHUNK_SIZE;
+		data += n;
+		len -= n;
+	}
+}
+
+static void rx_task(void *arg)
+{
+	struct smp_uart_ctx *ctx = (struct smp_uart_ctx *)arg;
+	struct rx_chunk chunk;
+
+	for (;;) {
+		if (xQueueReceive(ctx->chunk_q, &chunk, portMAX_DELAY)
+				!= pdTRUE) {
+			continue;
+		}
+
+		if (chunk.lost) {
+			smp_serial_reset(&ctx->serial);
+		}
+
+		smp_serial_feed(&ctx->serial, chunk.data, chunk.len);
+		free_in_order(ctx, chunk.data, chunk.len);
+		report_rx_errors(ctx);
+
+		/* The interrupts hand what they held back over only as more
+		 * comes in, which it may not once the line goes quiet. */
+		taskENTER_CRITICAL();
+		release_backlog(NULL);
+		taskEXIT_CRITICAL();
+	}
+}
+
+static void mgmt_task(void *arg)
+{
+	struct smp_uart_ctx *ctx = (struct smp_uart_ctx *)arg;
+	struct rx_msg msg;
+
+	for (;;) {
+		if (xQueueReceive(ctx->ready_q, &msg, portMAX_DELAY)
+				!= pdTRUE) {
+			continue;
+		}
+
+		smp_serial_set_reply_framing(&ctx->serial,
+				(smp_serial_framing_t)msg.framing);
+		ctx->on_recv(ctx->rx_slot[msg.slot], msg.len,
+				ctx->on_recv_ctx);
+
+		__atomic_sub_fetch(&ctx->inflight, 1, __ATOMIC_RELAXED);
+		xQueueSend(ctx->free_q, &msg.slot, 0);
+	}
+}
+
+static int create_resources(void)
+{
+	m_ctx.inflight = 0;
+	m_ctx.backlog_head = 0;
+	m_ctx.backlog_count = 0;
+	m_ctx.rx_lost = false;
+	m_ctx.rx_freed = 0;
+	m_ctx.chunk_q = xQueueCreate(SMP_UART_RX_CHUNK_QLEN,
+			sizeof(struct rx_chunk));
+	m_ctx.free_q = xQueueCreate(SMP_UART_RX_WINDOW, sizeof(uint8_t));
+	m_ctx.ready_q = xQueueCreate(SMP_UART_RX_WINDOW,
+			sizeof(struct rx_msg));
+	m_ctx.tx_lock = xSemaphoreCreateMutex();
+	m_ctx.tx_done = xSemaphoreCreateBinary();
+
+	if (m_ctx.chunk_q == NULL || m_ctx.free_q == NULL ||
+			m_ctx.ready_q == NULL ||
+			m_ctx.tx_lock == NULL || m_ctx.tx_done == NULL) {
+		return -ENOMEM;
+	}
+
+	for (uint8_t i = 0; i < SMP_UART_RX_WINDOW; i++) {
+		xQueueSend(m_ctx.free_q, &i, 0);
+	}
+
+	if (xTaskCreate(mgmt_task, "smp_mgmt",
+			SMP_UART_MGMT_TASK_STACK_SIZE / sizeof(StackType_t),
+			&m_ctx, SMP_UART_MGMT_TASK_PRIORITY,
+			&m_ctx.mgmt_task) != pdPASS ||
+			xTaskCreate(rx_task, "smp_uart",
+			SMP_UART_RX_TASK_STACK_SIZE / sizeof(StackType_t),
+			&m_ctx, SMP_UART_RX_TASK_PRIORITY,
+			&m_ctx.rx_task) != pdPASS) {
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void release_resources(void)
+{
+	if (m_ctx.rx_task != NULL) {
+		vTaskDelete(m_ctx.rx_task);
+		m_ctx.rx_task = NULL;
+	}
+	if (m_ctx.mgmt_task != NULL) {
+		vTaskDelete(m_ctx.mgmt_task);
+		m_ctx.mgmt_task = NULL;
+	}
+	if (m_ctx.chunk_q != NULL) {
+		vQueueDelete(m_ctx.chunk_q);
+		m_ctx.chunk_q = NULL;
+	}
+	if (m_ctx.free_q != NULL) {
+		vQueueDelete(m_ctx.free_q);
+		m_ctx.free_q = NULL;
+	}
+	if (m_ctx.ready_q != NULL) {
+		vQueueDelete(m_ctx.ready_q);
+		m_ctx.ready_q = NULL;
+	}
+	if (m_ctx.tx_lock != NULL) {
+		vSemaphoreDelete(m_ctx.tx_lock);
+		m_ctx.tx_lock = NULL;
+	}
+	if (m_ctx.tx_done != NULL) {
+		vSemaphoreDelete(m_ctx.tx_done);
+		m_ctx.tx_done = NULL;
+	}
+}
+
+int smp_uart_transport_send(const void *data, size_t len)
+{
+	if (!m_ctx.active) {
+		return -1;
+	}
+
+	xSemaphoreTake(m_ctx.tx_lock, portMAX_DELAY);
+	const int err = smp_serial_send(&m_ctx.serial, data, len);
+	xSemaphoreGive(m_ctx.tx_lock);
+
+	return err;
+}
+
+int smp_uart_transport_set_framing(smp_serial_framing_t framing)
+{
+	return smp_serial_set_framing(&m_ctx.serial, framing);
+}
+
+int smp_uart_transport_init(mgmt_transport_rx_callback_t on_recv, void *ctx)
+{
+	const nrf_libuarte_async_config_t config = {
+		.tx_pin = TX_PIN_NUMBER,
+		.rx_pin = RX_PIN_NUMBER,
+#if SMP_UART_HWFC
+		.cts_pin = CTS_PIN_NUMBER,
+		.rts_pin = RTS_PIN_NUMBER,
+		.hwfc = NRF_UARTE_HWFC_ENABLED,
+#else
+		.cts_pin = NRF_UARTE_PSEL_DISCONNECTED,
+		.rts_pin = NRF_UARTE_PSEL_DISCONNECTED,
+		.hwfc = NRF_UARTE_HWFC_DISABLED,
+#endif
+		.baudrate = SMP_UART_BAUDRATE,
+		.parity = NRF_UARTE_PARITY_EXCLUDED,
+		.timeout_us = SMP_UART_RX_TIMEOUT_US,
+		.int_prio = SMP_UART_IRQ_PRIORITY,
+	};
+	int err;
+
+	if (on_recv == NULL) {
+		return -EINVAL;
+	}
+	if (m_ctx.active) {
+		return -EALREADY;
+	}
+
+	m_ctx.on_recv = on_recv;
+	m_ctx.on_recv_ctx = ctx;
+	smp_serial_init(&m_ctx.serial, &serial_ops, &m_ctx);
+	m_ctx.reported = (struct smp_serial_stats) { 0, };
+	smp_serial_set_framing(&m_ctx.serial, SMP_UART_FRAMING_DEFAULT);
+
+	if ((err = create_resources()) != 0) {
+		release_resources();
+		return err;
+	}
+
+	if (nrf_libuarte_async_init(&m_uart, &config, on_uart_evt, NULL)
+			!= NRF_SUCCESS) {
+		release_resources();
+		return -EIO;
+	}
+
+	nrf_libuarte_async_enable(&m_uart);
+	m_ctx.active = true;
+
+	return 0;
+}
+
+void smp_uart_transport_deinit(void)
+{
+	if (!m_ctx.active) {
+		return;
+	}
+
+	m_ctx.active = false;
+
+	xSemaphoreTake(m_ctx.tx_lock, portMAX_DELAY);
+	nrf_libuarte_async_uninit(&m_uart);
+	release_resources();
+}
@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SMP_UART_H
+#define SMP_UART_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "libmcu/mgmt_transport.h"
+#include "smp_serial.h"
+
+#if !defined(SMP_UART_BAUDRATE)
+#define SMP_UART_BAUDRATE		NRF_UARTE_BAUDRATE_1000000
+#endif
+/** RTS/CTS on the board pins. Without it, bytes arriving while every DMA
+ * buffer is still held by the receiver are lost. With it, nothing is sent
+ * until the host asserts CTS. */
+#if !defined(SMP_UART_HWFC)
+#define SMP_UART_HWFC			1
+#endif
+/** Idle time on the line after which the bytes received so far are handed
+ * over, without waiting for the DMA buffer to fill. Ten bytes at 1 Mbaud. */
+#if !defined(SMP_UART_RX_TIMEOUT_US)
+#define SMP_UART_RX_TIMEOUT_US		100U
+#endif
+/** Size of each DMA receive buffer. The receiver wakes at least once per
+ * buffer while data keeps coming. */
+#if !defined(SMP_UART_RX_CHUNK_SIZE)
+#define SMP_UART_RX_CHUNK_SIZE		256U
+#endif
+/** DMA receive buffers. One is being filled and one is queued behind it
+ * in hardware. The rest cover the time the receiver takes to hand them
+ * back. At least three. */
+#if !defined(SMP_UART_RX_CHUNK_COUNT)
+#define SMP_UART_RX_CHUNK_COUNT		8U
+#endif
+/** Requests received and held while earlier ones are handled. */
+#if !defined(SMP_UART_RX_WINDOW)
+#define SMP_UART_RX_WINDOW		4U
+#endif
+#if !defined(SMP_UART_FRAMING_DEFAULT)
+#define SMP_UART_FRAMING_DEFAULT	SMP_SERIAL_FRAMING_AUTO
+#endif
+
+/**
+ * @brief Initialise the SMP transport on UARTE1.
+ *
+ * The line is received by EasyDMA into a pool of buffers, one queued
+ * behind the other, and a buffer is handed to the receive task when it
+ * is full or when the line has been idle for SMP_UART_RX_TIMEOUT_US. The
+ * task decodes packets from it and passes them on to a handler task, up
+ * to SMP_UART_RX_WINDOW at a time, in order.
+ *
+ * The UART is dedicated to SMP, so both console and COBS framing are
+ * written to it as they are.
+ *
+ * @param[in] on_recv  Called for each complete decoded SMP packet, from
+ *                     the handler task. The packet stays valid only until
+ *                     the call returns.
+ * @param[in] ctx      Opaque context forwarded to @p on_recv.
+ * @return 0 on success, negative errno on failure.
+ */
+int smp_uart_transport_init(mgmt_transport_rx_callback_t on_recv, void *ctx);
+
+/**
+ * @brief Select the framing of the port.
+ *
+ * @param[in] framing Framing to use from now on.
+ * @return 0 on success, -1 on an unknown framing.
+ */
+int smp_uart_transport_set_framing(smp_serial_framing_t framing);
+
+/**
+ * @brief Encode and transmit an SMP packet.
+ *
+ * Blocks until the frame has left the UART.
+ *
+ * @param[in] data  SMP packet bytes.
+ * @param[in] len   Packet length in bytes.
+ * @return 0 on success, -1 on failure.
+ */
+int smp_uart_transport_send(const void *data, size_t len);
+
+/**
+ * @brief Stop the UART and release the tasks.
+ */
+void smp_uart_transport_deinit(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* SMP_UART_H */
@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "timebase.h"
+
+#include <errno.h>
+
+#include "nrf.h"
+#include "app_util_platform.h"
+#include "FreeRTOS.h"
+#include "timers.h"
+
+#define RTC_FREQ			32768U
+#define RTC_COUNTER_MASK		0xFFFFFFU
+/* CYCCNT wraps every 67 seconds at 64 MHz. Sampling well within that
+ * keeps the extension correct through long busy periods. */
+#define SAMPLE_PERIOD_MS		16000U
+
+/* DWT CYCCNT only runs while the CPU clock does, so it stands still in
+ * WFI/WFE. The time spent asleep is measured with RTC1, which also drives
+ * the FreeRTOS tick, and added on wakeup. Timestamps are thus CPU-cycle
+ * accurate while awake and RTC-tick (30.5 us) accurate across sleep. */
+static struct {
+	uint64_t ticks;       /* extended count at the last sample */
+	uint64_t ticks_at_sleep;
+	uint32_t last;        /* CYCCNT at the last sample */
+	uint32_t rtc_at_sleep;
+} tb;
+
+/* Must be called inside a critical region. */
+static uint64_t sample(void)
+{
+	const uint32_t now = DWT->CYCCNT;
+
+	tb.ticks += (uint32_t)(now - tb.last);
+	tb.last = now;
+
+	return tb.ticks;
+}
+
+static void on_sample_timer(TimerHandle_t timer)
+{
+	(void)timer;
+	(void)timebase_get_ticks();
+}
+
+uint64_t timebase_get_ticks(void)
+{
+	uint64_t ticks;
+
+	CRITICAL_REGION_ENTER();
+	ticks = sample();
+	CRITICAL_REGION_EXIT();
+
+	return ticks;
+}
+
+uint32_t timebase_get_frequency(void)
+{
+	return SystemCoreClock;
+}
+
+/* Called by the FreeRTOS tickless idle through configPRE_SLEEP_PROCESSING
+ * with interrupts disabled. */
+void timebase_enter_sleep(void)
+{
+	tb.ticks_at_sleep = sample();
+	tb.rtc_at_sleep = NRF_RTC1->COUNTER;
+}
+
+/* Called through configPOST_SLEEP_PROCESSING. The CPU may have woken up
+ * in between to serve interrupts, so only the part of the RTC interval
+ * not already counted by CYCCNT is added. */
+void timebase_exit_sleep(void)
+{
+	const uint32_t rtc_elapsed =
+		(NRF_RTC1->COUNTER - tb.rtc_at_sleep) & RTC_COUNTER_MASK;
+	const uint64_t wall =
+		(uint64_t)rtc_elapsed * SystemCoreClock / RTC_FREQ;
+	const uint64_t counted = sample() - tb.ticks_at_sleep;
+
+	if (wall > counted) {
+		tb.ticks += wall - counted;
+	}
+}
+
+int timebase_init(void)
+{
+	static TimerHandle_t timer;
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	CRITICAL_REGION_ENTER();
+	tb.ticks = 0;
+	tb.last = DWT->CYCCNT;
+	CRITICAL_REGION_EXIT();
+
+	if (timer == NULL) {
+		timer = xTimerCreate("tb", pdMS_TO_TICKS(SAMPLE_PERIOD_MS),
+				pdTRUE, NULL, on_sample_timer);
+		if (timer == NULL || xTimerStart(timer, 0) != pdPASS) {
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "rtt_channel.h"
+
+#include <errno.h>
+#include <stdbool.h>
+
+#include <SEGGER_RTT.h>
+
+#if SEGGER_RTT_MAX_NUM_UP_BUFFERS < 4 || SEGGER_RTT_MAX_NUM_DOWN_BUFFERS < 4
+#error "SEGGER_RTT_MAX_NUM_{UP,DOWN}_BUFFERS must cover every rtt_channel_t"
+#endif
+
+struct channel {
+	const char *name;
+	uint8_t *up;
+	unsigned up_size;
+	uint8_t *down;
+	unsigned down_size;
+	rtt_channel_mode_t mode;
+	struct rtt_channel_stats stats;
+};
+
+static uint8_t metrics_up[RTT_CHANNEL_METRICS_UP_SIZE];
+static uint8_t trace_up[RTT_CHANNEL_TRACE_UP_SIZE];
+static uint8_t smp_up[RTT_CHANNEL_SMP_UP_SIZE];
+static uint8_t smp_down[RTT_CHANNEL_SMP_DOWN_SIZE];
+
+static struct channel channels[RTT_CHANNEL_MAX] = {
+	[RTT_CHANNEL_LOG] = {
+		.name = "Terminal",
+		.mode = RTT_CHANNEL_LOG_MODE,
+	},
+	[RTT_CHANNEL_METRICS] = {
+		.name = "Metrics",
+		.up = metrics_up,
+		.up_size = sizeof(metrics_up),
+		.mode = RTT_CHANNEL_METRICS_MODE,
+	},
+	[RTT_CHANNEL_TRACE] = {
+		.name = "Trace",
+		.up = trace_up,
+		.up_size = sizeof(trace_up),
+		.mode = RTT_CHANNEL_SKIP,
+	},
+	[RTT_CHANNEL_SMP] = {
+		.name = "SMP",
+		.up = smp_up,
+		.up_size = sizeof(smp_up),
+		.down = smp_down,
+		.down_size = sizeof(smp_down),
+		.mode = RTT_CHANNEL_SMP_MODE,
+	},
+};
+
+/* C_DEBUGEN in DHCSR is set while a debug probe is attached. */
+static bool is_debugger_attached(void)
+{
+	const volatile uint32_t *dhcsr = (const volatile uint32_t *)0xE000EDF0;
+	return (*dhcsr & 1U) != 0;
+}
+
+static unsigned get_flags(rtt_channel_mode_t mode)
+{
+	switch (mode) {
+	case RTT_CHANNEL_BLOCK:
+		return is_debugger_attached()?
+			SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL :
+			SEGGER_RTT_MODE_NO_BLOCK_SKIP;
+	case RTT_CHANNEL_TRIM:
+		return SEGGER_RTT_MODE_NO_BLOCK_TRIM;
+	case RTT_CHANNEL_SKIP:
+	default:
+		return SEGGER_RTT_MODE_NO_BLOCK_SKIP;
+	}
+}
+
+int rtt_channel_write(rtt_channel_t ch, const void *data, size_t len)
+{
+	if ((unsigned)ch >= RTT_CHANNEL_MAX) {
+		return -EINVAL;
+	}
+
+	struct channel *p = &channels[ch];
+	const unsigned written =
+		SEGGER_RTT_Write((unsigned)ch, data, (unsigned)len);
+
+	__atomic_fetch_add(&p->stats.written, written, __ATOMIC_RELAXED);
+
+	if (written < len) {
+		__atomic_fetch_add(&p->stats.dropped,
+				(uint32_t)(len - written), __ATOMIC_RELAXED);
+		__atomic_fetch_add(&p->stats.overflows, 1, __ATOMIC_RELAXED);
+	}
+
+	return (int)written;
+}
+
+int rtt_channel_read(rtt_channel_t ch, void *buf, size_t bufsize)
+{
+	if ((unsigned)ch >= RTT_CHANNEL_MAX) {
+		return -EINVAL;
+	}
+	if (ch != RTT_CHANNEL_LOG && channels[ch].down == NULL) {
+		return -ENOTSUP;
+	}
+
+	return (int)SEGGER_RTT_Read((unsigned)ch, buf, (unsigned)bufsize);
+}
+
+int rtt_channel_set_mode(rtt_channel_t ch, rtt_channel_mode_t mode)
+{
+	if ((unsigned)ch >= RTT_CHANNEL_MAX) {
+		return -EINVAL;
+	}
+	if (ch == RTT_CHANNEL_TRACE && mode != RTT_CHANNEL_SKIP) {
+		return -EPERM;
+	}
+
+	channels[ch].mode = mode;
+
+	if (SEGGER_RTT_SetFlagsUpBuffer((unsigned)ch, get_flags(mode)) < 0) {
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int rtt_channel_stats(rtt_channel_t ch, struct rtt_channel_stats *stats)
+{
+	if ((unsigned)ch >= RTT_CHANNEL_MAX || stats == NULL) {
+		return -EINVAL;
+	}
+
+	const struct channel *p = &channels[ch];
+
+	*stats = (struct rtt_channel_stats) {
+		.written = __atomic_load_n(&p->stats.written, __ATOMIC_RELAXED),
+		.dropped = __atomic_load_n(&p->stats.dropped, __ATOMIC_RELAXED),
+		.overflows = __atomic_load_n(&p->stats.overflows,
+				__ATOMIC_RELAXED),
+	};
+
+	return 0;
+}
+
+int rtt_channel_init(void)
+{
+	for (unsigned i = 0; i < RTT_CHANNEL_MAX; i++) {
+		const struct channel *p = &channels[i];
+		const unsigned flags = get_flags(p->mode);
+
+		/* Only the flags of channel 0 are taken; its buffers stay
+		 * the built-in ones, already in use by early output. */
+		if (SEGGER_RTT_ConfigUpBuffer(i, p->name, p->up, p->up_size,
+				flags) < 0) {
+			return -EIO;
+		}
+
+		if (p->down != NULL && SEGGER_RTT_ConfigDownBuffer(i, p->name,
+				p->down, p->down_size,
+				SEGGER_RTT_MODE_NO_BLOCK_SKIP) < 0) {
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
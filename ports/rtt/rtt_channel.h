@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef RTT_CHANNEL_H
+#define RTT_CHANNEL_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Channel 0 keeps the buffers built into SEGGER_RTT.c, sized by
+ * BUFFER_SIZE_UP and BUFFER_SIZE_DOWN, since J-Link terminals and the
+ * Zephyr RTT console expect it there. The others are sized here. */
+#if !defined(RTT_CHANNEL_METRICS_UP_SIZE)
+#define RTT_CHANNEL_METRICS_UP_SIZE		256U
+#endif
+#if !defined(RTT_CHANNEL_TRACE_UP_SIZE)
+#define RTT_CHANNEL_TRACE_UP_SIZE		2048U
+#endif
+#if !defined(RTT_CHANNEL_SMP_UP_SIZE)
+#define RTT_CHANNEL_SMP_UP_SIZE			512U
+#endif
+#if !defined(RTT_CHANNEL_SMP_DOWN_SIZE)
+#define RTT_CHANNEL_SMP_DOWN_SIZE		512U
+#endif
+
+#if !defined(RTT_CHANNEL_LOG_MODE)
+#define RTT_CHANNEL_LOG_MODE			RTT_CHANNEL_BLOCK
+#endif
+#if !defined(RTT_CHANNEL_METRICS_MODE)
+#define RTT_CHANNEL_METRICS_MODE		RTT_CHANNEL_SKIP
+#endif
+#if !defined(RTT_CHANNEL_SMP_MODE)
+#define RTT_CHANNEL_SMP_MODE			RTT_CHANNEL_BLOCK
+#endif
+
+/**
+ * Streams carried over RTT. The value is both the up and the down buffer
+ * index, so the host opens the same number in either direction.
+ */
+typedef enum {
+	RTT_CHANNEL_LOG,     /**< logs and shell, the RTT terminal */
+	RTT_CHANNEL_METRICS, /**< metrics snapshots, target to host only */
+	RTT_CHANNEL_TRACE,   /**< binary traces, target to host only */
+	RTT_CHANNEL_SMP,     /**< SMP frames in both directions */
+	RTT_CHANNEL_MAX,
+} rtt_channel_t;
+
+typedef enum {
+	RTT_CHANNEL_SKIP,  /**< drop the whole write if it does not fit */
+	RTT_CHANNEL_TRIM,  /**< write as much as fits */
+	/** wait for the host to make room. Falls back to RTT_CHANNEL_SKIP
+	 * while no debugger is attached, as nobody would ever drain it. */
+	RTT_CHANNEL_BLOCK,
+} rtt_channel_mode_t;
+
+struct rtt_channel_stats {
+	uint32_t written;   /**< bytes accepted */
+	uint32_t dropped;   /**< bytes lost to a full buffer */
+	uint32_t overflows; /**< writes that lost any bytes */
+};
+
+/**
+ * @brief Set up the buffers of every channel.
+ *
+ * The trace channel is always RTT_CHANNEL_SKIP so that it never holds up
+ * the log and shell channel however fast traces are produced.
+ *
+ * @return 0 on success, negative value on error.
+ */
+int rtt_channel_init(void);
+
+/**
+ * @brief Write to the up buffer of a channel under its mode.
+ *
+ * @param[in] ch Channel to write to.
+ * @param[in] data Data to write.
+ * @param[in] len Length of @p data in bytes.
+ * @return Number of bytes written, or negative value on error.
+ */
+int rtt_channel_write(rtt_channel_t ch, const void *data, size_t len);
+
+/**
+ * @brief Read what the host has put in the down buffer of a channel.
+ *
+ * It never waits.
+ *
+ * @param[in] ch Channel to read from.
+ * @param[out] buf Buffer to read into.
+ * @param[in] bufsize Size of @p buf in bytes.
+ * @return Number of bytes read, or negative value on error.
+ */
+int rtt_channel_read(rtt_channel_t ch, void *buf, size_t bufsize);
+
+/**
+ * @brief Change the mode of a channel at run time.
+ *
+ * @param[in] ch Channel to change.
+ * @param[in] mode New mode.
+ * @return 0 on success, negative value on error.
+ */
+int rtt_channel_set_mode(rtt_channel_t ch, rtt_channel_mode_t mode);
+
+/**
+ * @brief Read the counters of a channel.
+ *
+ * @param[in] ch Channel to read.
+ * @param[out] stats Snapshot of the counters.
+ * @return 0 on success, negative value on error.
+ */
+int rtt_channel_stats(rtt_channel_t ch, struct rtt_channel_stats *stats);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* RTT_CHANNEL_H */
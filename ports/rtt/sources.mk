@@ -5,11 +5,16 @@ RTT_ROOT ?= external/SEGGER_RTT_V784e
 RTT_SRCS = \
 	$(RTT_ROOT)/RTT/SEGGER_RTT.c \
 	$(RTT_ROOT)/RTT/SEGGER_RTT_printf.c \
+	ports/rtt/rtt_channel.c \
 
 RTT_INCS = \
 	$(RTT_ROOT)/RTT \
 	$(RTT_ROOT)/Config \
+	ports/rtt \
 
-RTT_DEFS =
+# One up and one down buffer for every rtt_channel_t.
+RTT_DEFS = \
+	SEGGER_RTT_MAX_NUM_UP_BUFFERS=4 \
+	SEGGER_RTT_MAX_NUM_DOWN_BUFFERS=4 \
 
 $(addprefix $(OUTDIR)/, $(RTT_SRCS:%=%.o)): CFLAGS+=-Wno-error
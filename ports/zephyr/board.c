@@ -302,7 +302,7 @@ uint32_t board_get_time_since_boot_ms(void)
 LIBMCU_NO_INSTRUMENT
 uint64_t board_get_time_since_boot_us(void)
 {
-	return (uint64_t)k_uptime_get() * 1000U;
+	return k_cyc_to_us_floor64(k_cycle_get_64());
 }
 
 LIBMCU_NO_INSTRUMENT
@@ -0,0 +1,174 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "console_uart.h"
+
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/ring_buffer.h>
+
+#if defined(CONFIG_UART_INTERRUPT_DRIVEN)
+
+struct console_uart {
+	const struct device *dev;
+
+	struct ring_buf tx;
+	struct ring_buf rx;
+	uint8_t txmem[CONSOLE_UART_TX_BUFSIZE];
+	uint8_t rxmem[CONSOLE_UART_RX_BUFSIZE];
+
+	struct k_sem tx_space;
+	struct k_sem rx_data;
+	/* Guards the rings against the interrupt handler. */
+	struct k_spinlock lock;
+
+	uint32_t rx_overruns;
+};
+
+static struct console_uart cons;
+
+static void on_rx_ready(const struct device *dev)
+{
+	uint8_t *p;
+	uint32_t room = ring_buf_put_claim(&cons.rx, &p, sizeof(cons.rxmem));
+
+	if (room == 0) {
+		uint8_t discard[8];
+		int n;
+		while ((n = uart_fifo_read(dev, discard, sizeof(discard))) > 0) {
+			cons.rx_overruns += (uint32_t)n;
+		}
+		return;
+	}
+
+	int n = uart_fifo_read(dev, p, (int)room);
+	ring_buf_put_finish(&cons.rx, (n > 0)? (uint32_t)n : 0);
+
+	if (n > 0) {
+		k_sem_give(&cons.rx_data);
+	}
+}
+
+static void on_tx_ready(const struct device *dev)
+{
+	uint8_t *p;
+	uint32_t pending = ring_buf_get_claim(&cons.tx, &p,
+			sizeof(cons.txmem));
+
+	if (pending == 0) {
+		uart_irq_tx_disable(dev);
+		return;
+	}
+
+	int n = uart_fifo_fill(dev, p, (int)pending);
+	ring_buf_get_finish(&cons.tx, (n > 0)? (uint32_t)n : 0);
+
+	if (n > 0) {
+		k_sem_give(&cons.tx_space);
+	}
+}
+
+static void on_irq(const struct device *dev, void *user_data)
+{
+	ARG_UNUSED(user_data);
+
+	while (uart_irq_update(dev) && uart_irq_is_pending(dev)) {
+		if (uart_irq_rx_ready(dev)) {
+			on_rx_ready(dev);
+		}
+		if (uart_irq_tx_ready(dev)) {
+			on_tx_ready(dev);
+		}
+	}
+}
+
+int console_uart_write(const void *data, size_t len)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	size_t written = 0;
+
+	if (cons.dev == NULL) {
+		return -ENODEV;
+	}
+
+	while (written < len) {
+		k_spinlock_key_t key = k_spin_lock(&cons.lock);
+		uint32_t n = ring_buf_put(&cons.tx, p + written,
+				(uint32_t)(len - written));
+		k_spin_unlock(&cons.lock, key);
+
+		if (n > 0) {
+			uart_irq_tx_enable(cons.dev);
+			written += n;
+			continue;
+		}
+
+		if (k_sem_take(&cons.tx_space,
+				K_MSEC(CONSOLE_UART_TX_TIMEOUT_MS)) != 0) {
+			break;
+		}
+	}
+
+	return (int)written;
+}
+
+int console_uart_read(void *buf, size_t bufsize, int32_t timeout_ms)
+{
+	const k_timeout_t timeout = (timeout_ms < 0)?
+		K_FOREVER : K_MSEC(timeout_ms);
+
+	if (cons.dev == NULL) {
+		return -ENODEV;
+	}
+
+	for (;;) {
+		k_spinlock_key_t key = k_spin_lock(&cons.lock);
+		uint32_t n = ring_buf_get(&cons.rx, (uint8_t *)buf,
+				(uint32_t)bufsize);
+		k_spin_unlock(&cons.lock, key);
+
+		if (n > 0 || bufsize == 0) {
+			return (int)n;
+		}
+		if (k_sem_take(&cons.rx_data, timeout) != 0) {
+			return 0;
+		}
+	}
+}
+
+uint32_t console_uart_rx_overruns(void)
+{
+	return cons.rx_overruns;
+}
+
+int console_uart_init(const struct device *dev)
+{
+	if (!device_is_ready(dev)) {
+		return -ENODEV;
+	}
+
+	ring_buf_init(&cons.tx, sizeof(cons.txmem), cons.txmem);
+	ring_buf_init(&cons.rx, sizeof(cons.rxmem), cons.rxmem);
+	k_sem_init(&cons.tx_space, 0, 1);
+	k_sem_init(&cons.rx_data, 0, 1);
+
+	uart_irq_rx_disable(dev);
+	uart_irq_tx_disable(dev);
+
+	int err = uart_irq_callback_user_data_set(dev, on_irq, NULL);
+	if (err != 0) {
+		return err;
+	}
+
+	cons.dev = dev;
+	uart_irq_rx_enable(dev);
+
+	return 0;
+}
+
+#endif /* CONFIG_UART_INTERRUPT_DRIVEN */
@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef CONSOLE_UART_H
+#define CONSOLE_UART_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+
+#if !defined(CONSOLE_UART_TX_BUFSIZE)
+#define CONSOLE_UART_TX_BUFSIZE		1024U
+#endif
+#if !defined(CONSOLE_UART_RX_BUFSIZE)
+#define CONSOLE_UART_RX_BUFSIZE		256U
+#endif
+/** Longest time a writer waits for room in the TX ring. */
+#if !defined(CONSOLE_UART_TX_TIMEOUT_MS)
+#define CONSOLE_UART_TX_TIMEOUT_MS	100
+#endif
+
+/**
+ * @brief Take over @p dev with the interrupt-driven UART API.
+ *
+ * @param[in] dev UART device.
+ * @return 0 on success, negative errno on failure.
+ */
+int console_uart_init(const struct device *dev);
+
+/**
+ * @brief Queue bytes for transmission.
+ *
+ * Bytes are copied into the TX ring and sent from the UART interrupt in
+ * FIFO-sized bursts. The caller waits only while the ring is full, for at
+ * most CONSOLE_UART_TX_TIMEOUT_MS each time.
+ *
+ * @param[in] data Bytes to send.
+ * @param[in] len Number of bytes.
+ * @return Number of bytes queued, or negative errno.
+ */
+int console_uart_write(const void *data, size_t len);
+
+/**
+ * @brief Read received bytes, waiting up to @p timeout_ms for the first.
+ *
+ * @param[out] buf Buffer to read into.
+ * @param[in] bufsize Size of @p buf in bytes.
+ * @param[in] timeout_ms 0 to return at once, negative to wait forever.
+ * @return Number of bytes read, 0 on timeout, or negative errno.
+ */
+int console_uart_read(void *buf, size_t bufsize, int32_t timeout_ms);
+
+/**
+ * @brief Number of received bytes lost to a full RX ring.
+ *
+ * @return Overrun count.
+ */
+uint32_t console_uart_rx_overruns(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CONSOLE_UART_H */
@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "timebase.h"
+
+#include <zephyr/kernel.h>
+
+/* The system timer keeps counting in tickless idle and the kernel already
+ * extends it to 64 bits, so the timebase is a thin wrapper around it. */
+
+int timebase_init(void)
+{
+	return 0;
+}
+
+uint64_t timebase_get_ticks(void)
+{
+	return k_cycle_get_64();
+}
+
+uint32_t timebase_get_frequency(void)
+{
+	return (uint32_t)sys_clock_hw_cycles_per_sec();
+}
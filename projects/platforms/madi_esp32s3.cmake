@@ -6,6 +6,9 @@ foreach(dir ${ports})
 	file(GLOB_RECURSE ${dir}_CPP_SRCS RELATIVE ${CMAKE_SOURCE_DIR} ${dir}/*.cpp)
 	list(APPEND PORT_SRCS ${${dir}_SRCS} ${${dir}_CPP_SRCS})
 endforeach()
+if(NOT LOGGING_STORE)
+	list(REMOVE_ITEM PORT_SRCS ports/esp-idf/log_store.c)
+endif()
 
 set(PROJECT_EXECUTABLE ${CMAKE_PROJECT_NAME}.elf)
 set(PROJECT_BIN ${CMAKE_PROJECT_NAME}.bin)
@@ -14,6 +14,9 @@ if (DEFINED ENV{ZEPHYR_TOOLCHAIN_VARIANT})
 	list(APPEND PORT_SRCS
 		${LIBMCU_ROOT}/ports/zephyr/timext.c
 	)
+	if (CONFIG_USE_SEGGER_RTT)
+		list(APPEND PORT_SRCS ports/rtt/rtt_channel.c)
+	endif()
 
 	target_sources(app PRIVATE
 		${APP_SRCS}
@@ -29,6 +32,8 @@ if (DEFINED ENV{ZEPHYR_TOOLCHAIN_VARIANT})
 		PRIVATE
 			${APP_INCS}
 			${CMAKE_CURRENT_LIST_DIR}
+			${CMAKE_SOURCE_DIR}/ports/zephyr
+			${CMAKE_SOURCE_DIR}/ports/rtt
 	)
 
 	target_link_libraries(app
@@ -45,6 +45,7 @@ DEFS += $(PROJECT) \
 	\
 	METRICS_USER_DEFINES=\"$(BASEDIR)/include/metrics.def\" \
 	LOGGING_MESSAGE_MAXLEN=256 \
+	$(RTT_DEFS) \
 
 OBJS += $(addprefix $(OUTDIR)/, $(SRCS:%=%.o))
 LIBDIRS += $(OUTDIR)
@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "console_emerg.h"
+#include "console_sync.h"
+#include "log_ring.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#if defined(__ZEPHYR__)
+#include <zephyr/kernel.h>
+#elif defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#elif defined(TARGET_PLATFORM_madi_nrf52840)
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+
+static uint32_t mem[LOG_RING_MEMSIZE(CONSOLE_EMERG_SLOT_COUNT,
+		CONSOLE_EMERG_SLOT_SIZE) / sizeof(uint32_t)];
+static struct log_ring ring;
+static bool initialized;
+static bool draining;
+static bool panicked;
+static uint32_t dropped;
+
+static bool is_scheduler_running(void)
+{
+#if defined(__ZEPHYR__)
+	return !k_is_pre_kernel();
+#elif defined(ESP_PLATFORM) || defined(TARGET_PLATFORM_madi_nrf52840)
+	return xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+#else
+	return true;
+#endif
+}
+
+/* The ring is set up on first use, which may be from an ISR or before
+ * main(). A context that preempts the one setting it up gets NULL rather
+ * than spinning on it. */
+static struct log_ring *get_ring(void)
+{
+	static bool claimed;
+
+	if (__atomic_load_n(&initialized, __ATOMIC_ACQUIRE)) {
+		return &ring;
+	}
+	if (__atomic_exchange_n(&claimed, true, __ATOMIC_ACQ_REL)) {
+		return NULL;
+	}
+
+	log_ring_init(&ring, mem, sizeof(mem), CONSOLE_EMERG_SLOT_SIZE);
+	__atomic_store_n(&initialized, true, __ATOMIC_RELEASE);
+
+	return &ring;
+}
+
+static size_t drain_locked(console_emerg_write_t write)
+{
+	const void *record;
+	size_t datasize;
+	size_t total = 0;
+
+	while ((record = log_ring_peek(&ring, &datasize)) != NULL) {
+		const int rc = write(record, datasize);
+
+		if (rc < 0) {
+			break;
+		}
+
+		total += (size_t)rc;
+		log_ring_consume(&ring);
+	}
+
+	return total;
+}
+
+size_t console_emerg_drain(console_emerg_write_t write)
+{
+	if (!__atomic_load_n(&initialized, __ATOMIC_ACQUIRE)) {
+		return 0;
+	}
+	if (__atomic_exchange_n(&draining, true, __ATOMIC_ACQUIRE)) {
+		return 0;
+	}
+
+	const size_t total = drain_locked(write);
+
+	__atomic_store_n(&draining, false, __ATOMIC_RELEASE);
+
+	return total;
+}
+
+size_t console_emerg_write(const void *data, size_t len)
+{
+	struct log_ring *p = get_ring();
+	const uint8_t *ptr = (const uint8_t *)data;
+	size_t queued = 0;
+
+	while (p != NULL && queued < len) {
+		size_t n = len - queued;
+
+		if (n > CONSOLE_EMERG_SLOT_SIZE) {
+			n = CONSOLE_EMERG_SLOT_SIZE;
+		}
+		if (!log_ring_put(p, &ptr[queued], n)) {
+			break;
+		}
+
+		queued += n;
+	}
+
+	if (queued < len) {
+		__atomic_fetch_add(&dropped, (uint32_t)(len - queued),
+				__ATOMIC_RELAXED);
+	}
+
+	if (p == NULL) {
+		return 0;
+	} else if (__atomic_load_n(&panicked, __ATOMIC_ACQUIRE)) {
+		drain_locked(console_sync_write_polled);
+	} else if (!is_scheduler_running()) {
+		console_emerg_drain(console_sync_write_polled);
+	}
+
+	return queued;
+}
+
+size_t console_emerg_printf(const char *fmt, ...)
+{
+	char buf[CONSOLE_EMERG_SLOT_SIZE * 2];
+	va_list ap;
+
+	va_start(ap, fmt);
+	const int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	if (len <= 0) {
+		return 0;
+	}
+
+	return console_emerg_write(buf, ((size_t)len < sizeof(buf))?
+			(size_t)len : sizeof(buf) - 1);
+}
+
+void console_emerg_panic(void)
+{
+	if (get_ring() == NULL) {
+		return;
+	}
+
+	__atomic_store_n(&panicked, true, __ATOMIC_RELEASE);
+	/* A drain interrupted by the fault never resumes, so the consumer
+	 * side is taken over regardless of the flag. */
+	__atomic_store_n(&draining, true, __ATOMIC_RELEASE);
+	drain_locked(console_sync_write_polled);
+}
+
+uint32_t console_emerg_dropped(void)
+{
+	return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
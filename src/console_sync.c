@@ -5,17 +5,27 @@
  */
 
 #include "console_sync.h"
+#include "console_emerg.h"
 
 #include <stdio.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <sys/select.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <errno.h>
 
-#if defined(CONFIG_USE_SEGGER_RTT)
-#include <SEGGER_RTT.h>
-#elif defined(__ZEPHYR__)
+#include "libmcu/timext.h"
+
+#if defined(CONFIG_USE_SEGGER_RTT) || \
+		(defined(TARGET_PLATFORM_madi_nrf52840) && !defined(__ZEPHYR__))
+#include "rtt_channel.h"
+#elif defined(ESP_PLATFORM)
+#include "esp_rom_sys.h"
+#endif
+#if defined(__ZEPHYR__) && !defined(CONFIG_USE_SEGGER_RTT)
+#include <zephyr/kernel.h>
 #include <zephyr/devicetree.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/sys/printk.h>
@@ -31,74 +41,409 @@
 #define CONSOLE_SYNC_HAS_ZEPHYR_CONSOLE	0
 #endif
 
-static pthread_mutex_t mutex;
+/* With the interrupt-driven API the chosen console UART is driven through
+ * ring buffers instead of stdio and per-byte polling. */
+#if CONSOLE_SYNC_HAS_ZEPHYR_CONSOLE && defined(CONFIG_UART_INTERRUPT_DRIVEN) \
+		&& !defined(CONFIG_USE_SEGGER_RTT)
+#define CONSOLE_SYNC_HAS_UART_IRQ	1
+#include "console_uart.h"
+#else
+#define CONSOLE_SYNC_HAS_UART_IRQ	0
+#endif
+
+#if !defined(CONFIG_USE_SEGGER_RTT) && !CONSOLE_SYNC_HAS_UART_IRQ && \
+		!(defined(__ZEPHYR__) && !CONSOLE_SYNC_HAS_ZEPHYR_CONSOLE)
+#define CONSOLE_SYNC_HAS_STDIO		1
+#else
+#define CONSOLE_SYNC_HAS_STDIO		0
+#endif
+
+/* Writers and readers take separate locks so that a reader waiting for
+ * input never holds up log output. */
+static pthread_mutex_t tx_mutex;
+static pthread_mutex_t rx_mutex;
+
+#if CONSOLE_SYNC_HAS_STDIO
+#if !defined(CONSOLE_SYNC_FLUSH_STACK_SIZE)
+#define CONSOLE_SYNC_FLUSH_STACK_SIZE	2048U
+#endif
+
+static struct {
+	console_sync_flush_t policy;
+	size_t pending;
+	bool flusher_started;
+	pthread_t flusher;
+	char buf[CONSOLE_SYNC_BUFSIZE];
+} out;
+#endif
 
 static void lock_console(void)
 {
-	pthread_mutex_lock(&mutex);
+	pthread_mutex_lock(&tx_mutex);
 }
 
 static void unlock_console(void)
 {
-	pthread_mutex_unlock(&mutex);
+	pthread_mutex_unlock(&tx_mutex);
 }
 
-int console_sync_write(const void *data, size_t datasize)
+static void lock_input(void)
 {
-	lock_console();
+	pthread_mutex_lock(&rx_mutex);
+}
 
-	int rc = 0;
+static void unlock_input(void)
+{
+	pthread_mutex_unlock(&rx_mutex);
+}
 
-#if defined(__ZEPHYR__) && !CONSOLE_SYNC_HAS_ZEPHYR_CONSOLE
-	const uint8_t *ptr = (const uint8_t *)data;
-	for (size_t i = 0; i < datasize; i++) {
-		printk("%c", ptr[i]);
-	}
-	rc = (int)datasize;
+static int write_locked(const void *data, size_t datasize)
+{
+#if defined(CONFIG_USE_SEGGER_RTT)
+	return rtt_channel_write(RTT_CHANNEL_LOG, data, datasize);
+#elif CONSOLE_SYNC_HAS_UART_IRQ
+	return console_uart_write(data, datasize);
+#elif defined(__ZEPHYR__) && !CONSOLE_SYNC_HAS_ZEPHYR_CONSOLE
+	/* Hands the whole buffer to the printk hook at once. */
+	k_str_out((char *)(uintptr_t)data, datasize);
+	return (int)datasize;
 #else
-	rc = (int)fwrite(data, 1, datasize, stdout);
+	return (int)fwrite(data, 1, datasize, stdout);
+#endif
+}
 
-	if (rc >= 0 && datasize > 0) {
-		fflush(stdout);
+#if CONSOLE_SYNC_HAS_STDIO
+static void sync_stdout(bool sync)
+{
+	fflush(stdout);
 #if defined(__ZEPHYR__) || !defined(TARGET_PLATFORM_madi_nrf52840)
-		if (!isatty(fileno(stdout))) {
-			fsync(fileno(stdout));
+	if (sync && !isatty(fileno(stdout))) {
+		fsync(fileno(stdout));
+	}
+#else
+	(void)sync;
+#endif
+	out.pending = 0;
+}
+
+static void *flush_periodically(void *arg)
+{
+	(void)arg;
+
+	for (;;) {
+		sleep_ms(CONSOLE_SYNC_FLUSH_INTERVAL_MS);
+
+		lock_console();
+		if (out.policy == CONSOLE_SYNC_FLUSH_PERIODIC &&
+				out.pending > 0) {
+			sync_stdout(false);
+		}
+		unlock_console();
+	}
+
+	return NULL;
+}
+
+static int start_flusher(void)
+{
+	pthread_attr_t attr;
+
+	if (out.flusher_started) {
+		return 0;
+	}
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, CONSOLE_SYNC_FLUSH_STACK_SIZE);
+	int err = pthread_create(&out.flusher, &attr, flush_periodically, 0);
+	pthread_attr_destroy(&attr);
+
+	out.flusher_started = (err == 0);
+
+	return -err;
+}
+#endif
+
+static void flush_locked(size_t written)
+{
+#if CONSOLE_SYNC_HAS_STDIO
+	out.pending += written;
+
+	switch (out.policy) {
+	case CONSOLE_SYNC_FLUSH_WATERMARK:
+		if (out.pending >= CONSOLE_SYNC_HIGH_WATERMARK) {
+			sync_stdout(false);
 		}
+		break;
+	case CONSOLE_SYNC_FLUSH_PERIODIC:
+		break;
+	case CONSOLE_SYNC_FLUSH_IMMEDIATE:
+	default:
+		sync_stdout(true);
+		break;
+	}
+#else
+	(void)written;
 #endif
+}
+
+int console_sync_writev(const struct console_sync_iov *iov, size_t iovcnt)
+{
+	int total = 0;
+
+	lock_console();
+
+	/* Records queued from ISRs go out first, in order with the rest. */
+	console_emerg_drain(write_locked);
+
+	for (size_t i = 0; i < iovcnt; i++) {
+		if (iov[i].len == 0) {
+			continue;
+		}
+
+		int rc = write_locked(iov[i].base, iov[i].len);
+
+		if (rc < 0) {
+			total = (total > 0)? total : rc;
+			break;
+		}
+
+		total += rc;
+
+		if ((size_t)rc < iov[i].len) {
+			break;
+		}
 	}
+
+	if (total > 0) {
+		flush_locked((size_t)total);
+	}
+
+	unlock_console();
+
+	return total;
+}
+
+int console_sync_write(const void *data, size_t datasize)
+{
+	return console_sync_writev(&(const struct console_sync_iov) {
+		.base = data,
+		.len = datasize,
+	}, 1);
+}
+
+int console_sync_set_flush_policy(console_sync_flush_t policy)
+{
+	int err = 0;
+
+	lock_console();
+#if CONSOLE_SYNC_HAS_STDIO
+	if (policy == CONSOLE_SYNC_FLUSH_PERIODIC) {
+		err = start_flusher();
+	}
+	if (err == 0) {
+		__atomic_store_n(&out.policy, policy, __ATOMIC_RELAXED);
+		sync_stdout(false);
+	}
+#else
+	(void)policy;
 #endif
 	unlock_console();
 
-	return rc;
+	return err;
 }
 
-int console_sync_read(void *buf, size_t bufsize)
+int console_sync_flush(void)
 {
 	lock_console();
-	int rc = 0;
-#if defined(CONFIG_USE_SEGGER_RTT)
-	rc = (int)SEGGER_RTT_Read(0, buf, bufsize);
+	console_emerg_drain(write_locked);
+#if CONSOLE_SYNC_HAS_STDIO
+	sync_stdout(true);
+#endif
+	unlock_console();
+
+	return 0;
+}
+
+int console_sync_flush_panic(void)
+{
+	console_emerg_panic();
+#if CONSOLE_SYNC_HAS_STDIO
+	if (pthread_mutex_trylock(&tx_mutex) != 0) {
+		return -EBUSY;
+	}
+	sync_stdout(false);
+	unlock_console();
+#endif
+
+	return 0;
+}
+
+void console_sync_lock(void)
+{
+	lock_console();
+	/* Records queued from ISRs go out ahead of what the holder writes. */
+	console_emerg_drain(write_locked);
+}
+
+void console_sync_unlock(void)
+{
+	unlock_console();
+}
+
+console_sync_flush_t console_sync_get_flush_policy(void)
+{
+#if CONSOLE_SYNC_HAS_STDIO
+	return __atomic_load_n(&out.policy, __ATOMIC_RELAXED);
+#else
+	return CONSOLE_SYNC_FLUSH_IMMEDIATE;
+#endif
+}
+
+int console_sync_write_polled(const void *data, size_t datasize)
+{
+#if defined(CONFIG_USE_SEGGER_RTT) || \
+		(defined(TARGET_PLATFORM_madi_nrf52840) && !defined(__ZEPHYR__))
+	/* RTT writes are interrupt-safe on their own. The bare nRF5 build
+	 * has no polled stdout, so it falls back to the RTT terminal. */
+	return rtt_channel_write(RTT_CHANNEL_LOG, data, datasize);
 #elif defined(__ZEPHYR__) && CONSOLE_SYNC_HAS_ZEPHYR_CONSOLE
 	const struct device *uart = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+	const uint8_t *ptr = (const uint8_t *)data;
+
 	if (!device_is_ready(uart)) {
-		rc = -ENODEV;
-		goto out;
+		return -ENODEV;
 	}
+	for (size_t i = 0; i < datasize; i++) {
+		uart_poll_out(uart, ptr[i]);
+	}
+
+	return (int)datasize;
+#elif defined(__ZEPHYR__)
+	k_str_out((char *)(uintptr_t)data, datasize);
+	return (int)datasize;
+#elif defined(ESP_PLATFORM)
+	esp_rom_printf("%.*s", (int)datasize, (const char *)data);
+	return (int)datasize;
+#else
+	const size_t written = fwrite(data, 1, datasize, stdout);
+	fflush(stdout);
+	return (int)written;
+#endif
+}
+
+#if defined(CONFIG_USE_SEGGER_RTT) || \
+		(defined(__ZEPHYR__) && CONSOLE_SYNC_HAS_ZEPHYR_CONSOLE && \
+		 !CONSOLE_SYNC_HAS_UART_IRQ)
+/* Returns what has arrived so far without waiting. */
+static int read_available(void *buf, size_t bufsize)
+{
+#if defined(CONFIG_USE_SEGGER_RTT)
+	return rtt_channel_read(RTT_CHANNEL_LOG, buf, bufsize);
+#else
+	const struct device *uart = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
 	uint8_t *ptr = (uint8_t *)buf;
+	int rc = 0;
+
+	if (!device_is_ready(uart)) {
+		return -ENODEV;
+	}
+
 	for (size_t i = 0; i < bufsize; i++) {
-		int c = uart_poll_in(uart, &ptr[i]);
-		if (c < 0) {
-		    break;
+		if (uart_poll_in(uart, &ptr[i]) < 0) {
+			break;
 		}
 		rc++;
 	}
-out:
+
+	return rc;
+#endif
+}
+
+/* Interval between polls of consoles that cannot signal input. */
+#if !defined(CONSOLE_SYNC_POLL_INTERVAL_MS)
+#define CONSOLE_SYNC_POLL_INTERVAL_MS	10U
+#endif
+
+static int read_polled(void *buf, size_t bufsize, int32_t timeout_ms)
+{
+	uint32_t waited = 0;
+
+	for (;;) {
+		int rc = read_available(buf, bufsize);
+
+		if (rc != 0 || (timeout_ms >= 0 && waited >= (uint32_t)timeout_ms)) {
+			return rc;
+		}
+
+		sleep_ms(CONSOLE_SYNC_POLL_INTERVAL_MS);
+		waited += CONSOLE_SYNC_POLL_INTERVAL_MS;
+	}
+}
+#elif CONSOLE_SYNC_HAS_STDIO && \
+		(defined(__ZEPHYR__) || !defined(TARGET_PLATFORM_madi_nrf52840))
+static int read_stdin(void *buf, size_t bufsize, int32_t timeout_ms)
+{
+	const int fd = fileno(stdin);
+	fd_set fds;
+	struct timeval tv = {
+		.tv_sec = timeout_ms / 1000,
+		.tv_usec = (timeout_ms % 1000) * 1000,
+	};
+
+	FD_ZERO(&fds);
+	FD_SET(fd, &fds);
+
+	int rc = select(fd + 1, &fds, NULL, NULL,
+			(timeout_ms < 0)? NULL : &tv);
+	if (rc <= 0) {
+		return (rc == 0)? 0 : -errno;
+	}
+
+	ssize_t n = read(fd, buf, bufsize);
+
+	return (n < 0)? -errno : (int)n;
+}
+#endif
+
+int console_sync_read(void *buf, size_t bufsize)
+{
+	lock_input();
+	int rc = 0;
+#if defined(CONFIG_USE_SEGGER_RTT)
+	rc = read_available(buf, bufsize);
+#elif CONSOLE_SYNC_HAS_UART_IRQ
+	rc = console_uart_read(buf, bufsize, 0);
+#elif defined(__ZEPHYR__) && CONSOLE_SYNC_HAS_ZEPHYR_CONSOLE
+	rc = read_available(buf, bufsize);
 #elif defined(__ZEPHYR__)
 	rc = -ENODEV;
 #else
 	rc = (int)fread(buf, 1, bufsize, stdin);
 #endif
-	unlock_console();
+	unlock_input();
+	return rc;
+}
+
+int console_sync_read_timeout(void *buf, size_t bufsize, int32_t timeout_ms)
+{
+	lock_input();
+	int rc = 0;
+#if defined(CONFIG_USE_SEGGER_RTT)
+	rc = read_polled(buf, bufsize, timeout_ms);
+#elif CONSOLE_SYNC_HAS_UART_IRQ
+	rc = console_uart_read(buf, bufsize, timeout_ms);
+#elif defined(__ZEPHYR__) && CONSOLE_SYNC_HAS_ZEPHYR_CONSOLE
+	rc = read_polled(buf, bufsize, timeout_ms);
+#elif defined(__ZEPHYR__)
+	(void)timeout_ms;
+	rc = -ENODEV;
+#elif !defined(TARGET_PLATFORM_madi_nrf52840)
+	rc = read_stdin(buf, bufsize, timeout_ms);
+#else
+	(void)timeout_ms;
+	rc = -ENOTSUP;
+#endif
+	unlock_input();
 	return rc;
 }
 
@@ -111,16 +456,25 @@ int console_sync_init(void)
 	fcntl(fileno(stdout), F_SETFL, 0 /*| O_NONBLOCK*/);
 	fcntl(fileno(stdin), F_SETFL, 0 /*| O_NONBLOCK*/);
 
-	pthread_mutex_init(&mutex, NULL);
+	pthread_mutex_init(&tx_mutex, NULL);
+	pthread_mutex_init(&rx_mutex, NULL);
+
+#if CONSOLE_SYNC_HAS_STDIO
+	if (CONSOLE_SYNC_FLUSH_POLICY != CONSOLE_SYNC_FLUSH_IMMEDIATE) {
+		setvbuf(stdout, out.buf, _IOFBF, sizeof(out.buf));
+	}
+	console_sync_set_flush_policy(CONSOLE_SYNC_FLUSH_POLICY);
+#endif
 
 #if defined(CONFIG_USE_SEGGER_RTT)
-	volatile uint32_t *dhcsr = (uint32_t*)0xE000EDF0;
-	if (*dhcsr & 1) {
-		SEGGER_RTT_ConfigUpBuffer(0, NULL, NULL, 0,
-				SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL);
-	} else {
-		SEGGER_RTT_ConfigUpBuffer(0, NULL, NULL, 0,
-				SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+	int err = rtt_channel_init();
+	if (err != 0) {
+		return err;
+	}
+#elif CONSOLE_SYNC_HAS_UART_IRQ
+	int err = console_uart_init(DEVICE_DT_GET(DT_CHOSEN(zephyr_console)));
+	if (err != 0) {
+		return err;
 	}
 #endif
 
@@ -129,6 +483,7 @@ int console_sync_init(void)
 
 int console_sync_deinit(void)
 {
-	pthread_mutex_destroy(&mutex);
+	pthread_mutex_destroy(&rx_mutex);
+	pthread_mutex_destroy(&tx_mutex);
 	return 0;
 }
@@ -0,0 +1,336 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "log_dict.h"
+#include "logging.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+typedef enum {
+	LEN_DEFAULT,
+	LEN_CHAR,
+	LEN_SHORT,
+	LEN_LONG,
+	LEN_LONG_LONG,
+	LEN_SIZE,
+	LEN_INTMAX,
+	LEN_PTRDIFF,
+	LEN_LONG_DOUBLE,
+} length_t;
+
+struct encoder {
+	uint8_t *buf;
+	size_t bufsize;
+	size_t len;
+	bool overflow;
+};
+
+static uint32_t (*get_timestamp)(void);
+
+static void put_bytes(struct encoder *enc, const void *data, size_t datasize)
+{
+	if (enc->overflow || datasize > enc->bufsize - enc->len) {
+		enc->overflow = true;
+		return;
+	}
+
+	memcpy(&enc->buf[enc->len], data, datasize);
+	enc->len += datasize;
+}
+
+static void put_le(struct encoder *enc, uint64_t value, size_t width)
+{
+	uint8_t le[8];
+
+	for (size_t i = 0; i < width; i++) {
+		le[i] = (uint8_t)(value >> (i * 8));
+	}
+
+	put_bytes(enc, le, width);
+}
+
+static void put_string(struct encoder *enc, const char *str)
+{
+	if (str == NULL) {
+		str = "(null)";
+	}
+
+	size_t len = strnlen(str, LOG_DICT_STRING_MAXLEN);
+	put_le(enc, len, 1);
+	put_bytes(enc, str, len);
+}
+
+static const char *parse_length(const char *p, length_t *len)
+{
+	*len = LEN_DEFAULT;
+
+	switch (*p) {
+	case 'h':
+		*len = LEN_SHORT;
+		if (*++p == 'h') {
+			*len = LEN_CHAR;
+			p++;
+		}
+		break;
+	case 'l':
+		*len = LEN_LONG;
+		if (*++p == 'l') {
+			*len = LEN_LONG_LONG;
+			p++;
+		}
+		break;
+	case 'z':
+		*len = LEN_SIZE;
+		p++;
+		break;
+	case 'j':
+		*len = LEN_INTMAX;
+		p++;
+		break;
+	case 't':
+		*len = LEN_PTRDIFF;
+		p++;
+		break;
+	case 'L':
+		*len = LEN_LONG_DOUBLE;
+		p++;
+		break;
+	default:
+		break;
+	}
+
+	return p;
+}
+
+static void put_integer(struct encoder *enc, length_t len, va_list *ap)
+{
+	switch (len) {
+	case LEN_LONG:
+		put_le(enc, (uint64_t)va_arg(*ap, unsigned long),
+				sizeof(long));
+		break;
+	case LEN_LONG_LONG:
+		put_le(enc, (uint64_t)va_arg(*ap, unsigned long long),
+				sizeof(long long));
+		break;
+	case LEN_SIZE:
+		put_le(enc, (uint64_t)va_arg(*ap, size_t), sizeof(size_t));
+		break;
+	case LEN_INTMAX:
+		put_le(enc, (uint64_t)va_arg(*ap, uintmax_t),
+				sizeof(uintmax_t));
+		break;
+	case LEN_PTRDIFF:
+		put_le(enc, (uint64_t)va_arg(*ap, ptrdiff_t),
+				sizeof(ptrdiff_t));
+		break;
+	case LEN_DEFAULT:
+	case LEN_CHAR:
+	case LEN_SHORT:
+	case LEN_LONG_DOUBLE:
+	default:
+		put_le(enc, (uint64_t)va_arg(*ap, unsigned int),
+				sizeof(unsigned int));
+		break;
+	}
+}
+
+static void put_double(struct encoder *enc, length_t len, va_list *ap)
+{
+	double d = (len == LEN_LONG_DOUBLE)?
+		(double)va_arg(*ap, long double) : va_arg(*ap, double);
+	uint64_t bits;
+
+	memcpy(&bits, &d, sizeof(bits));
+	put_le(enc, bits, sizeof(bits));
+}
+
+/* Walks one conversion specification starting right after '%' and packs
+ * the arguments it consumes. Returns the position after the conversion. */
+static const char *put_conversion(struct encoder *enc, const char *p,
+		va_list *ap)
+{
+	length_t len;
+
+	while (*p && strchr("-+ #0", *p)) {
+		p++;
+	}
+	for (int i = 0; i < 2; i++) { /* width, then precision */
+		if (*p == '*') {
+			put_le(enc, (uint64_t)va_arg(*ap, unsigned int),
+					sizeof(unsigned int));
+			p++;
+		}
+		while (*p >= '0' && *p <= '9') {
+			p++;
+		}
+		if (i == 0 && *p == '.') {
+			p++;
+		} else {
+			break;
+		}
+	}
+
+	p = parse_length(p, &len);
+
+	switch (*p) {
+	case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+		put_integer(enc, len, ap);
+		break;
+	case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+	case 'a': case 'A':
+		put_double(enc, len, ap);
+		break;
+	case 's':
+		put_string(enc, va_arg(*ap, const char *));
+		break;
+	case 'p':
+		put_le(enc, (uint64_t)(uintptr_t)va_arg(*ap, void *),
+				sizeof(void *));
+		break;
+	case 'n':
+		(void)va_arg(*ap, void *);
+		break;
+	case '\0':
+		return p;
+	default:
+		break;
+	}
+
+	return p + 1;
+}
+
+static bool is_special(uint8_t c)
+{
+	return c == LOG_DICT_SYNC || c == LOG_DICT_ESC || c == '\n';
+}
+
+static size_t frame(uint8_t *buf, size_t bufsize,
+		const uint8_t *record, size_t len)
+{
+	size_t n = 0;
+
+	if (bufsize == 0) {
+		return 0;
+	}
+
+	buf[n++] = LOG_DICT_SYNC;
+
+	for (size_t i = 0; i < len; i++) {
+		const bool escape = is_special(record[i]);
+
+		if (n + (escape? 2U : 1U) > bufsize) {
+			return 0;
+		}
+		if (escape) {
+			buf[n++] = LOG_DICT_ESC;
+			buf[n++] = (uint8_t)(record[i] ^ 0x20U);
+		} else {
+			buf[n++] = record[i];
+		}
+	}
+
+	return n;
+}
+
+size_t log_dict_encode(void *buf, size_t bufsize, logging_t type,
+		const char *fmt, va_list ap)
+{
+	uint8_t record[LOG_DICT_RECORD_MAXLEN];
+	struct encoder enc = {
+		.buf = record,
+		.bufsize = sizeof(record),
+	};
+	const uint32_t timestamp = get_timestamp? get_timestamp() : 0;
+	va_list args;
+
+	put_le(&enc, (uint64_t)type, 1);
+	put_le(&enc, 0, 2); /* length, filled below */
+	put_le(&enc, timestamp, 4);
+	put_le(&enc, (uint64_t)(uintptr_t)fmt, 4);
+
+	va_copy(args, ap);
+	for (const char *p = fmt; *p;) {
+		if (*p++ != '%') {
+			continue;
+		}
+		if (*p == '%') {
+			p++;
+			continue;
+		}
+		p = put_conversion(&enc, p, &args);
+	}
+	va_end(args);
+
+	if (enc.overflow) {
+		return 0;
+	}
+
+	const size_t payload = enc.len - LOG_DICT_HDR_SIZE;
+	record[1] = (uint8_t)payload;
+	record[2] = (uint8_t)(payload >> 8);
+
+	return frame((uint8_t *)buf, bufsize, record, enc.len);
+}
+
+size_t log_dict_decode(void *buf, size_t bufsize, const void *frame,
+		size_t len)
+{
+	const uint8_t *p = (const uint8_t *)frame;
+	uint8_t *out = (uint8_t *)buf;
+	size_t n = 0;
+
+	if (len == 0 || p[0] != LOG_DICT_SYNC) {
+		return 0;
+	}
+
+	for (size_t i = 1; i < len; i++) {
+		uint8_t c = p[i];
+
+		if (c == LOG_DICT_SYNC || c == '\n') {
+			return 0;
+		} else if (c == LOG_DICT_ESC) {
+			if (++i >= len || !is_special((uint8_t)(p[i] ^ 0x20U))) {
+				return 0;
+			}
+			c = (uint8_t)(p[i] ^ 0x20U);
+		}
+
+		if (n >= bufsize) {
+			return 0;
+		}
+		out[n++] = c;
+	}
+
+	if (n < LOG_DICT_HDR_SIZE ||
+			n - LOG_DICT_HDR_SIZE != ((size_t)out[2] << 8 | out[1])) {
+		return 0;
+	}
+
+	return n;
+}
+
+size_t log_dict_save(logging_t type, const char *fmt, ...)
+{
+	uint8_t buf[LOG_DICT_FRAME_MAXLEN];
+	va_list ap;
+
+	va_start(ap, fmt);
+	size_t len = log_dict_encode(buf, sizeof(buf), type, fmt, ap);
+	va_end(ap);
+
+	if (len == 0) {
+		return 0;
+	}
+
+	return logging_write_encoded(buf, len);
+}
+
+void log_dict_init(uint32_t (*get_time)(void))
+{
+	get_timestamp = get_time;
+}
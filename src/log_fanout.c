@@ -0,0 +1,296 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "log_fanout.h"
+#include "log_line.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "libmcu/board.h"
+
+#if LOG_FANOUT_BATCH_SIZE < LOGGING_MESSAGE_MAXLEN + 1
+#error "LOG_FANOUT_BATCH_SIZE must hold the longest line"
+#endif
+
+/* Each queued line is prefixed by this header. Lines never wrap around the
+ * end of the batch buffer but may wrap around the end of the queue. */
+struct entry {
+	uint32_t stamp;
+	uint32_t len;
+};
+
+struct sink {
+	struct log_sink cfg;
+	struct log_sink_stats stats;
+
+	pthread_mutex_t lock;
+	sem_t wakeup;
+	bool wakeup_pending;
+	pthread_t thread;
+
+	size_t head; /* next byte to read */
+	size_t used;
+	uint8_t queue[LOG_FANOUT_QUEUE_SIZE];
+	char batch[LOG_FANOUT_BATCH_SIZE];
+};
+
+static struct sink sinks[LOG_FANOUT_MAX_SINKS];
+static int nr_sinks;
+
+static void copy_in(struct sink *s, size_t offset, const void *data,
+		size_t len)
+{
+	const size_t pos = (s->head + offset) % sizeof(s->queue);
+	const size_t first = (len < sizeof(s->queue) - pos)?
+		len : sizeof(s->queue) - pos;
+
+	memcpy(&s->queue[pos], data, first);
+	memcpy(s->queue, (const uint8_t *)data + first, len - first);
+}
+
+static void copy_out(const struct sink *s, size_t offset, void *buf,
+		size_t len)
+{
+	const size_t pos = (s->head + offset) % sizeof(s->queue);
+	const size_t first = (len < sizeof(s->queue) - pos)?
+		len : sizeof(s->queue) - pos;
+
+	memcpy(buf, &s->queue[pos], first);
+	memcpy((uint8_t *)buf + first, s->queue, len - first);
+}
+
+static void pop(struct sink *s, struct entry *entry)
+{
+	const size_t n = sizeof(*entry) + entry->len;
+
+	s->head = (s->head + n) % sizeof(s->queue);
+	s->used -= n;
+}
+
+static bool push(struct sink *s, const char *text, size_t len, uint32_t now)
+{
+	const size_t need = sizeof(struct entry) + len + 1;
+	struct entry entry;
+
+	if (len + 1 > sizeof(s->batch) || need > sizeof(s->queue)) {
+		s->stats.dropped++;
+		return false;
+	}
+
+	while (s->used + need > sizeof(s->queue)) {
+		s->stats.dropped++;
+		if (s->cfg.policy != LOG_FANOUT_DROP_OLDEST) {
+			return false;
+		}
+		copy_out(s, 0, &entry, sizeof(entry));
+		pop(s, &entry);
+	}
+
+	entry = (struct entry) { .stamp = now, .len = (uint32_t)len + 1 };
+	copy_in(s, s->used, &entry, sizeof(entry));
+	copy_in(s, s->used + sizeof(entry), text, len);
+	copy_in(s, s->used + sizeof(entry) + len, "\n", 1);
+	s->used += need;
+
+	if (s->used > s->stats.queue_peak) {
+		s->stats.queue_peak = (uint32_t)s->used;
+	}
+
+	return true;
+}
+
+/* Moves as many whole lines as fit into the batch buffer. Returns the
+ * batch length, and the number and the oldest stamp of its lines. */
+static size_t fill_batch(struct sink *s, uint32_t *lines, uint32_t *oldest)
+{
+	struct entry entry;
+	size_t len = 0;
+
+	*lines = 0;
+
+	while (s->used > 0) {
+		copy_out(s, 0, &entry, sizeof(entry));
+		if (len + entry.len > sizeof(s->batch)) {
+			break;
+		}
+		if (*lines == 0) {
+			*oldest = entry.stamp;
+		}
+
+		copy_out(s, sizeof(entry), &s->batch[len], entry.len);
+		pop(s, &entry);
+		len += entry.len;
+		(*lines)++;
+	}
+
+	return len;
+}
+
+static void update_stats(struct sink *s, size_t len, size_t written,
+		uint32_t lines, uint32_t latency)
+{
+	s->stats.batches++;
+
+	if (written < len) {
+		s->stats.dropped += lines;
+		return;
+	}
+
+	s->stats.lines += lines;
+	if (latency > s->stats.latency_max_ms) {
+		s->stats.latency_max_ms = latency;
+	}
+	s->stats.latency_avg_ms = (s->stats.latency_avg_ms * 7U + latency) / 8U;
+}
+
+static void *drain(void *arg)
+{
+	struct sink *s = (struct sink *)arg;
+
+	for (;;) {
+		sem_wait(&s->wakeup);
+		__atomic_store_n(&s->wakeup_pending, false, __ATOMIC_RELEASE);
+
+		for (;;) {
+			uint32_t lines;
+			uint32_t oldest = 0;
+
+			pthread_mutex_lock(&s->lock);
+			const size_t len = fill_batch(s, &lines, &oldest);
+			pthread_mutex_unlock(&s->lock);
+
+			if (len == 0) {
+				break;
+			}
+
+			const size_t written = s->cfg.write(s->batch, len);
+			const uint32_t latency =
+				board_get_time_since_boot_ms() - oldest;
+
+			pthread_mutex_lock(&s->lock);
+			update_stats(s, len, written, lines, latency);
+			pthread_mutex_unlock(&s->lock);
+		}
+	}
+
+	return NULL;
+}
+
+size_t log_fanout_write(const char *text, size_t len)
+{
+	const int n = __atomic_load_n(&nr_sinks, __ATOMIC_ACQUIRE);
+	const uint32_t now = board_get_time_since_boot_ms();
+	struct log_line line;
+	bool taken = false;
+
+	log_line_parse(&line, text, len);
+
+	for (int i = 0; i < n; i++) {
+		struct sink *s = &sinks[i];
+		const logging_t level =
+			__atomic_load_n(&s->cfg.level, __ATOMIC_RELAXED);
+
+		if (line.level < level) {
+			continue;
+		}
+
+		pthread_mutex_lock(&s->lock);
+		const bool queued = push(s, text, len, now);
+		pthread_mutex_unlock(&s->lock);
+
+		if (!queued) {
+			continue;
+		}
+
+		taken = true;
+		if (!__atomic_exchange_n(&s->wakeup_pending, true,
+				__ATOMIC_ACQ_REL)) {
+			sem_post(&s->wakeup);
+		}
+	}
+
+	return taken? len : 0;
+}
+
+int log_fanout_set_level(int id, logging_t level)
+{
+	if (id < 0 || id >= __atomic_load_n(&nr_sinks, __ATOMIC_ACQUIRE)) {
+		return -EINVAL;
+	}
+
+	__atomic_store_n(&sinks[id].cfg.level, level, __ATOMIC_RELAXED);
+
+	return 0;
+}
+
+int log_fanout_stats(int id, struct log_sink_stats *stats)
+{
+	if (id < 0 || id >= __atomic_load_n(&nr_sinks, __ATOMIC_ACQUIRE)) {
+		return -EINVAL;
+	}
+
+	struct sink *s = &sinks[id];
+
+	pthread_mutex_lock(&s->lock);
+	*stats = s->stats;
+	pthread_mutex_unlock(&s->lock);
+
+	return 0;
+}
+
+int log_fanout_add(const struct log_sink *sink)
+{
+	static pthread_mutex_t add_lock = PTHREAD_MUTEX_INITIALIZER;
+	pthread_attr_t attr;
+	int err = 0;
+
+	if (sink == NULL || sink->write == NULL) {
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&add_lock);
+
+	const int id = nr_sinks;
+
+	if (id >= (int)LOG_FANOUT_MAX_SINKS) {
+		err = -ENOSPC;
+		goto out;
+	}
+
+	struct sink *s = &sinks[id];
+	*s = (struct sink) { .cfg = *sink, };
+
+	if (pthread_mutex_init(&s->lock, NULL) != 0 ||
+			sem_init(&s->wakeup, 0, 0) != 0) {
+		err = -ENOMEM;
+		goto out;
+	}
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, LOG_FANOUT_STACK_SIZE);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedparam(&attr, &(struct sched_param) {
+		.sched_priority = LOG_FANOUT_PRIORITY,
+	});
+
+	err = -pthread_create(&s->thread, &attr, drain, s);
+	pthread_attr_destroy(&attr);
+
+	if (err != 0) {
+		sem_destroy(&s->wakeup);
+		pthread_mutex_destroy(&s->lock);
+		goto out;
+	}
+
+	__atomic_store_n(&nr_sinks, id + 1, __ATOMIC_RELEASE);
+out:
+	pthread_mutex_unlock(&add_lock);
+	return err == 0? id : err;
+}
@@ -0,0 +1,138 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "log_line.h"
+#include "log_dict.h"
+#include "log_retained.h"
+#include <string.h>
+
+/* The timestamp and level prefix is short; do not scan the message. */
+#define PREFIX_SCAN_MAXLEN		24U
+
+static logging_t parse_level(char c)
+{
+	switch (c) {
+	case 'D':
+		return LOGGING_TYPE_DEBUG;
+	case 'I':
+		return LOGGING_TYPE_INFO;
+	case 'W':
+		return LOGGING_TYPE_WARN;
+	case 'E':
+		return LOGGING_TYPE_ERROR;
+	default:
+		return LOGGING_TYPE_NONE;
+	}
+}
+
+/* Fields of a dictionary frame are found by counting the record bytes
+ * behind the escapes: the level is record byte 0, the format address at
+ * LOG_DICT_FMT_OFFSET is the call site, and the body runs from there to
+ * the end, skipping the timestamp. */
+#define LOG_DICT_FMT_OFFSET		7U
+#define LOG_DICT_FMT_SIZE		4U
+
+static void parse_dict(struct log_line *line, const char *text, size_t len)
+{
+	size_t pos = 0; /* record byte at text[i] */
+
+	for (size_t i = 1; i < len; i++, pos++) {
+		const size_t at = i;
+		uint8_t c = (uint8_t)text[i];
+
+		if (c == LOG_DICT_ESC && i + 1 < len) {
+			c = (uint8_t)(text[++i] ^ 0x20);
+		}
+
+		if (pos == 0) {
+			line->replayed = (c & LOG_DICT_REPLAYED) != 0;
+			c &= (uint8_t)~LOG_DICT_REPLAYED;
+			line->level = (c < (uint8_t)LOGGING_TYPE_NONE)?
+				(logging_t)c : LOGGING_TYPE_NONE;
+		} else if (pos == LOG_DICT_FMT_OFFSET) {
+			line->body = &text[at];
+			line->body_len = len - at;
+			line->site = &text[at];
+		} else if (pos == LOG_DICT_FMT_OFFSET + LOG_DICT_FMT_SIZE - 1) {
+			line->site_len = i + 1 - (size_t)(line->site - text);
+			break;
+		}
+	}
+}
+
+static bool has_tag(const char *p, const char *end)
+{
+	const size_t taglen = sizeof(LOG_RETAINED_TAG) - 1;
+
+	while (p < end && *p == ' ') {
+		p++;
+	}
+
+	return (size_t)(end - p) >= taglen &&
+		memcmp(p, LOG_RETAINED_TAG, taglen) == 0;
+}
+
+void log_line_parse(struct log_line *line, const char *text, size_t len)
+{
+	const char *end = text + len;
+	const char *p = (const char *)memchr(text, '[',
+			len < PREFIX_SCAN_MAXLEN? len : PREFIX_SCAN_MAXLEN);
+
+	*line = (struct log_line) {
+		.level = LOGGING_TYPE_NONE,
+		.site = text,
+		.site_len = len,
+		.body = text,
+		.body_len = len,
+	};
+
+	if (len > 0 && (uint8_t)text[0] == LOG_DICT_SYNC) {
+		parse_dict(line, text, len);
+		return;
+	}
+
+	if (p == NULL || p + 1 >= end) {
+		return;
+	}
+
+	line->level = parse_level(p[1]);
+	line->body = p;
+	line->body_len = (size_t)(end - p);
+
+	if ((p = (const char *)memchr(p, ']', (size_t)(end - p))) == NULL) {
+		return;
+	}
+	for (p++; p < end && *p == ' '; p++) {
+		/* skip spaces */
+	}
+
+	const char *site_end;
+	if (p < end && *p == '<' && (site_end = (const char *)
+			memchr(p, '>', (size_t)(end - p))) != NULL) {
+		line->site = p;
+		line->site_len = (size_t)(site_end - p) + 1;
+	} else {
+		line->site = p;
+		line->site_len = (size_t)(end - p);
+	}
+
+	/* The tag follows the call site, or is taken for it when there is
+	 * none. */
+	line->replayed = has_tag(line->site, end) ||
+		has_tag(line->site + line->site_len, end);
+}
+
+uint32_t log_line_hash(const char *data, size_t len)
+{
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= (uint8_t)data[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
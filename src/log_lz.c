@@ -0,0 +1,192 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "log_lz.h"
+#include <string.h>
+
+#define MIN_MATCH		4U
+/* The format requires the last match to start at least 12 bytes before
+ * the end of the block and the last 5 bytes to be literals. */
+#define MATCH_LIMIT		12U
+#define LAST_LITERALS		5U
+#define MAX_OFFSET		65535U
+#define RUN_MASK		15U
+
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint32_t hash(uint32_t v)
+{
+	return (v * 2654435761U) >> (32U - LOG_LZ_HASH_BITS);
+}
+
+static uint8_t *put_length(uint8_t *op, size_t len)
+{
+	for (; len >= 255U; len -= 255U) {
+		*op++ = 255U;
+	}
+	*op++ = (uint8_t)len;
+	return op;
+}
+
+static uint8_t *put_sequence(uint8_t *op, const uint8_t *oend,
+		const uint8_t *literals, size_t nliterals,
+		size_t offset, size_t match_len)
+{
+	const size_t worst = 1U + nliterals + nliterals / 255U + 1U +
+		2U + match_len / 255U + 1U;
+
+	if (worst > (size_t)(oend - op)) {
+		return NULL;
+	}
+
+	uint8_t *token = op++;
+	*token = (uint8_t)((nliterals < RUN_MASK? nliterals : RUN_MASK) << 4);
+	if (nliterals >= RUN_MASK) {
+		op = put_length(op, nliterals - RUN_MASK);
+	}
+	memcpy(op, literals, nliterals);
+	op += nliterals;
+
+	if (match_len == 0) { /* the last sequence has literals only */
+		return op;
+	}
+
+	*op++ = (uint8_t)offset;
+	*op++ = (uint8_t)(offset >> 8);
+
+	match_len -= MIN_MATCH;
+	*token |= (uint8_t)(match_len < RUN_MASK? match_len : RUN_MASK);
+	if (match_len >= RUN_MASK) {
+		op = put_length(op, match_len - RUN_MASK);
+	}
+
+	return op;
+}
+
+size_t log_lz_compress(const void *src, size_t srclen,
+		void *dst, size_t dstcap, uint16_t *table)
+{
+	const uint8_t *in = (const uint8_t *)src;
+	uint8_t *op = (uint8_t *)dst;
+	const uint8_t *oend = op + dstcap;
+	size_t anchor = 0;
+	size_t i = 0;
+
+	if (srclen > 0x10000U) {
+		return 0;
+	}
+
+	memset(table, 0, LOG_LZ_TABLE_LEN * sizeof(*table));
+
+	while (srclen > MATCH_LIMIT && i < srclen - MATCH_LIMIT) {
+		const uint32_t h = hash(read32(&in[i]));
+		const size_t candidate = table[h];
+
+		table[h] = (uint16_t)i;
+
+		if (candidate >= i || i - candidate > MAX_OFFSET ||
+				read32(&in[candidate]) != read32(&in[i])) {
+			i++;
+			continue;
+		}
+
+		size_t len = MIN_MATCH;
+		while (i + len < srclen - LAST_LITERALS &&
+				in[candidate + len] == in[i + len]) {
+			len++;
+		}
+
+		op = put_sequence(op, oend, &in[anchor], i - anchor,
+				i - candidate, len);
+		if (op == NULL) {
+			return 0;
+		}
+
+		i += len;
+		anchor = i;
+	}
+
+	op = put_sequence(op, oend, &in[anchor], srclen - anchor, 0, 0);
+	if (op == NULL) {
+		return 0;
+	}
+
+	return (size_t)(op - (uint8_t *)dst);
+}
+
+static const uint8_t *get_length(const uint8_t *ip, const uint8_t *iend,
+		size_t *len)
+{
+	uint8_t b;
+
+	do {
+		if (ip >= iend) {
+			return NULL;
+		}
+		b = *ip++;
+		*len += b;
+	} while (b == 255U);
+
+	return ip;
+}
+
+int log_lz_decompress(const void *src, size_t srclen,
+		void *dst, size_t dstcap)
+{
+	const uint8_t *ip = (const uint8_t *)src;
+	const uint8_t *iend = ip + srclen;
+	uint8_t *op = (uint8_t *)dst;
+	const uint8_t *oend = op + dstcap;
+
+	while (ip < iend) {
+		const uint8_t token = *ip++;
+		size_t len = token >> 4;
+
+		if (len == RUN_MASK && (ip = get_length(ip, iend, &len)) == NULL) {
+			return -1;
+		}
+		if (len > (size_t)(iend - ip) || len > (size_t)(oend - op)) {
+			return -1;
+		}
+		memcpy(op, ip, len);
+		ip += len;
+		op += len;
+
+		if (ip == iend) {
+			break;
+		}
+		if (iend - ip < 2) {
+			return -1;
+		}
+
+		const size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (size_t)(op - (uint8_t *)dst)) {
+			return -1;
+		}
+
+		len = token & RUN_MASK;
+		if (len == RUN_MASK && (ip = get_length(ip, iend, &len)) == NULL) {
+			return -1;
+		}
+		len += MIN_MATCH;
+		if (len > (size_t)(oend - op)) {
+			return -1;
+		}
+
+		/* byte by byte: the match may overlap the bytes being written */
+		for (const uint8_t *match = op - offset; len > 0; len--) {
+			*op++ = *match++;
+		}
+	}
+
+	return (int)(op - (uint8_t *)dst);
+}
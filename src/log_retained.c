@@ -0,0 +1,190 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "log_retained.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "logging.h"
+
+#if !defined(LIBMCU_NOINIT)
+#define LIBMCU_NOINIT	__attribute__((section(".noinit.libmcu")))
+#endif
+
+#define RETAINED_MAGIC	0x4C4F4752U /* "LOGR" */
+
+struct retained {
+	uint32_t magic;
+	uint32_t head; /* offset of the next byte to write */
+	uint32_t used; /* bytes holding lines, up to LOG_RETAINED_SIZE */
+	uint32_t crc;
+	char data[LOG_RETAINED_SIZE];
+};
+
+static struct retained retained LIBMCU_NOINIT;
+static bool enabled;
+static bool busy;
+
+static uint32_t crc32(const void *data, size_t len)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	uint32_t crc = 0xFFFFFFFFU;
+
+	for (size_t i = 0; i < len; i++) {
+		crc ^= p[i];
+		for (int k = 0; k < 8; k++) {
+			crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+		}
+	}
+
+	return ~crc;
+}
+
+static uint32_t compute_header_crc(const struct retained *r)
+{
+	return crc32(r, offsetof(struct retained, crc));
+}
+
+static bool is_valid(const struct retained *r)
+{
+	return r->magic == RETAINED_MAGIC &&
+		r->head < LOG_RETAINED_SIZE &&
+		r->used <= LOG_RETAINED_SIZE &&
+		r->crc == compute_header_crc(r);
+}
+
+static void reset(struct retained *r)
+{
+	r->magic = RETAINED_MAGIC;
+	r->head = 0;
+	r->used = 0;
+	r->crc = compute_header_crc(r);
+}
+
+static void put(struct retained *r, const char *data, size_t len)
+{
+	while (len > 0) {
+		size_t chunk = LOG_RETAINED_SIZE - r->head;
+		chunk = (chunk < len)? chunk : len;
+
+		memcpy(&r->data[r->head], data, chunk);
+		r->head = (uint32_t)((r->head + chunk) % LOG_RETAINED_SIZE);
+		data += chunk;
+		len -= chunk;
+	}
+}
+
+/* Copies the retained bytes oldest first. When the ring has wrapped, the
+ * oldest line is usually cut, and a reset in the middle of a write can
+ * leave a fragment there too, so everything up to the first newline is
+ * skipped. */
+size_t log_retained_read(char *buf, size_t bufsize)
+{
+	const struct retained *r = &retained;
+	size_t start = (r->head + LOG_RETAINED_SIZE - r->used) %
+			LOG_RETAINED_SIZE;
+	size_t avail = r->used;
+	size_t len = 0;
+
+	if (avail == LOG_RETAINED_SIZE) {
+		while (avail > 0 && r->data[start] != '\n') {
+			start = (start + 1) % LOG_RETAINED_SIZE;
+			avail--;
+		}
+		if (avail > 0) { /* the newline itself */
+			start = (start + 1) % LOG_RETAINED_SIZE;
+			avail--;
+		}
+	}
+
+	while (len < avail && len < bufsize) {
+		buf[len++] = r->data[start];
+		start = (start + 1) % LOG_RETAINED_SIZE;
+	}
+
+	return len;
+}
+
+void log_retained_write(const char *text, size_t len)
+{
+	struct retained *r = &retained;
+
+	if (!enabled || len == 0 || len >= LOG_RETAINED_SIZE ||
+			__atomic_exchange_n(&busy, true, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	/* Data first, header last: a reset in between leaves the header
+	 * describing the previous, consistent state. */
+	put(r, text, len);
+	put(r, "\n", 1);
+
+	r->used = (uint32_t)((r->used + len + 1 > LOG_RETAINED_SIZE)?
+			LOG_RETAINED_SIZE : r->used + len + 1);
+	r->crc = compute_header_crc(r);
+
+	__atomic_store_n(&busy, false, __ATOMIC_RELEASE);
+}
+
+/* Dictionary frames are logged again as they are, keeping their
+ * original timestamp, with the replayed flag set. Text is tagged and made
+ * printable. */
+static void replay(char *line, size_t len)
+{
+#if defined(LOGGING_DICTIONARY)
+	if ((uint8_t)line[0] == LOG_DICT_SYNC && len > 1) {
+		line[1] = (char)((uint8_t)line[1] | LOG_DICT_REPLAYED);
+		logging_write_encoded(line, len);
+		return;
+	}
+#endif
+	for (size_t i = 0; i < len; i++) {
+		if (line[i] < ' ' || line[i] > '~') {
+			line[i] = '?';
+		}
+	}
+
+	info(LOG_RETAINED_TAG " %.*s", (int)len, line);
+}
+
+size_t log_retained_init(void)
+{
+	static char line[LOGGING_MESSAGE_MAXLEN];
+	size_t count = 0;
+
+	if (is_valid(&retained)) {
+		const struct retained *r = &retained;
+		size_t start = (r->head + LOG_RETAINED_SIZE - r->used) %
+				LOG_RETAINED_SIZE;
+		/* When the ring has wrapped the oldest line is cut. */
+		bool skip = r->used == LOG_RETAINED_SIZE;
+		size_t len = 0;
+
+		for (size_t i = 0; i < r->used; i++) {
+			const char c = r->data[(start + i) % LOG_RETAINED_SIZE];
+
+			if (c != '\n') {
+				if (!skip && len < sizeof(line)) {
+					line[len++] = c;
+				}
+				continue;
+			}
+			if (!skip && len > 0) {
+				replay(line, len);
+				count++;
+			}
+			skip = false;
+			len = 0;
+		}
+	}
+
+	reset(&retained);
+	enabled = true;
+
+	return count;
+}
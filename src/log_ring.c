@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "log_ring.h"
+#include <string.h>
+
+/* Each slot carries a sequence number that tells its owner. A slot at
+ * position pos is free for the producer when seq == pos, and committed for
+ * the consumer when seq == pos + 1. The consumer hands it back for the next
+ * lap by setting seq to pos + slot_count. */
+struct slot {
+	uint32_t seq;
+	uint32_t len;
+	uint8_t data[];
+};
+
+static struct slot *get_slot(const struct log_ring *ring, uint32_t pos)
+{
+	return (struct slot *)(void *)
+		&ring->mem[(pos & ring->mask) * ring->stride];
+}
+
+bool log_ring_put(struct log_ring *ring, const void *data, size_t datasize)
+{
+	if (datasize > ring->slot_size) {
+		return false;
+	}
+
+	uint32_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+	struct slot *slot;
+
+	for (;;) {
+		slot = get_slot(ring, pos);
+		uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		int32_t diff = (int32_t)(seq - pos);
+
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&ring->head, &pos,
+					pos + 1, true, __ATOMIC_RELAXED,
+					__ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (diff < 0) {
+			return false; /* full */
+		} else {
+			pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+		}
+	}
+
+	memcpy(slot->data, data, datasize);
+	slot->len = (uint32_t)datasize;
+	__atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+const void *log_ring_peek(struct log_ring *ring, size_t *datasize)
+{
+	const uint32_t pos = ring->tail;
+	struct slot *slot = get_slot(ring, pos);
+
+	if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+		return NULL;
+	}
+
+	if (datasize) {
+		*datasize = slot->len;
+	}
+
+	return slot->data;
+}
+
+void log_ring_consume(struct log_ring *ring)
+{
+	const uint32_t pos = ring->tail;
+	struct slot *slot = get_slot(ring, pos);
+
+	__atomic_store_n(&slot->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&ring->tail, pos + 1, __ATOMIC_RELEASE);
+}
+
+size_t log_ring_count(const struct log_ring *ring)
+{
+	return (size_t)(__atomic_load_n(&ring->head, __ATOMIC_RELAXED) -
+			__atomic_load_n(&ring->tail, __ATOMIC_RELAXED));
+}
+
+size_t log_ring_capacity(const struct log_ring *ring)
+{
+	return (size_t)ring->mask + 1;
+}
+
+int log_ring_init(struct log_ring *ring, void *mem, size_t memsize,
+		size_t slot_size)
+{
+	const uint32_t stride = LOG_RING_SLOT_STRIDE((uint32_t)slot_size);
+	size_t count = 1;
+
+	if (ring == NULL || mem == NULL || ((uintptr_t)mem & 3U) != 0 ||
+			memsize < stride) {
+		return -1;
+	}
+
+	while (count * 2 * stride <= memsize) {
+		count *= 2;
+	}
+
+	*ring = (struct log_ring) {
+		.mem = (uint8_t *)mem,
+		.stride = stride,
+		.slot_size = (uint32_t)slot_size,
+		.mask = (uint32_t)count - 1,
+	};
+
+	for (uint32_t i = 0; i < (uint32_t)count; i++) {
+		get_slot(ring, i)->seq = i;
+	}
+
+	return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "log_staging.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "libmcu/logging.h"
+
+#if LOG_STAGING_COUNT > 32
+#error "LOG_STAGING_COUNT must not exceed 32"
+#endif
+
+#define ALL_FREE	((uint32_t)(((uint64_t)1 << LOG_STAGING_COUNT) - 1))
+
+static char pool[LOG_STAGING_COUNT][LOGGING_MESSAGE_MAXLEN];
+static uint32_t free_mask = ALL_FREE;
+
+char *log_staging_acquire(size_t *bufsize)
+{
+	uint32_t mask = __atomic_load_n(&free_mask, __ATOMIC_RELAXED);
+
+	while (mask != 0) {
+		const uint32_t index = (uint32_t)__builtin_ctz(mask);
+
+		if (__atomic_compare_exchange_n(&free_mask, &mask,
+				mask & ~(1U << index), true,
+				__ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			*bufsize = sizeof(pool[index]);
+			return pool[index];
+		}
+	}
+
+	return NULL;
+}
+
+void log_staging_release(char *buf)
+{
+	const uint32_t index = (uint32_t)((size_t)(buf - pool[0]) /
+			sizeof(pool[0]));
+
+	__atomic_fetch_or(&free_mask, 1U << index, __ATOMIC_RELEASE);
+}
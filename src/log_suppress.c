@@ -0,0 +1,140 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "log_suppress.h"
+#include "log_line.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "libmcu/board.h"
+#include "libmcu/metrics.h"
+
+#if (LOG_SUPPRESS_SITES & (LOG_SUPPRESS_SITES - 1)) != 0
+#error "LOG_SUPPRESS_SITES must be a power of two"
+#endif
+
+/* Tokens are kept in milli-tokens so that refilling at LOG_SUPPRESS_RATE
+ * per second is an integer multiply of the elapsed milliseconds. */
+#define TOKEN_UNIT			1000U
+#define BUCKET_MAX			(LOG_SUPPRESS_BURST * TOKEN_UNIT)
+/* Idle time that refills an empty bucket. Anything longer is clamped to it
+ * so that the multiply cannot overflow. */
+#define REFILL_MS_MAX			(BUCKET_MAX / LOG_SUPPRESS_RATE + 1U)
+
+struct site {
+	uint32_t key;
+	uint32_t tokens;
+	uint32_t refilled_at;
+};
+
+struct suppress {
+	struct site sites[LOG_SUPPRESS_SITES];
+	uint32_t last_key;
+	uint32_t repeats;
+	uint32_t repeat_reported_at;
+};
+
+static struct suppress state;
+/* Held for a hash compare and a bucket update, so loggers racing on a
+ * fault storm wait a moment rather than slipping past the limits. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool take_token(struct site *site, uint32_t key, uint32_t now)
+{
+	if (site->key != key) { /* new call site or evicted by a collision */
+		site->key = key;
+		site->tokens = BUCKET_MAX;
+		site->refilled_at = now;
+	} else {
+		uint32_t elapsed = now - site->refilled_at;
+		elapsed = (elapsed > REFILL_MS_MAX)? REFILL_MS_MAX : elapsed;
+		const uint32_t refill = elapsed * LOG_SUPPRESS_RATE;
+
+		if (refill > 0) {
+			site->tokens = (refill >= BUCKET_MAX - site->tokens)?
+				BUCKET_MAX : site->tokens + refill;
+			site->refilled_at = now;
+		}
+	}
+
+	if (site->tokens < TOKEN_UNIT) {
+		return false;
+	}
+
+	site->tokens -= TOKEN_UNIT;
+	return true;
+}
+
+bool log_suppress_check(const char *text, size_t len, uint32_t *repeats)
+{
+	struct log_line line;
+	bool duplicate = false;
+	bool pass = true;
+
+	*repeats = 0;
+	log_line_parse(&line, text, len);
+
+	/* Replayed lines went through here on the boot they were logged on.
+	 * They all share one call site, so the bucket would cut the replay
+	 * short. */
+	if (line.replayed) {
+		return true;
+	}
+
+	pthread_mutex_lock(&lock);
+
+	const uint32_t now = board_get_time_since_boot_ms();
+	const uint32_t key = log_line_hash(line.body, line.body_len);
+
+	if (key == state.last_key) {
+		state.repeats++;
+		duplicate = true;
+		pass = false;
+
+		if (now - state.repeat_reported_at >= LOG_SUPPRESS_REPORT_MS) {
+			*repeats = state.repeats;
+			state.repeats = 0;
+			state.repeat_reported_at = now;
+		}
+	} else {
+		const uint32_t site_key =
+			log_line_hash(line.site, line.site_len);
+		struct site *site =
+			&state.sites[site_key & (LOG_SUPPRESS_SITES - 1)];
+
+		pass = take_token(site, site_key, now);
+
+		/* A line dropped by the rate limit is not the one later
+		 * repeats refer to, so it does not start a new run. */
+		*repeats = state.repeats;
+		state.last_key = pass? key : 0;
+		state.repeats = 0;
+		state.repeat_reported_at = now;
+	}
+
+	pthread_mutex_unlock(&lock);
+
+	if (duplicate) {
+		metrics_increase(LogSuppressedCount);
+	} else if (!pass) {
+		metrics_increase(LogRateLimitedCount);
+	}
+
+	return pass;
+}
+
+size_t log_suppress_stringify(char *buf, size_t bufsize, uint32_t repeats)
+{
+	int len = snprintf(buf, bufsize, "... repeated %lu times",
+			(unsigned long)repeats);
+
+	if (len < 0) {
+		return 0;
+	}
+
+	return ((size_t)len < bufsize)? (size_t)len : bufsize - 1;
+}
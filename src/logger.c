@@ -6,27 +6,200 @@
 
 #include "logging.h"
 #include "console_sync.h"
+#include "log_fanout.h"
+#include "log_line.h"
+#include "log_ring.h"
+#include "log_retained.h"
+#include "log_staging.h"
+#include "log_suppress.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "libmcu/metrics.h"
+
+#if !defined(LOGGER_ASYNC_QUEUE_LEN)
+#define LOGGER_ASYNC_QUEUE_LEN		16U
+#endif
+#if !defined(LOGGER_ASYNC_RECORD_MAXLEN)
+#define LOGGER_ASYNC_RECORD_MAXLEN	(LOGGING_MESSAGE_MAXLEN + 32U)
+#endif
+#if !defined(LOGGER_ASYNC_STACK_SIZE)
+#define LOGGER_ASYNC_STACK_SIZE		3072U
+#endif
+#if !defined(LOGGER_ASYNC_PRIORITY)
+#define LOGGER_ASYNC_PRIORITY		1
+#endif
+/** Lines at or above this level are pushed out at once, whatever the
+ * console flush policy is. */
+#if !defined(LOGGER_FLUSH_LEVEL)
+#define LOGGER_FLUSH_LEVEL		LOGGING_TYPE_ERROR
+#endif
+
+struct logger_async {
+	struct log_ring ring;
+	uint32_t mem[LOG_RING_MEMSIZE(LOGGER_ASYNC_QUEUE_LEN,
+			LOGGER_ASYNC_RECORD_MAXLEN) / sizeof(uint32_t)];
+	sem_t wakeup;
+	bool wakeup_pending;
+	pthread_t thread;
+};
+
+/* Writes a line and its newline in one go. A short write or an error
+ * counts as failure. */
+static size_t write_console_line(const char *text, size_t len)
+{
+	const struct console_sync_iov iov[] = {
+		{ .base = text, .len = len },
+		{ .base = "\n", .len = 1 },
+	};
+	const int rc = console_sync_writev(iov, sizeof(iov) / sizeof(iov[0]));
+
+	/* The immediate policy has flushed the line already. */
+	if (console_sync_get_flush_policy() != CONSOLE_SYNC_FLUSH_IMMEDIATE) {
+		struct log_line line;
+
+		log_line_parse(&line, text, len);
+		if (line.level >= LOGGER_FLUSH_LEVEL &&
+				line.level != LOGGING_TYPE_NONE) {
+			console_sync_flush();
+		}
+	}
+
+	return (rc == (int)(len + 1))? (size_t)rc : 0;
+}
+
+/* Outputs a formatted line given without its trailing newline. */
+typedef size_t (*emit_t)(const char *text, size_t len);
+
+#if defined(LOGGING_DICTIONARY)
+/* Records arrive as dictionary frames from log_dict_save(), which never
+ * hold a newline, so they are lines already. */
+static size_t format_record(char *buf, size_t bufsize,
+		const void *data, size_t size)
+{
+	if (size > bufsize) {
+		metrics_increase(LogDropCount);
+		return 0;
+	}
+
+	memcpy(buf, data, size);
+	return size;
+}
+#else
+static size_t format_record(char *buf, size_t bufsize,
+		const void *data, size_t size)
+{
+	unused(size);
+	return logging_stringify(buf, bufsize, data);
+}
+#endif
+
+static size_t write_line(char *buf, size_t bufsize,
+		const void *data, size_t size, emit_t emit)
+{
+	size_t len = format_record(buf, bufsize, data, size);
+	uint32_t repeats;
+	const bool pass = log_suppress_check(buf, len, &repeats);
+
+	if (repeats > 0) {
+		char note[32];
+		emit(note, log_suppress_stringify(note, sizeof(note),
+				repeats));
+	}
+
+	if (!pass || len == 0) {
+		return 0;
+	}
+
+	log_retained_write(buf, len);
+
+	return emit(buf, len);
+}
+
+/* Every staging buffer is held, typically by loggers blocked on the
+ * console. The line is formatted on the stack instead of being dropped;
+ * only the callers that get here pay for the buffer. */
+static __attribute__((noinline)) size_t write_unstaged(const void *data,
+		size_t size, emit_t emit)
+{
+	char buf[LOGGING_MESSAGE_MAXLEN];
+	return write_line(buf, sizeof(buf), data, size, emit);
+}
+
+static size_t write_staged(const void *data, size_t size, emit_t emit)
+{
+	size_t bufsize;
+	char *buf = log_staging_acquire(&bufsize);
+
+	if (buf == NULL) {
+		return write_unstaged(data, size, emit);
+	}
+
+	size_t len = write_line(buf, bufsize, data, size, emit);
+	log_staging_release(buf);
+
+	return len;
+}
 
 static size_t write_stdout(const void *data, size_t size)
+{
+	return write_staged(data, size, write_console_line);
+}
+
+static size_t write_fanout(const void *data, size_t size)
+{
+	return write_staged(data, size, log_fanout_write);
+}
+
+static size_t write_console(const void *data, size_t len)
+{
+	const int rc = console_sync_write(data, len);
+	return (rc > 0)? (size_t)rc : 0;
+}
+
+static struct logger_async async;
+static const struct logging_backend *backend;
+
+static size_t write_async(const void *data, size_t size)
+{
+	if (!log_ring_put(&async.ring, data, size)) {
+		metrics_increase(LogDropCount);
+		return 0;
+	}
+
+	/* Only the first record after the drain task went idle pays for the
+	 * wakeup. The flag is cleared by the drain task before it looks at
+	 * the ring, so a record committed after that always posts. */
+	if (!__atomic_exchange_n(&async.wakeup_pending, true,
+			__ATOMIC_ACQ_REL)) {
+		sem_post(&async.wakeup);
+	}
+
+	return size;
+}
+
+static void *drain_async(void *arg)
 {
 	static char buf[LOGGING_MESSAGE_MAXLEN];
-	size_t len = logging_stringify(buf, sizeof(buf)-2, data);
-	size_t total_written = 0;
-	unused(size);
+	struct logger_async *p = (struct logger_async *)arg;
 
-	buf[len++] = '\n';
-	buf[len] = '\0';
+	for (;;) {
+		sem_wait(&p->wakeup);
+		__atomic_store_n(&p->wakeup_pending, false, __ATOMIC_RELEASE);
 
-	while (total_written < len) {
-		int rc = console_sync_write(buf + total_written,
-				len - total_written);
-		if (rc <= 0) { /* Treat short write or error as failure */
-			return 0;
+		const void *record;
+		size_t size;
+		while ((record = log_ring_peek(&p->ring, &size)) != NULL) {
+			write_line(buf, sizeof(buf), record, size,
+					write_console_line);
+			log_ring_consume(&p->ring);
 		}
-		total_written += (size_t)rc;
 	}
 
-	return total_written;
+	return NULL;
 }
 
 void logging_stdout_backend_init(void)
@@ -35,5 +208,71 @@ void logging_stdout_backend_init(void)
 		.write = write_stdout,
 	};
 
+	backend = &log_stdout;
 	logging_add_backend(&log_stdout);
 }
+
+int logging_async_backend_init(void)
+{
+	static struct logging_backend log_async = {
+		.write = write_async,
+	};
+	pthread_attr_t attr;
+
+	if (log_ring_init(&async.ring, async.mem, sizeof(async.mem),
+			LOGGER_ASYNC_RECORD_MAXLEN) != 0 ||
+			sem_init(&async.wakeup, 0, 0) != 0) {
+		return -1;
+	}
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, LOGGER_ASYNC_STACK_SIZE);
+	/* Without this the priority is inherited from the caller and the
+	 * one given here is ignored. */
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedparam(&attr, &(struct sched_param) {
+		.sched_priority = LOGGER_ASYNC_PRIORITY,
+	});
+
+	int err = pthread_create(&async.thread, &attr, drain_async, &async);
+	pthread_attr_destroy(&attr);
+
+	if (err != 0) {
+		sem_destroy(&async.wakeup);
+		return -err;
+	}
+
+	backend = &log_async;
+	return logging_add_backend(&log_async);
+}
+
+int logging_fanout_backend_init(void)
+{
+	static struct logging_backend log_fanout = {
+		.write = write_fanout,
+	};
+	const int id = log_fanout_add(&(const struct log_sink) {
+		.name = "console",
+		.write = write_console,
+		.level = LOGGING_TYPE_DEBUG,
+		.policy = LOG_FANOUT_DROP_NEWEST,
+	});
+
+	if (id < 0) {
+		return id;
+	}
+
+	backend = &log_fanout;
+	return logging_add_backend(&log_fanout);
+}
+
+size_t logging_write_encoded(const void *data, size_t size)
+{
+	const struct logging_backend *p = backend;
+
+	if (p == NULL) {
+		return 0;
+	}
+
+	return p->write(data, size);
+}
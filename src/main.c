@@ -9,16 +9,40 @@
 #include "libmcu/gpio.h"
 
 #include "logging.h"
+#include "log_dict.h"
+#include "log_retained.h"
+#include "log_store.h"
 #include "console_sync.h"
+#include "timebase.h"
 #include "pinmap.h"
 
+#if defined(LOGGING_TIMESTAMP_US)
+#define LOG_TIMESTAMP_FUNC		timebase_get_us32
+#else
+#define LOG_TIMESTAMP_FUNC		board_get_time_since_boot_ms
+#endif
+
 int main(void)
 {
 	board_init(); /* should be called very first. */
 	console_sync_init();
-
-	logging_init(board_get_time_since_boot_ms);
+	timebase_init();
+
+	logging_init(LOG_TIMESTAMP_FUNC);
+#if defined(LOGGING_DICTIONARY)
+	log_dict_init(LOG_TIMESTAMP_FUNC);
+#endif
+#if defined(LOGGING_ASYNC)
+	logging_async_backend_init();
+#elif defined(LOGGING_FANOUT)
+	logging_fanout_backend_init();
+#else
 	logging_stdout_backend_init();
+#endif
+#if defined(LOGGING_STORE)
+	log_store_init();
+#endif
+	log_retained_init();
 
 	const board_reboot_reason_t reboot_reason = board_get_reboot_reason();
 	info("[%s] %s %s", board_get_reboot_reason_string(reboot_reason),
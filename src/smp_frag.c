@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "smp_frag.h"
+
+#include <errno.h>
+#include <string.h>
+
+/* Big-endian length of the payload following the header. */
+#define SMP_HDR_LEN_OFFSET		2U
+
+static size_t get_packet_len(const uint8_t *hdr)
+{
+	return SMP_FRAG_HDR_SIZE + (((size_t)hdr[SMP_HDR_LEN_OFFSET] << 8) |
+			(size_t)hdr[SMP_HDR_LEN_OFFSET + 1]);
+}
+
+void smp_reasm_init(struct smp_reasm *reasm, void *buf, size_t bufsize)
+{
+	*reasm = (struct smp_reasm) {
+		.buf = (uint8_t *)buf,
+		.bufsize = bufsize,
+	};
+}
+
+void smp_reasm_reset(struct smp_reasm *reasm)
+{
+	reasm->len = 0;
+	reasm->expected = 0;
+}
+
+bool smp_reasm_busy(const struct smp_reasm *reasm)
+{
+	return reasm->len != 0 && reasm->len != reasm->expected;
+}
+
+int smp_reasm_feed(struct smp_reasm *reasm, const void *data, size_t datasize)
+{
+	if (reasm->expected != 0 && reasm->len == reasm->expected) {
+		smp_reasm_reset(reasm); /* the previous packet was not reset */
+	}
+
+	const size_t limit = reasm->expected? reasm->expected : reasm->bufsize;
+
+	if (datasize > limit - reasm->len) {
+		const int err = reasm->expected? -EPROTO : -EMSGSIZE;
+		smp_reasm_reset(reasm);
+		return err;
+	}
+
+	memcpy(&reasm->buf[reasm->len], data, datasize);
+	reasm->len += datasize;
+
+	if (reasm->expected == 0 && reasm->len >= SMP_FRAG_HDR_SIZE) {
+		reasm->expected = get_packet_len(reasm->buf);
+
+		if (reasm->expected > reasm->bufsize) {
+			smp_reasm_reset(reasm);
+			return -EMSGSIZE;
+		} else if (reasm->len > reasm->expected) {
+			smp_reasm_reset(reasm);
+			return -EPROTO;
+		}
+	}
+
+	if (reasm->expected != 0 && reasm->len == reasm->expected) {
+		return (int)reasm->len;
+	}
+
+	return 0;
+}
+
+void smp_frag_init(struct smp_frag *frag, const void *data, size_t datasize)
+{
+	*frag = (struct smp_frag) {
+		.data = (const uint8_t *)data,
+		.len = datasize,
+	};
+}
+
+const void *smp_frag_peek(const struct smp_frag *frag, size_t maxlen,
+		size_t *datasize)
+{
+	const size_t left = frag->len - frag->pos;
+
+	if (left == 0 || maxlen == 0) {
+		*datasize = 0;
+		return NULL;
+	}
+
+	*datasize = (left < maxlen)? left : maxlen;
+
+	return &frag->data[frag->pos];
+}
+
+void smp_frag_consume(struct smp_frag *frag, size_t datasize)
+{
+	const size_t left = frag->len - frag->pos;
+
+	frag->pos += (datasize < left)? datasize : left;
+}
@@ -0,0 +1,626 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "smp_serial.h"
+
+#include <string.h>
+
+#include "crc16_xmodem.h"
+
+#define FRAME_START_1		0x06U
+#define FRAME_START_2		0x09U
+#define FRAME_CONT_1		0x04U
+#define FRAME_CONT_2		0x14U
+#define COBS_DELIM		0x00U
+
+enum rx_state {
+	WAIT_HDR1,
+	WAIT_HDR2,
+	PAYLOAD,
+	COBS,
+};
+
+/* Stages a frame in s->tx_cobs. A block's code byte is known only once
+ * the block ends, so only whole blocks are written out. */
+struct cobs_enc {
+	struct smp_serial *s;
+	size_t len;
+	size_t code_pos;
+	uint8_t code;
+	bool failed;
+};
+
+/* Raw frame [len_hi][len_lo][payload...][crc_hi][crc_lo] read byte by byte
+ * straight from the caller's buffer. The length counts the CRC. */
+struct tx_stream {
+	const uint8_t *data;
+	size_t len;
+	size_t pos;
+	uint16_t crc;
+};
+
+static size_t get_raw_len(const struct tx_stream *s)
+{
+	return s->len + 4U;
+}
+
+static uint8_t next_raw_byte(struct tx_stream *s)
+{
+	const size_t pos = s->pos++;
+
+	if (pos < 2U) {
+		const size_t pkt_len = s->len + 2U;
+		return (uint8_t)((pos == 0U)? pkt_len >> 8 : pkt_len);
+	} else if (pos < s->len + 2U) {
+		return s->data[pos - 2U];
+	}
+
+	return (uint8_t)((pos == s->len + 2U)? s->crc >> 8 : s->crc);
+}
+
+/* Fills out with as many quanta as fit. Returns the number of bytes. */
+static size_t encode_line(struct tx_stream *s, uint8_t *out, size_t outsize)
+{
+	static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+		"abcdefghijklmnopqrstuvwxyz0123456789+/";
+	const size_t raw_len = get_raw_len(s);
+	size_t n = 0;
+
+	/* The CRC goes out at the end of the frame, so the payload this line
+	 * covers is folded in before it is encoded. */
+	const size_t from = (s->pos > 2U)? s->pos : 2U;
+	size_t to = s->pos + outsize / 4U * 3U;
+	to = (to < s->len + 2U)? to : s->len + 2U;
+	if (to > from) {
+		s->crc = crc16_xmodem_update(s->crc, &s->data[from - 2U],
+				to - from);
+	}
+
+	while (n + 4U <= outsize && s->pos < raw_len) {
+		uint8_t q[3] = { 0, };
+		size_t k;
+
+		for (k = 0; k < sizeof(q) && s->pos < raw_len; k++) {
+			q[k] = next_raw_byte(s);
+		}
+
+		const uint32_t v = (uint32_t)q[0] << 16 |
+			(uint32_t)q[1] << 8 | q[2];
+
+		out[n++] = (uint8_t)alphabet[(v >> 18) & 0x3FU];
+		out[n++] = (uint8_t)alphabet[(v >> 12) & 0x3FU];
+		out[n++] = (k > 1U)? (uint8_t)alphabet[(v >> 6) & 0x3FU] : '=';
+		out[n++] = (k > 2U)? (uint8_t)alphabet[v & 0x3FU] : '=';
+	}
+
+	return n;
+}
+
+static int send_console(struct smp_serial *s, const void *data, size_t len)
+{
+	struct tx_stream stream = {
+		.data = (const uint8_t *)data,
+		.len = len,
+	};
+
+	/* The CRC is folded in as the payload is encoded, and each line is
+	 * written as soon as it is full, so nothing is staged but one line.
+	 * A line goes out in one write, so log lines cannot land in it. */
+	while (stream.pos < get_raw_len(&stream)) {
+		const bool first = stream.pos == 0U;
+		const size_t n = encode_line(&stream, &s->tx_line[2],
+				SMP_SERIAL_LINE_MAX);
+
+		s->tx_line[0] = first? FRAME_START_1 : FRAME_CONT_1;
+		s->tx_line[1] = first? FRAME_START_2 : FRAME_CONT_2;
+		s->tx_line[2U + n] = SMP_SERIAL_LINE_END;
+
+		if (s->ops->write(s->tx_line, 3U + n,
+				SMP_SERIAL_FRAMING_CONSOLE, s->ctx)
+				!= (int)(3U + n)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Room a block needs from its code byte on: the code, 254 data bytes and
+ * the closing delimiter. */
+#define COBS_BLOCK_ROOM		256U
+
+static void cobs_write(struct cobs_enc *e)
+{
+	struct smp_serial *s = e->s;
+
+	if (!e->failed && s->ops->write(s->tx_cobs, e->len,
+			SMP_SERIAL_FRAMING_COBS, s->ctx) != (int)e->len) {
+		e->failed = true;
+	}
+
+	e->len = 0;
+}
+
+static void cobs_begin(struct cobs_enc *e, struct smp_serial *s)
+{
+	*e = (struct cobs_enc) { .s = s, .len = 2, .code_pos = 1, .code = 1, };
+	s->tx_cobs[0] = COBS_DELIM;
+}
+
+/* Writes out what is staged once the next block might not fit. */
+static void cobs_close_block(struct cobs_enc *e)
+{
+	e->s->tx_cobs[e->code_pos] = e->code;
+
+	if (sizeof(e->s->tx_cobs) - e->len < COBS_BLOCK_ROOM) {
+		cobs_write(e);
+	}
+
+	e->code_pos = e->len++;
+	e->code = 1;
+}
+
+static void cobs_put(struct cobs_enc *e, const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		if (data[i] == 0) {
+			cobs_close_block(e);
+			continue;
+		}
+
+		e->s->tx_cobs[e->len++] = data[i];
+		if (++e->code == 0xFFU) {
+			cobs_close_block(e);
+		}
+	}
+}
+
+static int cobs_end(struct cobs_enc *e)
+{
+	e->s->tx_cobs[e->code_pos] = e->code;
+	e->s->tx_cobs[e->len++] = COBS_DELIM;
+	cobs_write(e);
+
+	return e->failed? -1 : 0;
+}
+
+/* Encoded straight from the caller's buffer, a few blocks at a time, so
+ * the frame is never staged whole. */
+static int send_cobs(struct smp_serial *s, const void *data, size_t len)
+{
+	const uint16_t crc = crc16_xmodem_update(CRC16_XMODEM_INIT, data, len);
+	const uint8_t trailer[] = { (uint8_t)(crc >> 8), (uint8_t)crc };
+	struct cobs_enc enc;
+
+	cobs_begin(&enc, s);
+	cobs_put(&enc, (const uint8_t *)data, len);
+	cobs_put(&enc, trailer, sizeof(trailer));
+
+	return cobs_end(&enc);
+}
+
+int smp_serial_send(struct smp_serial *s, const void *data, size_t datasize)
+{
+	if (datasize > SMP_SERIAL_PKT_MAX) {
+		return -1;
+	}
+
+	if (__atomic_load_n(&s->tx_framing, __ATOMIC_RELAXED) ==
+			SMP_SERIAL_FRAMING_COBS) {
+		return send_cobs(s, data, datasize);
+	}
+
+	return send_console(s, data, datasize);
+}
+
+int smp_serial_set_framing(struct smp_serial *s, smp_serial_framing_t framing)
+{
+	switch (framing) {
+	case SMP_SERIAL_FRAMING_CONSOLE: /* fall through */
+	case SMP_SERIAL_FRAMING_AUTO:
+		s->framing = framing;
+		__atomic_store_n(&s->tx_framing, SMP_SERIAL_FRAMING_CONSOLE,
+				__ATOMIC_RELAXED);
+		return 0;
+	case SMP_SERIAL_FRAMING_COBS:
+		s->framing = framing;
+		__atomic_store_n(&s->tx_framing, SMP_SERIAL_FRAMING_COBS,
+				__ATOMIC_RELAXED);
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+void smp_serial_set_reply_framing(struct smp_serial *s,
+		smp_serial_framing_t framing)
+{
+	if (s->framing == SMP_SERIAL_FRAMING_AUTO) {
+		__atomic_store_n(&s->tx_framing, framing, __ATOMIC_RELAXED);
+	}
+}
+
+/* Value of each base64 digit, BASE64_INVALID for any other byte. */
+#define BASE64_INVALID		0xFFU
+static const uint8_t base64_digit[256] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B,
+	0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+	0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+	0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+	0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20,
+	0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30,
+	0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+static int decode_base64_char(uint8_t c)
+{
+	const uint8_t v = base64_digit[c];
+	return (v == BASE64_INVALID)? -1 : (int)v;
+}
+
+/* Decodes one quantum into out. Returns the number of bytes, or -1 if the
+ * quantum is malformed. */
+static int decode_quantum(const uint8_t q[4], uint8_t out[3])
+{
+	const int a = decode_base64_char(q[0]);
+	const int b = decode_base64_char(q[1]);
+	const int c = (q[2] == '=')? 0 : decode_base64_char(q[2]);
+	const int d = (q[3] == '=')? 0 : decode_base64_char(q[3]);
+
+	if (a < 0 || b < 0 || c < 0 || d < 0 || (q[2] == '=' && q[3] != '=')) {
+		return -1;
+	}
+
+	const uint32_t v = (uint32_t)a << 18 | (uint32_t)b << 12 |
+		(uint32_t)c << 6 | (uint32_t)d;
+
+	out[0] = (uint8_t)(v >> 16);
+	out[1] = (uint8_t)(v >> 8);
+	out[2] = (uint8_t)v;
+
+	return (q[2] == '=')? 1 : (q[3] == '=')? 2 : 3;
+}
+
+static void reset_packet(struct smp_serial *s)
+{
+	s->active = false;
+	s->bad = false;
+	s->padded = false;
+	s->quantum_len = 0;
+	s->crc = 0;
+	s->cobs_code = 0;
+	s->cobs_left = 0;
+	s->decoded_len = 0;
+}
+
+/* Takes a buffer to decode the next packet into, unless a dropped packet
+ * left one behind. Without one the packet is dropped. */
+static void lease_buf(struct smp_serial *s)
+{
+	if (s->buf == NULL) {
+		s->buf = s->ops->lease(s->ctx);
+	}
+	if (s->buf == NULL) {
+		s->bad = true;
+		s->stats.dropped++;
+	}
+}
+
+/* Hands the leased buffer over along with the packet in it. */
+static void deliver(struct smp_serial *s, size_t len,
+		smp_serial_framing_t framing)
+{
+	uint8_t *buf = s->buf;
+
+	s->buf = NULL;
+	s->stats.rx_packets++;
+	s->ops->deliver(buf, len, framing, s->ctx);
+}
+
+/* Packet length from the first two decoded bytes. It counts the CRC. */
+static size_t get_pkt_len(const struct smp_serial *s)
+{
+	return (size_t)s->len_field[0] << 8 | s->len_field[1];
+}
+
+/* Appends a decoded quantum to the packet. The length field is kept
+ * apart, so the packet starts at the head of the buffer like a COBS one. */
+static void push_quantum(struct smp_serial *s, const uint8_t q[4])
+{
+	uint8_t out[3];
+	const int n = decode_quantum(q, out);
+
+	if (n < 0 || s->padded ||
+			s->decoded_len + (size_t)n > SMP_SERIAL_BUF_SIZE + 2U) {
+		s->bad = true;
+		return;
+	}
+
+	const size_t pos = s->decoded_len;
+	size_t k = 0;
+
+	for (; k < (size_t)n && s->decoded_len < 2U; k++) {
+		s->len_field[s->decoded_len++] = out[k];
+	}
+	for (; k < (size_t)n; k++) {
+		s->buf[s->decoded_len++ - 2U] = out[k];
+	}
+
+	s->padded = n < 3;
+
+	if (pos < 2U && s->decoded_len >= 2U &&
+			get_pkt_len(s) > SMP_SERIAL_BUF_SIZE) {
+		s->bad = true;
+	}
+}
+
+/* Decodes each quantum once, straight from the input unless it is split
+ * across reads, then folds what this run decoded into the CRC in one go.
+ * The two length bytes are not covered by the CRC. */
+static void decode_payload(struct smp_serial *s,
+		const uint8_t *buf, size_t len)
+{
+	const size_t from = (s->decoded_len > 2U)? s->decoded_len : 2U;
+	size_t i = 0;
+
+	while (i < len && s->quantum_len != 0U && !s->bad) {
+		s->quantum[s->quantum_len++] = buf[i++];
+		if (s->quantum_len == sizeof(s->quantum)) {
+			s->quantum_len = 0;
+			push_quantum(s, s->quantum);
+		}
+	}
+	for (; i + sizeof(s->quantum) <= len && !s->bad;
+			i += sizeof(s->quantum)) {
+		push_quantum(s, &buf[i]);
+	}
+	while (i < len && !s->bad) {
+		s->quantum[s->quantum_len++] = buf[i++];
+	}
+
+	if (!s->bad && s->decoded_len > from) {
+		s->crc = crc16_xmodem_update(s->crc, &s->buf[from - 2U],
+				s->decoded_len - from);
+	}
+}
+
+/* Called at every line end. A quantum may span lines, so a packet is
+ * complete only once the declared length has been decoded. */
+static void finish_line(struct smp_serial *s)
+{
+	if (s->bad) {
+		s->stats.malformed += (s->buf != NULL);
+		reset_packet(s);
+		return;
+	}
+	if (s->decoded_len < 4U) {
+		return;
+	}
+
+	const size_t pkt_len = get_pkt_len(s);
+
+	if (s->decoded_len < pkt_len + 2U) {
+		/* Partial packet — continuation frames still pending. */
+		return;
+	}
+	if (s->decoded_len != pkt_len + 2U || s->quantum_len != 0U) {
+		s->stats.malformed++;
+		reset_packet(s);
+		return;
+	}
+
+	if (s->crc != 0U) {
+		s->stats.crc_errors++;
+	} else if (pkt_len >= 2U) {
+		deliver(s, pkt_len - 2U, SMP_SERIAL_FRAMING_CONSOLE);
+	}
+
+	reset_packet(s);
+}
+
+/* Undoes COBS as bytes arrive. A zero is implied between blocks, except
+ * after a full 254-byte block. */
+static void decode_cobs(struct smp_serial *s, const uint8_t *buf, size_t len)
+{
+	size_t i = 0;
+
+	while (i < len && !s->bad) {
+		if (s->cobs_left == 0U) {
+			const bool zero = s->cobs_code != 0U &&
+				s->cobs_code != 0xFFU;
+
+			if (zero && s->decoded_len < SMP_SERIAL_BUF_SIZE) {
+				s->buf[s->decoded_len++] = 0;
+			} else if (zero) {
+				s->bad = true;
+				break;
+			}
+
+			s->cobs_code = buf[i++];
+			s->cobs_left = (uint8_t)(s->cobs_code - 1U);
+			continue;
+		}
+
+		size_t n = len - i;
+		n = (n < s->cobs_left)? n : s->cobs_left;
+
+		if (n > SMP_SERIAL_BUF_SIZE - s->decoded_len) {
+			s->bad = true;
+			break;
+		}
+
+		memcpy(&s->buf[s->decoded_len], &buf[i], n);
+		s->decoded_len += n;
+		s->cobs_left = (uint8_t)(s->cobs_left - n);
+		i += n;
+	}
+}
+
+/* The CRC trails the packet, so the whole frame folds to zero. */
+static void finish_cobs(struct smp_serial *s)
+{
+	if (s->bad || s->cobs_left != 0U) {
+		s->stats.malformed += (s->buf != NULL);
+	} else if (s->decoded_len < 2U) {
+		/* back-to-back delimiters */
+	} else if (crc16_xmodem_update(CRC16_XMODEM_INIT, s->buf,
+			s->decoded_len) != 0U) {
+		s->stats.crc_errors++;
+	} else {
+		deliver(s, s->decoded_len - 2U, SMP_SERIAL_FRAMING_COBS);
+	}
+
+	reset_packet(s);
+}
+
+static size_t feed_cobs(struct smp_serial *s, const uint8_t *buf, size_t len)
+{
+	const uint8_t *end = (const uint8_t *)memchr(buf, COBS_DELIM, len);
+	const size_t n = end? (size_t)(end - buf) : len;
+
+	decode_cobs(s, buf, n);
+
+	if (end && s->cobs_code == 0U && !s->bad) {
+		/* a delimiter shared with the previous frame */
+		return n + 1;
+	} else if (end) {
+		finish_cobs(s);
+		s->state = WAIT_HDR1;
+		return n + 1;
+	}
+
+	return n;
+}
+
+/* Decodes payload up to the next terminator in one go. Returns the number
+ * of bytes taken from buf, the terminator included. */
+static size_t feed_payload(struct smp_serial *s,
+		const uint8_t *buf, size_t len)
+{
+	const uint8_t *end =
+		(const uint8_t *)memchr(buf, SMP_SERIAL_LINE_END, len);
+	const size_t n = end? (size_t)(end - buf) : len;
+
+	decode_payload(s, buf, n);
+
+	if (end) {
+		finish_line(s);
+		s->state = WAIT_HDR1;
+		return n + 1;
+	}
+
+	return n;
+}
+
+void smp_serial_feed(struct smp_serial *s, const void *data, size_t datasize)
+{
+	const uint8_t *buf = (const uint8_t *)data;
+	size_t i = 0;
+
+	while (i < datasize) {
+		const uint8_t byte = buf[i];
+
+		switch (s->state) {
+		case WAIT_HDR1:
+			if (byte == COBS_DELIM) {
+				if (s->framing != SMP_SERIAL_FRAMING_CONSOLE) {
+					reset_packet(s);
+					lease_buf(s);
+					s->state = COBS;
+				}
+			} else if (s->framing == SMP_SERIAL_FRAMING_COBS) {
+				/* console lines are not SMP in this mode */
+			} else if (byte == FRAME_START_1) {
+				s->expected_hdr2 = FRAME_START_2;
+				s->line_is_start = true;
+				s->state = WAIT_HDR2;
+			} else if (byte == FRAME_CONT_1) {
+				s->expected_hdr2 = FRAME_CONT_2;
+				s->line_is_start = false;
+				s->state = WAIT_HDR2;
+			}
+			i++;
+			break;
+
+		case WAIT_HDR2:
+			s->state = WAIT_HDR1;
+			if (byte == s->expected_hdr2) {
+				if (s->line_is_start) {
+					reset_packet(s);
+					lease_buf(s);
+					s->active = true;
+					s->state = PAYLOAD;
+				} else if (s->active) {
+					s->state = PAYLOAD;
+				}
+			}
+			i++;
+			break;
+
+		case PAYLOAD:
+			i += feed_payload(s, &buf[i], datasize - i);
+			break;
+
+		case COBS:
+			i += feed_cobs(s, &buf[i], datasize - i);
+			break;
+
+		default:
+			s->state = WAIT_HDR1;
+			i++;
+			break;
+		}
+	}
+}
+
+void smp_serial_reset(struct smp_serial *s)
+{
+	s->state = WAIT_HDR1;
+	reset_packet(s);
+}
+
+void smp_serial_get_stats(const struct smp_serial *s,
+		struct smp_serial_stats *stats)
+{
+	*stats = s->stats;
+}
+
+void smp_serial_init(struct smp_serial *s, const struct smp_serial_ops *ops,
+		void *ctx)
+{
+	memset(s, 0, sizeof(*s));
+
+	s->ops = ops;
+	s->ctx = ctx;
+
+	smp_serial_set_framing(s, SMP_SERIAL_FRAMING_CONSOLE);
+	smp_serial_reset(s);
+}
@@ -0,0 +1,24 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "timebase.h"
+
+#define USEC_PER_SEC		1000000U
+
+uint64_t timebase_get_us(void)
+{
+	const uint64_t ticks = timebase_get_ticks();
+	const uint64_t freq = timebase_get_frequency();
+
+	/* Split to keep ticks * 10^6 from overflowing after a few days of
+	 * uptime at tens of MHz. */
+	return ticks / freq * USEC_PER_SEC + ticks % freq * USEC_PER_SEC / freq;
+}
+
+uint32_t timebase_get_us32(void)
+{
+	return (uint32_t)timebase_get_us();
+}
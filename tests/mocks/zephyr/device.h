@@ -0,0 +1,26 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ZEPHYR_DEVICE_MOCK_H
+#define ZEPHYR_DEVICE_MOCK_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+struct device {
+	const char *name;
+};
+
+bool device_is_ready(const struct device *dev);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ZEPHYR_DEVICE_MOCK_H */
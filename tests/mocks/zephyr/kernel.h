@@ -0,0 +1,53 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ZEPHYR_KERNEL_MOCK_H
+#define ZEPHYR_KERNEL_MOCK_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <pthread.h>
+
+#define ARG_UNUSED(x)		(void)(x)
+
+typedef struct {
+	int64_t ms;
+} k_timeout_t;
+
+#define K_FOREVER		((k_timeout_t){ .ms = -1 })
+#define K_NO_WAIT		((k_timeout_t){ .ms = 0 })
+#define K_MSEC(t)		((k_timeout_t){ .ms = (t) })
+
+struct k_sem {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned int count;
+	unsigned int limit;
+};
+
+/* A spinlock masks the interrupt on the target. Here every lock is the
+ * one lock the simulated interrupt handler runs under. */
+struct k_spinlock {
+	int unused;
+};
+
+typedef int k_spinlock_key_t;
+
+int k_sem_init(struct k_sem *sem, unsigned int initial, unsigned int limit);
+int k_sem_take(struct k_sem *sem, k_timeout_t timeout);
+void k_sem_give(struct k_sem *sem);
+
+k_spinlock_key_t k_spin_lock(struct k_spinlock *lock);
+void k_spin_unlock(struct k_spinlock *lock, k_spinlock_key_t key);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ZEPHYR_KERNEL_MOCK_H */
@@ -0,0 +1,38 @@
+/*
+ * SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef ZEPHYR_RING_BUFFER_MOCK_H
+#define ZEPHYR_RING_BUFFER_MOCK_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+struct ring_buf {
+	uint8_t *buffer;
+	uint32_t size;
+	uint32_t head;
+	uint32_t tail;
+};
+
+void ring_buf_init(struct ring_buf *buf, uint32_t size, uint8_t *data);
+uint32_t ring_buf_put_claim(struct ring_buf *buf, uint8_t **data,
+		uint32_t size);
+int ring_buf_put_finish(struct ring_buf *buf, uint32_t size);
+uint32_t ring_buf_put(struct ring_buf *buf, const uint8_t *data,
+		uint32_t size);
+uint32_t ring_buf_get_claim(struct ring_buf *buf, uint8_t **data,
+		uint32_t size);
+int ring_buf_get_finish(struct ring_buf *buf, uint32_t size);
+uint32_t ring_buf_get(struct ring_buf *buf, uint8_t *data, uint32_t size);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ZEPHYR_RING_BUFFER_MOCK_H */
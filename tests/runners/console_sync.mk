@@ -0,0 +1,21 @@
+COMPONENT_NAME = console_sync
+
+SRC_FILES = \
+	../src/console_sync.c \
+	../src/console_emerg.c \
+	../src/log_ring.c \
+
+TEST_SRC_FILES = \
+	src/console_sync_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+	$(LIBMCU_ROOT)/modules/common/include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -DCONSOLE_SYNC_FLUSH_POLICY=CONSOLE_SYNC_FLUSH_WATERMARK
+LD_LIBRARIES = -lpthread
+
+include runners/MakefileRunner
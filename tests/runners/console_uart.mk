@@ -0,0 +1,19 @@
+COMPONENT_NAME = console_uart
+
+SRC_FILES = \
+	../ports/zephyr/console_uart.c \
+
+TEST_SRC_FILES = \
+	src/console_uart_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../ports/zephyr \
+	mocks \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -DCONFIG_UART_INTERRUPT_DRIVEN
+LD_LIBRARIES = -lpthread
+
+include runners/MakefileRunner
@@ -0,0 +1,17 @@
+COMPONENT_NAME = crc16_xmodem_table
+
+SRC_FILES = \
+	../src/crc16_xmodem.c \
+
+TEST_SRC_FILES = \
+	src/crc16_xmodem_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -DCRC16_XMODEM_IMPL=CRC16_XMODEM_IMPL_TABLE
+
+include runners/MakefileRunner
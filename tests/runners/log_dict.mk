@@ -0,0 +1,20 @@
+COMPONENT_NAME = log_dict
+
+SRC_FILES = \
+	../src/log_dict.c \
+	../src/log_line.c \
+
+TEST_SRC_FILES = \
+	src/log_dict_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+	$(LIBMCU_ROOT)/modules/common/include \
+	$(LIBMCU_ROOT)/modules/logging/include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -DLOGGING_DICTIONARY
+
+include runners/MakefileRunner
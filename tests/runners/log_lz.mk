@@ -0,0 +1,17 @@
+COMPONENT_NAME = log_lz
+
+SRC_FILES = \
+	../src/log_lz.c \
+
+TEST_SRC_FILES = \
+	src/log_lz_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS =
+
+include runners/MakefileRunner
@@ -0,0 +1,24 @@
+COMPONENT_NAME = log_retained
+
+SRC_FILES = \
+	../src/log_retained.c \
+
+TEST_SRC_FILES = \
+	src/log_retained_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+	$(LIBMCU_ROOT)/modules/common/include \
+	$(LIBMCU_ROOT)/modules/logging/include \
+
+MOCKS_SRC_DIRS =
+# Replayed text goes through info(), which is log_dict_save() in dictionary
+# builds and easy to fake here. The retained ring goes to a section the test
+# can find, to corrupt it the way a reset would.
+CPPUTEST_CPPFLAGS = \
+	-DLOGGING_DICTIONARY \
+	-DLIBMCU_NOINIT='__attribute__((section("retained_noinit")))'
+
+include runners/MakefileRunner
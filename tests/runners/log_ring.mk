@@ -0,0 +1,18 @@
+COMPONENT_NAME = log_ring
+
+SRC_FILES = \
+	../src/log_ring.c \
+
+TEST_SRC_FILES = \
+	src/log_ring_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS =
+LD_LIBRARIES = -lpthread
+
+include runners/MakefileRunner
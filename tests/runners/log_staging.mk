@@ -0,0 +1,20 @@
+COMPONENT_NAME = log_staging
+
+SRC_FILES = \
+	../src/log_staging.c \
+
+TEST_SRC_FILES = \
+	src/log_staging_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+	$(LIBMCU_ROOT)/modules/common/include \
+	$(LIBMCU_ROOT)/modules/logging/include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS =
+LD_LIBRARIES = -lpthread
+
+include runners/MakefileRunner
@@ -0,0 +1,25 @@
+COMPONENT_NAME = log_store
+
+ifeq ($(wildcard $(LITTLEFS_ROOT)/lfs.c),)
+# The benchmark runs against littlefs itself; point LITTLEFS_ROOT at a
+# littlefs checkout to build it.
+all start gcov debug flags:
+	@echo "$(COMPONENT_NAME): no littlefs in '$(LITTLEFS_ROOT)', skipped"
+else
+SRC_FILES = \
+	../src/log_lz.c \
+
+TEST_SRC_FILES = \
+	src/log_store_test.cpp \
+	src/littlefs.c \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -isystem $(LITTLEFS_ROOT)
+
+include runners/MakefileRunner
+endif
@@ -0,0 +1,23 @@
+COMPONENT_NAME = log_suppress
+
+SRC_FILES = \
+	../src/log_suppress.c \
+	../src/log_line.c \
+
+TEST_SRC_FILES = \
+	src/log_suppress_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+	$(LIBMCU_ROOT)/modules/common/include \
+	$(LIBMCU_ROOT)/modules/logging/include \
+	$(LIBMCU_ROOT)/modules/metrics/include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -DMETRICS_USER_DEFINES=\"metrics.def\"
+
+LD_LIBRARIES = -lpthread
+
+include runners/MakefileRunner
@@ -0,0 +1,25 @@
+COMPONENT_NAME = logger
+
+SRC_FILES = \
+	../src/logger.c \
+	../src/log_line.c \
+	../src/log_ring.c \
+	../src/log_staging.c \
+
+TEST_SRC_FILES = \
+	src/logger_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+	$(LIBMCU_ROOT)/modules/common/include \
+	$(LIBMCU_ROOT)/modules/logging/include \
+	$(LIBMCU_ROOT)/modules/metrics/include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = -DMETRICS_USER_DEFINES=\"metrics.def\" \
+	-DLOGGER_ASYNC_PRIORITY=0
+LD_LIBRARIES = -lpthread
+
+include runners/MakefileRunner
@@ -0,0 +1,17 @@
+COMPONENT_NAME = smp_frag
+
+SRC_FILES = \
+	../src/smp_frag.c \
+
+TEST_SRC_FILES = \
+	src/smp_frag_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS = 
+
+include runners/MakefileRunner
@@ -0,0 +1,18 @@
+COMPONENT_NAME = smp_serial
+
+SRC_FILES = \
+	../src/smp_serial.c \
+	../src/crc16_xmodem.c \
+
+TEST_SRC_FILES = \
+	src/smp_serial_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS =
+
+include runners/MakefileRunner
@@ -0,0 +1,20 @@
+COMPONENT_NAME = smp_serial_pty
+
+SRC_FILES = \
+	../src/smp_serial.c \
+	../src/crc16_xmodem.c \
+
+TEST_SRC_FILES = \
+	src/smp_serial_pty_test.cpp \
+	src/test_all.cpp \
+
+INCLUDE_DIRS = \
+	$(CPPUTEST_HOME)/include \
+	../include \
+
+MOCKS_SRC_DIRS =
+CPPUTEST_CPPFLAGS =
+
+LD_LIBRARIES = -lpthread
+
+include runners/MakefileRunner
@@ -0,0 +1,314 @@
+#include "CppUTest/TestHarness.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "console_sync.h"
+#include "console_emerg.h"
+#include "libmcu/timext.h"
+
+/* stdout is pointed at a pipe for each test, so what reaches the pipe is
+ * what the console has pushed out of stdio. */
+static int pipefd[2];
+static int saved_stdout;
+static int inpipe[2];
+static int saved_stdin;
+
+void sleep_ms(unsigned int ms)
+{
+	const struct timespec ts = {
+		(time_t)(ms / 1000U), (long)(ms % 1000U) * 1000000L,
+	};
+	nanosleep(&ts, NULL);
+}
+
+static size_t drain_pipe(char *buf, size_t bufsize)
+{
+	size_t total = 0;
+	ssize_t n;
+
+	while ((n = read(pipefd[0], &buf[total], bufsize - total)) > 0) {
+		total += (size_t)n;
+	}
+
+	return total;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void *write_line(void *arg)
+{
+	(void)arg;
+	console_sync_write("end\n", 4);
+	return NULL;
+}
+
+/* Fills the pipe so that the next write through stdio blocks. */
+static void fill_pipe(void)
+{
+	static char junk[64 * 1024];
+
+	fcntl(pipefd[1], F_SETFL, O_NONBLOCK);
+	while (write(pipefd[1], junk, sizeof(junk)) > 0) {
+	}
+	fcntl(pipefd[1], F_SETFL, 0);
+}
+
+TEST_GROUP(ConsoleSync) {
+	void setup(void) {
+		fflush(stdout);
+		saved_stdout = dup(STDOUT_FILENO);
+		CHECK(pipe(pipefd) == 0);
+		fcntl(pipefd[0], F_SETFL, O_NONBLOCK);
+		dup2(pipefd[1], STDOUT_FILENO);
+
+		saved_stdin = dup(STDIN_FILENO);
+		CHECK(pipe(inpipe) == 0);
+		dup2(inpipe[0], STDIN_FILENO);
+
+		console_sync_init();
+		console_sync_set_flush_policy(CONSOLE_SYNC_FLUSH_WATERMARK);
+	}
+	void teardown(void) {
+		console_sync_set_flush_policy(CONSOLE_SYNC_FLUSH_WATERMARK);
+		console_sync_deinit();
+
+		dup2(saved_stdout, STDOUT_FILENO);
+		close(saved_stdout);
+		close(pipefd[0]);
+		close(pipefd[1]);
+
+		dup2(saved_stdin, STDIN_FILENO);
+		close(saved_stdin);
+		close(inpipe[0]);
+		close(inpipe[1]);
+	}
+};
+
+/* The panic flush switches the emergency path to polled output for
+ * good, so these are defined first to run after everything else, the
+ * last one defined first. */
+TEST(ConsoleSync, flushPanic_ShouldNotWait_WhenWriterHoldsConsole) {
+	static char buf[1024 * 1024];
+	pthread_t writer;
+
+	console_sync_set_flush_policy(CONSOLE_SYNC_FLUSH_IMMEDIATE);
+	fill_pipe();
+	pthread_create(&writer, NULL, write_line, NULL);
+	sleep_ms(50);
+
+	const uint64_t t0 = now_ns();
+	LONGS_EQUAL(-EBUSY, console_sync_flush_panic());
+	CHECK(now_ns() - t0 < 10000000ull);
+
+	drain_pipe(buf, sizeof(buf));
+	pthread_join(writer, NULL);
+}
+
+TEST(ConsoleSync, flushPanic_ShouldPushOutBufferedAndQueued_WhenConsoleIsFree) {
+	char buf[64];
+
+	LONGS_EQUAL(4, console_sync_write("abc\n", 4));
+	LONGS_EQUAL(5, console_emerg_write("isr!\n", 5));
+	LONGS_EQUAL(0, drain_pipe(buf, sizeof(buf)));
+
+	LONGS_EQUAL(0, console_sync_flush_panic());
+	LONGS_EQUAL(9, drain_pipe(buf, sizeof(buf)));
+	MEMCMP_EQUAL("abc\nisr!\n", buf, 9);
+}
+
+TEST(ConsoleSync, write_ShouldStayBuffered_BelowWatermark) {
+	char buf[64];
+
+	LONGS_EQUAL(4, console_sync_write("abc\n", 4));
+	LONGS_EQUAL(0, drain_pipe(buf, sizeof(buf)));
+
+	LONGS_EQUAL(0, console_sync_flush());
+	LONGS_EQUAL(4, drain_pipe(buf, sizeof(buf)));
+	MEMCMP_EQUAL("abc\n", buf, 4);
+}
+
+TEST(ConsoleSync, write_ShouldPushOut_WhenPolicyIsImmediate) {
+	char buf[64];
+
+	console_sync_set_flush_policy(CONSOLE_SYNC_FLUSH_IMMEDIATE);
+	LONGS_EQUAL(CONSOLE_SYNC_FLUSH_IMMEDIATE,
+			console_sync_get_flush_policy());
+
+	LONGS_EQUAL(4, console_sync_write("abc\n", 4));
+	LONGS_EQUAL(4, drain_pipe(buf, sizeof(buf)));
+}
+
+TEST(ConsoleSync, write_ShouldPushOut_PastWatermark) {
+	static char line[CONSOLE_SYNC_HIGH_WATERMARK];
+	static char buf[CONSOLE_SYNC_BUFSIZE * 2];
+
+	memset(line, 'x', sizeof(line));
+	LONGS_EQUAL(CONSOLE_SYNC_FLUSH_WATERMARK,
+			console_sync_get_flush_policy());
+	LONGS_EQUAL(sizeof(line), console_sync_write(line, sizeof(line)));
+	LONGS_EQUAL(sizeof(line), drain_pipe(buf, sizeof(buf)));
+}
+
+TEST(ConsoleSync, flush_ShouldWriteQueuedEmergencyRecords) {
+	char buf[64];
+
+	LONGS_EQUAL(6, console_emerg_write("isr!\r\n", 6));
+	LONGS_EQUAL(0, drain_pipe(buf, sizeof(buf)));
+
+	console_sync_flush();
+	LONGS_EQUAL(6, drain_pipe(buf, sizeof(buf)));
+	MEMCMP_EQUAL("isr!\r\n", buf, 6);
+}
+
+static void *flush(void *arg)
+{
+	bool *done = (bool *)arg;
+	console_sync_flush();
+	__atomic_store_n(done, true, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+/* A writer stuck on a full pipe holds the console. A flush waits for it
+ * instead of touching stdio underneath it. */
+TEST(ConsoleSync, flush_ShouldWaitForLock_WhenWriterIsInProgress) {
+	static char buf[1024 * 1024];
+	pthread_t writer;
+	pthread_t flusher;
+	bool flushed = false;
+
+	console_sync_set_flush_policy(CONSOLE_SYNC_FLUSH_IMMEDIATE);
+	fill_pipe();
+
+	pthread_create(&writer, NULL, write_line, NULL);
+	sleep_ms(50);
+	pthread_create(&flusher, NULL, flush, &flushed);
+	sleep_ms(50);
+	CHECK_FALSE(__atomic_load_n(&flushed, __ATOMIC_ACQUIRE));
+
+	while (!__atomic_load_n(&flushed, __ATOMIC_ACQUIRE)) {
+		drain_pipe(buf, sizeof(buf));
+	}
+	pthread_join(writer, NULL);
+	pthread_join(flusher, NULL);
+}
+
+struct reader {
+	char buf[16];
+	int rc;
+	bool done;
+};
+
+static void *read_forever(void *arg)
+{
+	struct reader *r = (struct reader *)arg;
+	r->rc = console_sync_read_timeout(r->buf, sizeof(r->buf), -1);
+	__atomic_store_n(&r->done, true, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+TEST(ConsoleSync, read_ShouldReturnZero_WhenNothingArrivesInTime) {
+	char buf[16];
+	const uint64_t t0 = now_ns();
+
+	LONGS_EQUAL(0, console_sync_read_timeout(buf, sizeof(buf), 30));
+	CHECK(now_ns() - t0 >= 30000000ull);
+}
+
+/* A shell waiting for input must not hold up logging: the writer takes
+ * its own lock, so each line costs the same with or without a reader
+ * parked in console_sync_read_timeout(). */
+TEST(ConsoleSync, write_ShouldNotWaitForReader_WhenReaderIsBlocked) {
+	static char buf[64 * 1024];
+	const uint32_t nr_lines = 2000U;
+	struct reader reader = { {0}, 0, false };
+	pthread_t th;
+	uint64_t worst = 0;
+	uint64_t total = 0;
+
+	console_sync_set_flush_policy(CONSOLE_SYNC_FLUSH_IMMEDIATE);
+	pthread_create(&th, NULL, read_forever, &reader);
+	sleep_ms(20);
+
+	for (uint32_t i = 0; i < nr_lines; i++) {
+		const uint64_t t = now_ns();
+		LONGS_EQUAL(16, console_sync_write("0123456789abcde\n", 16));
+		const uint64_t dt = now_ns() - t;
+		worst = (dt > worst)? dt : worst;
+		total += dt;
+
+		if ((i % 256U) == 0) {
+			drain_pipe(buf, sizeof(buf));
+		}
+	}
+	CHECK_FALSE(__atomic_load_n(&reader.done, __ATOMIC_ACQUIRE));
+
+	CHECK(write(inpipe[1], "help\n", 5) == 5);
+	pthread_join(th, NULL);
+
+	dprintf(saved_stdout, "\n\twrite with reader parked: "
+			"%.0f ns avg, %llu ns worst\n", (double)total / nr_lines,
+			(unsigned long long)worst);
+	LONGS_EQUAL(5, reader.rc);
+	MEMCMP_EQUAL("help\n", reader.buf, 5);
+	CHECK(worst < 20000000ull);
+}
+
+/* Lines per second into a regular file under each policy, the way a host
+ * build logs when its output is redirected. Immediate pays for fflush()
+ * and fsync() on every line; the others for a flush now and then. */
+TEST(ConsoleSync, write_Benchmark_LinesPerSecondByPolicy) {
+	static const struct {
+		console_sync_flush_t policy;
+		const char *name;
+	} policies[] = {
+		{ CONSOLE_SYNC_FLUSH_IMMEDIATE, "immediate:" },
+		{ CONSOLE_SYNC_FLUSH_WATERMARK, "watermark:" },
+		{ CONSOLE_SYNC_FLUSH_PERIODIC,  "periodic:" },
+	};
+	static const char line[] = "12345: [I] src/main.c:42 sensor 3 ok\n";
+	const uint64_t budget_ns = 200000000ull;
+	FILE *file = tmpfile();
+
+	CHECK(file != NULL);
+	fflush(stdout);
+	dup2(fileno(file), STDOUT_FILENO);
+
+	for (size_t i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+		uint32_t nr_lines = 0;
+
+		LONGS_EQUAL(0, console_sync_set_flush_policy(
+				policies[i].policy));
+
+		const uint64_t t0 = now_ns();
+		uint64_t elapsed;
+		do {
+			for (uint32_t j = 0; j < 64U; j++) {
+				LONGS_EQUAL(sizeof(line) - 1U, console_sync_write(
+						line, sizeof(line) - 1U));
+			}
+			nr_lines += 64U;
+			elapsed = now_ns() - t0;
+		} while (elapsed < budget_ns);
+		console_sync_flush();
+		elapsed = now_ns() - t0;
+
+		dprintf(saved_stdout, "\n\t%-10s %9.0f lines/s", policies[i].name,
+				(double)nr_lines * 1e9 / (double)elapsed);
+	}
+	dprintf(saved_stdout, "\n");
+
+	fflush(stdout);
+	dup2(pipefd[1], STDOUT_FILENO);
+	fclose(file);
+}
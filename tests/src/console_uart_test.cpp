@@ -0,0 +1,784 @@
+#include "CppUTest/TestHarness.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "console_uart.h"
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/ring_buffer.h>
+
+#define UART_FIFO_SIZE		16U
+#define WIRE_CAPTURE_SIZE	4096U
+#define POLL_INTERVAL_MS	10U /* CONSOLE_SYNC_POLL_INTERVAL_MS */
+
+/* The UART: a FIFO that empties at the line rate, and a thread that runs
+ * the interrupt handler each time it does. The handler and every spinlock
+ * share one mutex, which is what masking the interrupt amounts to. */
+static struct device uart = { "uart0" };
+static pthread_mutex_t irq = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t line_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t line;
+static bool running;
+static bool stalled;
+static uint64_t ns_per_byte;
+
+static uart_irq_callback_user_data_t isr;
+static void *isr_data;
+static bool rx_enabled;
+static bool tx_enabled;
+static uint32_t fifo_level;
+
+static const uint8_t *rx_pending;
+static size_t rx_pending_len;
+
+/* The receive FIFO as uart_poll_in() sees it, with no interrupt to empty
+ * it. Bytes arriving while it is full are lost. */
+static uint8_t rx_fifo[UART_FIFO_SIZE];
+static uint32_t rx_fifo_level;
+static uint32_t rx_fifo_lost;
+
+static uint8_t wire[WIRE_CAPTURE_SIZE];
+static size_t wire_len;
+static uint32_t wire_errors;
+static uint8_t wire_next;
+static uint32_t nr_irqs;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until_ns(uint64_t t)
+{
+	const struct timespec ts = {
+		(time_t)(t / 1000000000ull), (long)(t % 1000000000ull),
+	};
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+bool device_is_ready(const struct device *dev)
+{
+	return dev != NULL;
+}
+
+int k_sem_init(struct k_sem *sem, unsigned int initial, unsigned int limit)
+{
+	pthread_mutex_init(&sem->lock, NULL);
+	pthread_cond_init(&sem->cond, NULL);
+	sem->count = initial;
+	sem->limit = limit;
+	return 0;
+}
+
+int k_sem_take(struct k_sem *sem, k_timeout_t timeout)
+{
+	struct timespec ts; /* pthread_cond_timedwait() counts on this clock */
+	int err = 0;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	const uint64_t deadline = (uint64_t)ts.tv_sec * 1000000000ull +
+		(uint64_t)ts.tv_nsec + (uint64_t)timeout.ms * 1000000ull;
+	ts.tv_sec = (time_t)(deadline / 1000000000ull);
+	ts.tv_nsec = (long)(deadline % 1000000000ull);
+
+	pthread_mutex_lock(&sem->lock);
+	while (sem->count == 0 && err == 0) {
+		if (timeout.ms < 0) {
+			pthread_cond_wait(&sem->cond, &sem->lock);
+		} else if (timeout.ms == 0) {
+			err = -1;
+		} else if (pthread_cond_timedwait(&sem->cond, &sem->lock, &ts)) {
+			err = (sem->count == 0)? -1 : 0;
+		}
+	}
+	if (err == 0) {
+		sem->count--;
+	}
+	pthread_mutex_unlock(&sem->lock);
+
+	return err;
+}
+
+void k_sem_give(struct k_sem *sem)
+{
+	pthread_mutex_lock(&sem->lock);
+	if (sem->count < sem->limit) {
+		sem->count++;
+	}
+	pthread_cond_signal(&sem->cond);
+	pthread_mutex_unlock(&sem->lock);
+}
+
+k_spinlock_key_t k_spin_lock(struct k_spinlock *lock)
+{
+	(void)lock;
+	pthread_mutex_lock(&irq);
+	return 0;
+}
+
+void k_spin_unlock(struct k_spinlock *lock, k_spinlock_key_t key)
+{
+	(void)lock;
+	(void)key;
+	pthread_mutex_unlock(&irq);
+}
+
+void ring_buf_init(struct ring_buf *buf, uint32_t size, uint8_t *data)
+{
+	buf->buffer = data;
+	buf->size = size;
+	buf->head = 0;
+	buf->tail = 0;
+}
+
+uint32_t ring_buf_put_claim(struct ring_buf *buf, uint8_t **data,
+		uint32_t size)
+{
+	const uint32_t offset = buf->head % buf->size;
+	uint32_t n = buf->size - (buf->head - buf->tail);
+
+	n = (n < buf->size - offset)? n : buf->size - offset;
+	n = (n < size)? n : size;
+	*data = &buf->buffer[offset];
+
+	return n;
+}
+
+int ring_buf_put_finish(struct ring_buf *buf, uint32_t size)
+{
+	buf->head += size;
+	return 0;
+}
+
+uint32_t ring_buf_put(struct ring_buf *buf, const uint8_t *data,
+		uint32_t size)
+{
+	uint32_t total = 0;
+	uint8_t *p;
+	uint32_t n;
+
+	while (total < size &&
+			(n = ring_buf_put_claim(buf, &p, size - total)) > 0) {
+		memcpy(p, &data[total], n);
+		ring_buf_put_finish(buf, n);
+		total += n;
+	}
+
+	return total;
+}
+
+uint32_t ring_buf_get_claim(struct ring_buf *buf, uint8_t **data,
+		uint32_t size)
+{
+	const uint32_t offset = buf->tail % buf->size;
+	uint32_t n = buf->head - buf->tail;
+
+	n = (n < buf->size - offset)? n : buf->size - offset;
+	n = (n < size)? n : size;
+	*data = &buf->buffer[offset];
+
+	return n;
+}
+
+int ring_buf_get_finish(struct ring_buf *buf, uint32_t size)
+{
+	buf->tail += size;
+	return 0;
+}
+
+uint32_t ring_buf_get(struct ring_buf *buf, uint8_t *data, uint32_t size)
+{
+	uint32_t total = 0;
+	uint8_t *p;
+	uint32_t n;
+
+	while (total < size &&
+			(n = ring_buf_get_claim(buf, &p, size - total)) > 0) {
+		memcpy(&data[total], p, n);
+		ring_buf_get_finish(buf, n);
+		total += n;
+	}
+
+	return total;
+}
+
+int uart_irq_callback_user_data_set(const struct device *dev,
+		uart_irq_callback_user_data_t cb, void *user_data)
+{
+	(void)dev;
+	isr = cb;
+	isr_data = user_data;
+	return 0;
+}
+
+void uart_irq_rx_enable(const struct device *dev)
+{
+	(void)dev;
+	rx_enabled = true;
+}
+
+void uart_irq_rx_disable(const struct device *dev)
+{
+	(void)dev;
+	rx_enabled = false;
+}
+
+/* Called by writers outside the handler, like enabling the interrupt on
+ * the target, which fires it at once when the FIFO is empty. */
+void uart_irq_tx_enable(const struct device *dev)
+{
+	(void)dev;
+	pthread_mutex_lock(&irq);
+	tx_enabled = true;
+	pthread_cond_signal(&line_cond);
+	pthread_mutex_unlock(&irq);
+}
+
+/* Called only from the handler, with the interrupt already masked. */
+void uart_irq_tx_disable(const struct device *dev)
+{
+	(void)dev;
+	tx_enabled = false;
+}
+
+int uart_irq_update(const struct device *dev)
+{
+	(void)dev;
+	return 1;
+}
+
+int uart_irq_rx_ready(const struct device *dev)
+{
+	(void)dev;
+	return rx_enabled && rx_pending_len > 0;
+}
+
+int uart_irq_tx_ready(const struct device *dev)
+{
+	(void)dev;
+	return tx_enabled && fifo_level == 0;
+}
+
+int uart_irq_is_pending(const struct device *dev)
+{
+	return uart_irq_rx_ready(dev) || uart_irq_tx_ready(dev);
+}
+
+int uart_fifo_read(const struct device *dev, uint8_t *rx_data, int size)
+{
+	size_t n = (size_t)size;
+
+	(void)dev;
+	n = (n < rx_pending_len)? n : rx_pending_len;
+	n = (n < UART_FIFO_SIZE)? n : UART_FIFO_SIZE;
+	memcpy(rx_data, rx_pending, n);
+	rx_pending += n;
+	rx_pending_len -= n;
+
+	return (int)n;
+}
+
+static void put_wire(uint8_t c)
+{
+	if (wire_len < sizeof(wire)) {
+		wire[wire_len] = c;
+	}
+	if (c != wire_next) {
+		wire_errors++;
+	}
+	wire_next = (uint8_t)(c + 1U);
+	wire_len++;
+}
+
+int uart_fifo_fill(const struct device *dev, const uint8_t *tx_data,
+		int size)
+{
+	uint32_t n = (uint32_t)size;
+
+	(void)dev;
+	n = (n < UART_FIFO_SIZE - fifo_level)? n : UART_FIFO_SIZE - fifo_level;
+
+	for (uint32_t i = 0; i < n; i++) {
+		put_wire(tx_data[i]);
+	}
+	fifo_level += n;
+
+	return (int)n;
+}
+
+int uart_poll_in(const struct device *dev, unsigned char *p_char)
+{
+	int rc = -1;
+
+	(void)dev;
+	pthread_mutex_lock(&irq);
+	if (rx_fifo_level > 0) {
+		*p_char = rx_fifo[0];
+		memmove(rx_fifo, &rx_fifo[1], --rx_fifo_level);
+		rc = 0;
+	}
+	pthread_mutex_unlock(&irq);
+
+	return rc;
+}
+
+/* Returns once the byte has left the line, spinning meanwhile as the
+ * driver does. */
+void uart_poll_out(const struct device *dev, unsigned char out_char)
+{
+	(void)dev;
+	pthread_mutex_lock(&irq);
+	put_wire(out_char);
+	pthread_mutex_unlock(&irq);
+
+	const uint64_t done = now_ns() + ns_per_byte;
+	while (now_ns() < done) {
+	}
+}
+
+/* printk() formats each character and hands it to uart_poll_out(). */
+static void printk(const char *fmt, ...)
+	__attribute__((format(printf, 1, 2)));
+static void printk(const char *fmt, ...)
+{
+	char buf[16];
+	va_list ap;
+
+	va_start(ap, fmt);
+	const int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	for (int i = 0; i < len && i < (int)sizeof(buf) - 1; i++) {
+		uart_poll_out(&uart, (unsigned char)buf[i]);
+	}
+}
+
+static void *run_line(void *arg)
+{
+	uint64_t free_at = 0;
+
+	(void)arg;
+	pthread_mutex_lock(&irq);
+
+	while (running) {
+		if (fifo_level > 0) {
+			/* Line time runs on from the last load for as long
+			 * as the driver keeps the FIFO fed, so the host
+			 * waking late does not count as an idle line. */
+			free_at = ((free_at != 0)? free_at : now_ns()) +
+				fifo_level * ns_per_byte;
+			fifo_level = 0;
+			pthread_mutex_unlock(&irq);
+			if (ns_per_byte > 0) {
+				sleep_until_ns(free_at);
+			} else {
+				sched_yield();
+			}
+			pthread_mutex_lock(&irq);
+			continue;
+		}
+		if (stalled || !tx_enabled) {
+			free_at = 0;
+			pthread_cond_wait(&line_cond, &irq);
+			continue;
+		}
+
+		nr_irqs++;
+		(*isr)(&uart, isr_data);
+	}
+
+	pthread_mutex_unlock(&irq);
+	return NULL;
+}
+
+/* Bytes arriving on the line, one interrupt for the lot. */
+static void receive(const void *data, size_t len)
+{
+	pthread_mutex_lock(&irq);
+	rx_pending = (const uint8_t *)data;
+	rx_pending_len = len;
+	(*isr)(&uart, isr_data);
+	rx_pending_len = 0;
+	pthread_mutex_unlock(&irq);
+}
+
+static void wait_for_wire(size_t len)
+{
+	const uint64_t deadline = now_ns() + 2000000000ull;
+	size_t n;
+
+	do {
+		pthread_mutex_lock(&irq);
+		n = wire_len;
+		pthread_mutex_unlock(&irq);
+		sched_yield();
+	} while (n < len && now_ns() < deadline);
+}
+
+static void fill_pattern(uint8_t *buf, size_t len, uint8_t *next)
+{
+	for (size_t i = 0; i < len; i++) {
+		buf[i] = (*next)++;
+	}
+}
+
+typedef int (*write_fn_t)(const void *data, size_t len);
+
+/* The console write before console_uart: one printk("%c") per byte. */
+static int write_polled(const void *data, size_t len)
+{
+	const uint8_t *p = (const uint8_t *)data;
+
+	for (size_t i = 0; i < len; i++) {
+		printk("%c", p[i]);
+	}
+
+	return (int)len;
+}
+
+/* Log lines written faster than 1 Mbaud takes them. Returns the share of
+ * the time the line was busy. */
+static double write_lines_at_line_rate(write_fn_t write, const char *name)
+{
+	uint8_t line_buf[64];
+	uint8_t next = 0;
+	const uint32_t nr_lines = 1024U;
+	uint64_t worst = 0;
+	uint64_t total = 0;
+
+	ns_per_byte = 10000U; /* 1 Mbaud, 8N1 */
+	const uint64_t t0 = now_ns();
+
+	for (uint32_t i = 0; i < nr_lines; i++) {
+		fill_pattern(line_buf, sizeof(line_buf), &next);
+		const uint64_t t = now_ns();
+		LONGS_EQUAL(sizeof(line_buf),
+				(*write)(line_buf, sizeof(line_buf)));
+		const uint64_t dt = now_ns() - t;
+		worst = (dt > worst)? dt : worst;
+		total += dt;
+	}
+	wait_for_wire(sizeof(line_buf) * nr_lines);
+
+	const uint64_t elapsed = now_ns() - t0;
+	const double bytes = (double)(sizeof(line_buf) * nr_lines);
+	const double busy = bytes * (double)ns_per_byte / (double)elapsed;
+
+	printf("\n\t%s line: %.0f KiB/s, %.0f%% busy, %.2f irqs/KiB, "
+			"write %.0f ns avg %llu ns worst\n", name,
+			bytes / 1024.0 / ((double)elapsed / 1e9), busy * 100.0,
+			(double)nr_irqs / (bytes / 1024.0),
+			(double)total / nr_lines, (unsigned long long)worst);
+	LONGS_EQUAL(sizeof(line_buf) * nr_lines, wire_len);
+	LONGS_EQUAL(0, wire_errors);
+
+	return busy;
+}
+
+/* Software cost alone, with a line that never holds the FIFO back. */
+static void write_to_free_line(write_fn_t write, const char *name)
+{
+	static uint8_t buf[CONSOLE_UART_TX_BUFSIZE / 4];
+	const size_t total = 8U * 1024U * 1024U;
+	uint8_t next = 0;
+
+	const uint64_t t0 = now_ns();
+	for (size_t sent = 0; sent < total; sent += sizeof(buf)) {
+		fill_pattern(buf, sizeof(buf), &next);
+		LONGS_EQUAL(sizeof(buf), (*write)(buf, sizeof(buf)));
+	}
+	wait_for_wire(total);
+	const uint64_t elapsed = now_ns() - t0;
+
+	printf("\n\t%s free line: %.1f MiB/s\n", name,
+			(double)total / (1024.0 * 1024.0) /
+			((double)elapsed / 1e9));
+	LONGS_EQUAL(total, wire_len);
+	LONGS_EQUAL(0, wire_errors);
+}
+
+struct sender {
+	pthread_t thread;
+	size_t len;
+	bool polled;
+	bool done;
+};
+
+/* Bytes arriving at 1 Mbaud, a FIFO load at a time. With the interrupt
+ * the handler takes each load; without it they pile up in the FIFO until
+ * uart_poll_in() gets to them. */
+static void *send_at_line_rate(void *arg)
+{
+	struct sender *sender = (struct sender *)arg;
+	uint8_t chunk[UART_FIFO_SIZE];
+	uint8_t next = 0;
+	const uint64_t t0 = now_ns();
+
+	for (size_t sent = 0; sent < sender->len; sent += sizeof(chunk)) {
+		sleep_until_ns(t0 + (sent + sizeof(chunk)) * 10000U);
+		fill_pattern(chunk, sizeof(chunk), &next);
+
+		if (!sender->polled) {
+			receive(chunk, sizeof(chunk));
+			continue;
+		}
+
+		pthread_mutex_lock(&irq);
+		for (size_t i = 0; i < sizeof(chunk); i++) {
+			if (rx_fifo_level < sizeof(rx_fifo)) {
+				rx_fifo[rx_fifo_level++] = chunk[i];
+			} else {
+				rx_fifo_lost++;
+			}
+		}
+		pthread_mutex_unlock(&irq);
+	}
+
+	__atomic_store_n(&sender->done, true, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+/* The console read before console_uart: uart_poll_in() per byte until
+ * nothing is left, then another look after the poll interval. */
+static size_t read_polled(uint8_t *buf, size_t bufsize)
+{
+	size_t n = 0;
+
+	while (n < bufsize && uart_poll_in(&uart, &buf[n]) == 0) {
+		n++;
+	}
+	if (n == 0) {
+		const struct timespec ts = { 0, POLL_INTERVAL_MS * 1000000L };
+		nanosleep(&ts, NULL);
+	}
+
+	return n;
+}
+
+static size_t read_irq(uint8_t *buf, size_t bufsize)
+{
+	const int n = console_uart_read(buf, bufsize, 20);
+	return (n > 0)? (size_t)n : 0;
+}
+
+/* Returns the number of bytes lost on the way in. */
+static size_t read_at_line_rate(bool polled, const char *name)
+{
+	struct sender sender = { .len = 16U * 1024U, .polled = polled };
+	uint8_t buf[CONSOLE_UART_RX_BUFSIZE];
+	uint8_t next = 0;
+	size_t received = 0;
+	uint32_t out_of_order = 0;
+	const uint32_t overruns = console_uart_rx_overruns();
+
+	rx_fifo_level = 0;
+	rx_fifo_lost = 0;
+	uart_irq_rx_enable(&uart);
+
+	const uint64_t t0 = now_ns();
+	pthread_create(&sender.thread, NULL, send_at_line_rate, &sender);
+
+	for (;;) {
+		const bool done = __atomic_load_n(&sender.done,
+				__ATOMIC_ACQUIRE);
+		const size_t n = polled? read_polled(buf, sizeof(buf)) :
+			read_irq(buf, sizeof(buf));
+
+		for (size_t i = 0; i < n; i++) {
+			out_of_order += (buf[i] != next);
+			next = (uint8_t)(buf[i] + 1U);
+		}
+		received += n;
+
+		if (done && n == 0) {
+			break;
+		}
+	}
+
+	const uint64_t elapsed = now_ns() - t0;
+	pthread_join(sender.thread, NULL);
+
+	const size_t lost = polled? rx_fifo_lost :
+		console_uart_rx_overruns() - overruns;
+	printf("\n\t%s rx: %.0f KiB/s, %zu of %zu bytes lost\n", name,
+			(double)received / 1024.0 / ((double)elapsed / 1e9),
+			lost, sender.len);
+	LONGS_EQUAL(sender.len, received + lost);
+	if (lost == 0) {
+		LONGS_EQUAL(0, out_of_order);
+	}
+
+	return lost;
+}
+
+TEST_GROUP(ConsoleUart) {
+	void setup(void) {
+		running = true;
+		stalled = false;
+		ns_per_byte = 0;
+		tx_enabled = false;
+		fifo_level = 0;
+		wire_len = 0;
+		wire_errors = 0;
+		wire_next = 0;
+		nr_irqs = 0;
+
+		LONGS_EQUAL(0, console_uart_init(&uart));
+		pthread_create(&line, NULL, run_line, NULL);
+	}
+	void teardown(void) {
+		pthread_mutex_lock(&irq);
+		running = false;
+		pthread_cond_signal(&line_cond);
+		pthread_mutex_unlock(&irq);
+		pthread_join(line, NULL);
+	}
+};
+
+TEST(ConsoleUart, init_ShouldFail_WhenDeviceIsNotReady) {
+	LONGS_EQUAL(-ENODEV, console_uart_init(NULL));
+}
+
+TEST(ConsoleUart, write_ShouldSendBytesInOrder) {
+	const char msg[] = "hello, console\n";
+
+	LONGS_EQUAL(sizeof(msg) - 1, console_uart_write(msg, sizeof(msg) - 1));
+	wait_for_wire(sizeof(msg) - 1);
+
+	LONGS_EQUAL(sizeof(msg) - 1, wire_len);
+	MEMCMP_EQUAL(msg, wire, sizeof(msg) - 1);
+}
+
+TEST(ConsoleUart, write_ShouldSendInFifoSizedBursts) {
+	uint8_t buf[CONSOLE_UART_TX_BUFSIZE / 2];
+	uint8_t next = 0;
+
+	stalled = true;
+	fill_pattern(buf, sizeof(buf), &next);
+	LONGS_EQUAL(sizeof(buf), console_uart_write(buf, sizeof(buf)));
+
+	pthread_mutex_lock(&irq);
+	stalled = false;
+	pthread_cond_signal(&line_cond);
+	pthread_mutex_unlock(&irq);
+	wait_for_wire(sizeof(buf));
+
+	LONGS_EQUAL(sizeof(buf), wire_len);
+	LONGS_EQUAL(0, wire_errors);
+	/* one per FIFO load, and one more that finds the ring empty */
+	LONGS_EQUAL(sizeof(buf) / UART_FIFO_SIZE + 1, nr_irqs);
+}
+
+TEST(ConsoleUart, write_ShouldWaitForRoom_WhenRingIsFull) {
+	uint8_t buf[CONSOLE_UART_TX_BUFSIZE * 4];
+	uint8_t next = 0;
+
+	fill_pattern(buf, sizeof(buf), &next);
+	LONGS_EQUAL(sizeof(buf), console_uart_write(buf, sizeof(buf)));
+	wait_for_wire(sizeof(buf));
+
+	LONGS_EQUAL(sizeof(buf), wire_len);
+	LONGS_EQUAL(0, wire_errors);
+}
+
+TEST(ConsoleUart, write_ShouldGiveUpAfterTimeout_WhenLineIsStuck) {
+	static uint8_t buf[CONSOLE_UART_TX_BUFSIZE * 2];
+
+	stalled = true;
+	const uint64_t t0 = now_ns();
+	const int n = console_uart_write(buf, sizeof(buf));
+	const uint64_t dt = now_ns() - t0;
+
+	LONGS_EQUAL(CONSOLE_UART_TX_BUFSIZE, n);
+	CHECK(dt >= (uint64_t)CONSOLE_UART_TX_TIMEOUT_MS * 1000000ull);
+	CHECK(dt < (uint64_t)CONSOLE_UART_TX_TIMEOUT_MS * 3000000ull);
+}
+
+TEST(ConsoleUart, read_ShouldReturnReceivedBytes) {
+	const char msg[] = "mcumgr";
+	char buf[16];
+
+	receive(msg, sizeof(msg) - 1);
+
+	LONGS_EQUAL(sizeof(msg) - 1, console_uart_read(buf, sizeof(buf), 0));
+	MEMCMP_EQUAL(msg, buf, sizeof(msg) - 1);
+	LONGS_EQUAL(0, console_uart_read(buf, sizeof(buf), 0));
+}
+
+TEST(ConsoleUart, read_ShouldReturnZero_WhenNothingArrivesInTime) {
+	char buf[16];
+	const uint64_t t0 = now_ns();
+
+	LONGS_EQUAL(0, console_uart_read(buf, sizeof(buf), 20));
+	CHECK(now_ns() - t0 >= 20000000ull);
+}
+
+static void *receive_later(void *arg)
+{
+	struct timespec ts = { 0, 10000000 };
+
+	nanosleep(&ts, NULL);
+	receive(arg, 1);
+	return NULL;
+}
+
+TEST(ConsoleUart, read_ShouldWakeOnFirstByte) {
+	char c = 'x';
+	char buf[4];
+	pthread_t th;
+
+	pthread_create(&th, NULL, receive_later, &c);
+	LONGS_EQUAL(1, console_uart_read(buf, sizeof(buf), -1));
+	BYTES_EQUAL('x', buf[0]);
+	pthread_join(th, NULL);
+}
+
+TEST(ConsoleUart, rx_ShouldCountLostBytes_WhenRingIsFull) {
+	static uint8_t in[CONSOLE_UART_RX_BUFSIZE + 44U];
+	static uint8_t out[sizeof(in)];
+	uint8_t next = 0;
+	const uint32_t before = console_uart_rx_overruns();
+
+	fill_pattern(in, sizeof(in), &next);
+	receive(in, sizeof(in));
+
+	LONGS_EQUAL(44, console_uart_rx_overruns() - before);
+	LONGS_EQUAL(CONSOLE_UART_RX_BUFSIZE,
+			console_uart_read(out, sizeof(out), 0));
+	MEMCMP_EQUAL(in, out, CONSOLE_UART_RX_BUFSIZE);
+}
+
+/* Log lines written faster than 1 Mbaud takes them. The line should never
+ * go idle while the ring holds bytes, and writers wait only for room. */
+TEST(ConsoleUart, write_ShouldKeepLineBusy_AtLineRate) {
+	CHECK(write_lines_at_line_rate(console_uart_write, "irq") > 0.8);
+}
+
+TEST(ConsoleUart, write_ShouldMoveBytesFast_WhenLineIsFree) {
+	write_to_free_line(console_uart_write, "irq");
+}
+
+TEST(ConsoleUart, read_ShouldLoseNothing_AtLineRate) {
+	LONGS_EQUAL(0, read_at_line_rate(false, "irq"));
+}
+
+/* The same workloads through the per-byte path console_uart replaced,
+ * for comparison. */
+TEST(ConsoleUart, write_Benchmark_PolledAtLineRate) {
+	write_lines_at_line_rate(write_polled, "polled");
+}
+
+TEST(ConsoleUart, write_Benchmark_PolledWhenLineIsFree) {
+	write_to_free_line(write_polled, "polled");
+}
+
+TEST(ConsoleUart, read_Benchmark_PolledAtLineRate) {
+	read_at_line_rate(true, "polled");
+}
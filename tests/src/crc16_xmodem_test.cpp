@@ -0,0 +1,136 @@
+#include "CppUTest/TestHarness.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "crc16_xmodem.h"
+
+/* libmcu's crc16_xmodem(), one bit at a time, as the reference. */
+static uint16_t crc16_bitwise(uint16_t crc, const uint8_t *p, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		crc ^= (uint16_t)(p[i] << 8);
+		for (int k = 0; k < 8; k++) {
+			crc = (crc & 0x8000U)? (uint16_t)((crc << 1) ^ 0x1021U) :
+				(uint16_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void fill_random(uint8_t *buf, size_t len, uint32_t seed)
+{
+	uint32_t x = seed * 2654435761u + 1u;
+
+	for (size_t i = 0; i < len; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		buf[i] = (uint8_t)x;
+	}
+}
+
+static uint8_t buf[2048 + 8];
+
+TEST_GROUP(Crc16Xmodem) {
+	void setup(void) {
+		fill_random(buf, sizeof(buf), CRC16_XMODEM_IMPL);
+	}
+	void teardown(void) {
+	}
+};
+
+TEST(Crc16Xmodem, update_ShouldMatchCheckValue) {
+	LONGS_EQUAL(0x31C3, crc16_xmodem_update(CRC16_XMODEM_INIT,
+			"123456789", 9));
+}
+
+TEST(Crc16Xmodem, update_ShouldReturnInit_WhenEmpty) {
+	LONGS_EQUAL(CRC16_XMODEM_INIT,
+			crc16_xmodem_update(CRC16_XMODEM_INIT, buf, 0));
+	LONGS_EQUAL(0x1234, crc16_xmodem_update(0x1234, buf, 0));
+}
+
+/* Every length through a few slices' worth, from every alignment, so the
+ * slice loop and the byte-wise tail both meet every case. */
+TEST(Crc16Xmodem, update_ShouldMatchBitwise_ForAnyLengthAndAlignment) {
+	for (size_t offset = 0; offset < 8; offset++) {
+		for (size_t len = 0; len <= 64; len++) {
+			LONGS_EQUAL(crc16_bitwise(0, &buf[offset], len),
+					crc16_xmodem_update(CRC16_XMODEM_INIT,
+						&buf[offset], len));
+		}
+	}
+	LONGS_EQUAL(crc16_bitwise(0, buf, 2048),
+			crc16_xmodem_update(CRC16_XMODEM_INIT, buf, 2048));
+}
+
+TEST(Crc16Xmodem, update_ShouldMatchBitwise_ForAnyStartingCrc) {
+	for (uint32_t crc = 0; crc <= 0xFFFFU; crc += 0x0101U) {
+		LONGS_EQUAL(crc16_bitwise((uint16_t)crc, buf, 37),
+				crc16_xmodem_update((uint16_t)crc, buf, 37));
+	}
+}
+
+TEST(Crc16Xmodem, update_ShouldGiveSameResult_WhenFedInPieces) {
+	const uint16_t whole = crc16_xmodem_update(CRC16_XMODEM_INIT, buf, 100);
+
+	for (size_t a = 0; a <= 100; a += 3) {
+		for (size_t b = a; b <= 100; b += 7) {
+			uint16_t crc = CRC16_XMODEM_INIT;
+			crc = crc16_xmodem_update(crc, buf, a);
+			crc = crc16_xmodem_update(crc, &buf[a], b - a);
+			crc = crc16_xmodem_update(crc, &buf[b], 100 - b);
+			LONGS_EQUAL(whole, crc);
+		}
+	}
+}
+
+/* The SMP receivers rely on this: the CRC appended big-endian makes the
+ * whole frame fold to zero. */
+TEST(Crc16Xmodem, update_ShouldFoldToZero_WhenCrcIsAppended) {
+	uint8_t frame[130];
+
+	memcpy(frame, buf, 128);
+	const uint16_t crc = crc16_xmodem_update(CRC16_XMODEM_INIT, frame, 128);
+	frame[128] = (uint8_t)(crc >> 8);
+	frame[129] = (uint8_t)crc;
+
+	LONGS_EQUAL(0, crc16_xmodem_update(CRC16_XMODEM_INIT,
+			frame, sizeof(frame)));
+}
+
+/* Throughput over SMP-sized packets against the bitwise reference. The
+ * test build is unoptimized and instrumented, which favours the plain
+ * table; compare the implementations with -O2 for real numbers. */
+TEST(Crc16Xmodem, update_Benchmark) {
+	const size_t len = 1032;
+	const uint32_t rounds = 4000;
+	volatile uint16_t sink = 0;
+
+	uint64_t t0 = now_ns();
+	for (uint32_t i = 0; i < rounds; i++) {
+		sink = (uint16_t)(sink ^ crc16_xmodem_update(
+				CRC16_XMODEM_INIT, &buf[i & 7U], len));
+	}
+	const double ns = (double)(now_ns() - t0);
+
+	t0 = now_ns();
+	for (uint32_t i = 0; i < rounds; i++) {
+		sink = (uint16_t)(sink ^ crc16_bitwise(0, &buf[i & 7U], len));
+	}
+	const double ns_ref = (double)(now_ns() - t0);
+
+	const double mib = (double)len * rounds / (1024.0 * 1024.0);
+	printf("\n\tslice-by-%d: %.1f MiB/s, bitwise %.1f MiB/s, %.1fx\n",
+			CRC16_XMODEM_IMPL, mib / (ns / 1e9),
+			mib / (ns_ref / 1e9), ns_ref / ns);
+	CHECK(ns < ns_ref);
+}
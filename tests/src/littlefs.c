@@ -0,0 +1,5 @@
+/* littlefs built as one unit. Its directory is given with -isystem, so
+ * the warnings the tests hold this tree to are not applied to it. */
+#include "lfs.c"
+#include "lfs_util.c"
+#include "bd/lfs_filebd.c"
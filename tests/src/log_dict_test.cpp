@@ -0,0 +1,188 @@
+#include "CppUTest/TestHarness.h"
+
+#include <string.h>
+
+#include "logging.h"
+#include "log_dict.h"
+#include "log_line.h"
+
+static uint8_t written[LOG_DICT_FRAME_MAXLEN];
+static size_t written_len;
+static uint32_t now;
+
+size_t logging_write_encoded(const void *data, size_t size)
+{
+	memcpy(written, data, size);
+	written_len = size;
+	return size;
+}
+
+static uint32_t get_time(void)
+{
+	return now;
+}
+
+static size_t encode(void *buf, size_t bufsize, logging_t type,
+		const char *fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	size_t len = log_dict_encode(buf, bufsize, type, fmt, ap);
+	va_end(ap);
+	return len;
+}
+
+static uint32_t le32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+		(uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* A 32-bit field as it appears in a frame, escapes included. */
+static size_t escape32(uint8_t out[8], uint32_t v)
+{
+	size_t n = 0;
+
+	for (int i = 0; i < 4; i++, v >>= 8) {
+		const uint8_t b = (uint8_t)v;
+		if (b == LOG_DICT_SYNC || b == LOG_DICT_ESC || b == '\n') {
+			out[n++] = LOG_DICT_ESC;
+			out[n++] = (uint8_t)(b ^ 0x20U);
+		} else {
+			out[n++] = b;
+		}
+	}
+
+	return n;
+}
+
+TEST_GROUP(LogDict) {
+	uint8_t frame[LOG_DICT_FRAME_MAXLEN];
+	uint8_t record[LOG_DICT_RECORD_MAXLEN];
+
+	void setup(void) {
+		now = 0;
+		written_len = 0;
+		log_dict_init(get_time);
+	}
+	void teardown(void) {
+	}
+
+	void check_framed(const uint8_t *p, size_t len) {
+		LONGS_EQUAL(LOG_DICT_SYNC, p[0]);
+		for (size_t i = 1; i < len; i++) {
+			CHECK(p[i] != LOG_DICT_SYNC);
+			CHECK(p[i] != '\n');
+		}
+	}
+};
+
+TEST(LogDict, encode_ShouldRoundTripHeaderAndArguments) {
+	static const char fmt[] = "%d %u %s %c";
+	now = 0x12345678;
+
+	size_t len = encode(frame, sizeof(frame), LOGGING_TYPE_WARN, fmt,
+			-1, 7u, "abc", 'x');
+	CHECK(len > 0);
+	check_framed(frame, len);
+
+	size_t n = log_dict_decode(record, sizeof(record), frame, len);
+	LONGS_EQUAL(LOG_DICT_HDR_SIZE + 4 + 4 + 4 + 4, n);
+	LONGS_EQUAL(LOGGING_TYPE_WARN, record[0]);
+	LONGS_EQUAL(n - LOG_DICT_HDR_SIZE, record[1] | record[2] << 8);
+	LONGS_EQUAL(0x12345678, le32(&record[3]));
+	LONGS_EQUAL((uint32_t)(uintptr_t)fmt, le32(&record[7]));
+	LONGS_EQUAL(0xffffffff, le32(&record[11]));
+	LONGS_EQUAL(7, le32(&record[15]));
+	LONGS_EQUAL(3, record[19]);
+	MEMCMP_EQUAL("abc", &record[20], 3);
+	LONGS_EQUAL('x', le32(&record[23]));
+}
+
+TEST(LogDict, encode_ShouldEscapeSyncEscapeAndNewline) {
+	static const char fmt[] = "%x";
+	now = 0x0aa6a50a;
+
+	size_t len = encode(frame, sizeof(frame), LOGGING_TYPE_INFO, fmt,
+			0xa5a60aa5u);
+	check_framed(frame, len);
+	/* the format address lands anywhere, so its bytes may need escaping
+	 * as well */
+	uint8_t site[8];
+	LONGS_EQUAL(1 + LOG_DICT_HDR_SIZE + 4 + 4 +
+			escape32(site, (uint32_t)(uintptr_t)fmt), len);
+
+	size_t n = log_dict_decode(record, sizeof(record), frame, len);
+	LONGS_EQUAL(LOG_DICT_HDR_SIZE + 4, n);
+	LONGS_EQUAL(0x0aa6a50a, le32(&record[3]));
+	LONGS_EQUAL(0xa5a60aa5, le32(&record[11]));
+}
+
+TEST(LogDict, encode_ShouldReturnZero_WhenFrameDoesNotFit) {
+	size_t len = encode(frame, sizeof(frame), LOGGING_TYPE_INFO, "%d", 1);
+	LONGS_EQUAL(0, encode(frame, len - 1, LOGGING_TYPE_INFO, "%d", 1));
+}
+
+TEST(LogDict, encode_ShouldReturnZero_WhenRecordDoesNotFit) {
+	static const char fmt[] = "%s%s%s%s%s";
+	const char *s = "0123456789012345678901234567890123456789";
+	LONGS_EQUAL(0, encode(frame, sizeof(frame), LOGGING_TYPE_INFO, fmt,
+			s, s, s, s, s));
+}
+
+TEST(LogDict, decode_ShouldReject_WhenFrameIsCutOrCorrupted) {
+	size_t len = encode(frame, sizeof(frame), LOGGING_TYPE_INFO, "%d", 1);
+
+	LONGS_EQUAL(0, log_dict_decode(record, sizeof(record), frame,
+			len - 1));
+	LONGS_EQUAL(0, log_dict_decode(record, sizeof(record), frame + 1,
+			len - 1));
+
+	frame[5] = LOG_DICT_SYNC;
+	LONGS_EQUAL(0, log_dict_decode(record, sizeof(record), frame, len));
+
+	frame[5] = LOG_DICT_ESC;
+	frame[6] = 0;
+	LONGS_EQUAL(0, log_dict_decode(record, sizeof(record), frame, len));
+}
+
+TEST(LogDict, save_ShouldPassFrameToBackend) {
+	size_t len = log_dict_save(LOGGING_TYPE_ERROR, "%u", 9u);
+	CHECK(len > 0);
+	LONGS_EQUAL(len, written_len);
+	check_framed(written, written_len);
+	LONGS_EQUAL(LOG_DICT_HDR_SIZE + 4,
+			log_dict_decode(record, sizeof(record),
+					written, written_len));
+	LONGS_EQUAL(LOGGING_TYPE_ERROR, record[0]);
+}
+
+TEST(LogDict, parse_ShouldKeyOnFormatAddressAndArguments) {
+	static const char fmt[] = "%u";
+	uint8_t other[LOG_DICT_FRAME_MAXLEN];
+	struct log_line a, b;
+
+	now = 1;
+	size_t alen = encode(frame, sizeof(frame), LOGGING_TYPE_ERROR, fmt, 5u);
+	now = 2;
+	size_t blen = encode(other, sizeof(other), LOGGING_TYPE_ERROR, fmt, 5u);
+
+	log_line_parse(&a, (const char *)frame, alen);
+	log_line_parse(&b, (const char *)other, blen);
+
+	LONGS_EQUAL(LOGGING_TYPE_ERROR, a.level);
+	/* the site is the format address as framed, escapes and all */
+	uint8_t site[8];
+	const size_t site_len = escape32(site, (uint32_t)(uintptr_t)fmt);
+	LONGS_EQUAL(site_len, a.site_len);
+	MEMCMP_EQUAL(site, a.site, site_len);
+	LONGS_EQUAL(log_line_hash(a.site, a.site_len),
+			log_line_hash(b.site, b.site_len));
+	LONGS_EQUAL(log_line_hash(a.body, a.body_len),
+			log_line_hash(b.body, b.body_len));
+
+	blen = encode(other, sizeof(other), LOGGING_TYPE_ERROR, fmt, 6u);
+	log_line_parse(&b, (const char *)other, blen);
+	CHECK(log_line_hash(a.body, a.body_len) !=
+			log_line_hash(b.body, b.body_len));
+}
@@ -0,0 +1,183 @@
+#include "CppUTest/TestHarness.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "log_lz.h"
+
+#define BLOCK_SIZE		4096U
+#define MAX_BLOCK		0x10000U
+
+/* Three lines compressed by the reference lz4 tool, block only. */
+static const char vector_text[] =
+	"1000: [I] <0x1234,0x5678> sensor 3 reading 42\n"
+	"1010: [I] <0x1234,0x5678> sensor 3 reading 43\n"
+	"1020: [I] <0x1234,0x5678> sensor 3 reading 44\n";
+static const uint8_t vector_lz4[] = {
+	0xff, 0x22, 0x31, 0x30, 0x30, 0x30, 0x3a, 0x20, 0x5b, 0x49, 0x5d,
+	0x20, 0x3c, 0x30, 0x78, 0x31, 0x32, 0x33, 0x34, 0x2c, 0x30, 0x78,
+	0x35, 0x36, 0x37, 0x38, 0x3e, 0x20, 0x73, 0x65, 0x6e, 0x73, 0x6f,
+	0x72, 0x20, 0x33, 0x20, 0x72, 0x65, 0x61, 0x64, 0x69, 0x6e, 0x67,
+	0x20, 0x34, 0x32, 0x0a, 0x31, 0x30, 0x31, 0x2e, 0x00, 0x16, 0x5f,
+	0x33, 0x0a, 0x31, 0x30, 0x32, 0x2e, 0x00, 0x13, 0x50, 0x67, 0x20,
+	0x34, 0x34, 0x0a,
+};
+
+static uint16_t table[LOG_LZ_TABLE_LEN];
+static uint8_t src[MAX_BLOCK];
+static uint8_t comp[LOG_LZ_BOUND(MAX_BLOCK)];
+static uint8_t out[MAX_BLOCK];
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Lines as the store sees them: a rising timestamp, a few call sites and
+ * changing numbers. */
+static size_t fill_log_text(uint8_t *buf, size_t len)
+{
+	static const char *const msgs[] = {
+		"sensor", "smp: rx", "battery", "wifi: rssi",
+	};
+	size_t n = 0;
+
+	for (unsigned i = 0; n < len; i++) {
+		char line[96];
+		int l = snprintf(line, sizeof(line), "%u: [I] <0x%x,0x0> ",
+				1000u + i * 7u, 0x8000u + (i % 4u) * 0x40u);
+		l += snprintf(line + l, sizeof(line) - (size_t)l,
+				"%s %u, %u", msgs[i % 4u], i % 13u,
+				(i * 37u) % 1000u);
+		line[l++] = '\n';
+		size_t k = ((size_t)l < len - n)? (size_t)l : len - n;
+		memcpy(&buf[n], line, k);
+		n += k;
+	}
+
+	return n;
+}
+
+static void fill_random(uint8_t *buf, size_t len)
+{
+	uint32_t x = 0x12345678;
+	for (size_t i = 0; i < len; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		buf[i] = (uint8_t)x;
+	}
+}
+
+TEST_GROUP(LogLz) {
+	void setup(void) {
+	}
+	void teardown(void) {
+	}
+
+	void check_round_trip(const uint8_t *data, size_t len) {
+		size_t clen = log_lz_compress(data, len, comp,
+				LOG_LZ_BOUND(len), table);
+		CHECK(clen > 0);
+		CHECK(clen <= LOG_LZ_BOUND(len));
+		LONGS_EQUAL(len, log_lz_decompress(comp, clen, out, len));
+		MEMCMP_EQUAL(data, out, len);
+	}
+};
+
+TEST(LogLz, ShouldRoundTrip_WhenInputIsShort) {
+	for (size_t len = 1; len <= 32; len++) {
+		memset(src, 'a', len);
+		check_round_trip(src, len);
+		fill_random(src, len);
+		check_round_trip(src, len);
+	}
+}
+
+TEST(LogLz, ShouldRoundTrip_WhenInputIsEmpty) {
+	size_t clen = log_lz_compress(src, 0, comp, sizeof(comp), table);
+	LONGS_EQUAL(1, clen);
+	LONGS_EQUAL(0, log_lz_decompress(comp, clen, out, sizeof(out)));
+}
+
+TEST(LogLz, ShouldRoundTrip_WhenInputIsLogText) {
+	const size_t len = fill_log_text(src, BLOCK_SIZE);
+	check_round_trip(src, len);
+}
+
+TEST(LogLz, ShouldRoundTrip_WhenInputIsIncompressible) {
+	fill_random(src, BLOCK_SIZE);
+	check_round_trip(src, BLOCK_SIZE);
+}
+
+TEST(LogLz, ShouldRoundTrip_WhenInputIsLongRuns) {
+	memset(src, 0, MAX_BLOCK);
+	check_round_trip(src, MAX_BLOCK);
+	for (size_t i = 0; i < MAX_BLOCK; i++) {
+		src[i] = (uint8_t)(i % 300U < 280U ? 'x' : i);
+	}
+	check_round_trip(src, MAX_BLOCK);
+}
+
+TEST(LogLz, compress_ShouldFail_WhenInputIsOver64KiB) {
+	LONGS_EQUAL(0, log_lz_compress(src, MAX_BLOCK + 1, comp,
+			sizeof(comp), table));
+}
+
+TEST(LogLz, compress_ShouldFail_WhenOutputDoesNotFit) {
+	fill_random(src, BLOCK_SIZE);
+	LONGS_EQUAL(0, log_lz_compress(src, BLOCK_SIZE, comp, BLOCK_SIZE,
+			table));
+}
+
+TEST(LogLz, decompress_ShouldReadReferenceLz4Block) {
+	const size_t len = sizeof(vector_text) - 1;
+	LONGS_EQUAL(len, log_lz_decompress(vector_lz4, sizeof(vector_lz4),
+			out, sizeof(out)));
+	MEMCMP_EQUAL(vector_text, out, len);
+}
+
+TEST(LogLz, decompress_ShouldFail_WhenBlockIsTruncated) {
+	for (size_t n = 1; n < sizeof(vector_lz4); n++) {
+		int rc = log_lz_decompress(vector_lz4, n, out, sizeof(out));
+		CHECK(rc < 0 || (size_t)rc < sizeof(vector_text) - 1);
+	}
+}
+
+TEST(LogLz, decompress_ShouldFail_WhenOutputDoesNotFit) {
+	CHECK(log_lz_decompress(vector_lz4, sizeof(vector_lz4), out,
+			sizeof(vector_text) - 2) < 0);
+}
+
+TEST(LogLz, decompress_ShouldFail_WhenOffsetPointsBeforeStart) {
+	const uint8_t bad[] = { 0x10, 'a', 0x05, 0x00, 0x00 };
+	CHECK(log_lz_decompress(bad, sizeof(bad), out, sizeof(out)) < 0);
+}
+
+TEST(LogLz, Benchmark_LogTextBlocks) {
+	const size_t len = fill_log_text(src, BLOCK_SIZE);
+	const unsigned rounds = 200;
+	size_t clen = 0;
+
+	uint64_t t0 = now_ns();
+	for (unsigned i = 0; i < rounds; i++) {
+		clen = log_lz_compress(src, len, comp, sizeof(comp), table);
+	}
+	uint64_t t1 = now_ns();
+	for (unsigned i = 0; i < rounds; i++) {
+		log_lz_decompress(comp, clen, out, sizeof(out));
+	}
+	uint64_t t2 = now_ns();
+
+	const double mb = (double)(len * rounds) / (1024.0 * 1024.0);
+	printf("\n\tlz: %zu -> %zu bytes (%.1f%%), "
+			"compress %.1f MiB/s, decompress %.1f MiB/s\n",
+			len, clen, (double)clen * 100.0 / (double)len,
+			mb / ((double)(t1 - t0) / 1e9),
+			mb / ((double)(t2 - t1) / 1e9));
+	CHECK(clen < len / 2);
+}
@@ -0,0 +1,158 @@
+#include "CppUTest/TestHarness.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "logging.h"
+#include "log_retained.h"
+
+#define MAX_REPLAYS		128U
+
+extern "C" char __start_retained_noinit[];
+extern "C" char __stop_retained_noinit[];
+
+/* struct retained in log_retained.c */
+#define MAGIC_OFFSET		0U
+#define HEAD_OFFSET		4U
+#define CRC_OFFSET		12U
+
+static char replays[MAX_REPLAYS][LOGGING_MESSAGE_MAXLEN + 16];
+static size_t replay_lens[MAX_REPLAYS];
+static size_t nr_replays;
+
+size_t log_dict_save(logging_t type, const char *fmt, ...)
+{
+	va_list ap;
+	(void)type;
+
+	if (nr_replays >= MAX_REPLAYS) {
+		return 0;
+	}
+
+	va_start(ap, fmt);
+	int len = vsnprintf(replays[nr_replays], sizeof(replays[0]), fmt, ap);
+	va_end(ap);
+
+	replay_lens[nr_replays++] = (size_t)len;
+	return (size_t)len;
+}
+
+size_t logging_write_encoded(const void *data, size_t size)
+{
+	if (nr_replays >= MAX_REPLAYS) {
+		return 0;
+	}
+
+	memcpy(replays[nr_replays], data, size);
+	replay_lens[nr_replays++] = size;
+	return size;
+}
+
+TEST_GROUP(LogRetained) {
+	void setup(void) {
+		/* power-on: whatever was in RAM, here all zeros */
+		memset(__start_retained_noinit, 0, (size_t)
+				(__stop_retained_noinit - __start_retained_noinit));
+		LONGS_EQUAL(0, log_retained_init());
+		nr_replays = 0;
+	}
+	void teardown(void) {
+	}
+
+	void write(const char *text) {
+		log_retained_write(text, strlen(text));
+	}
+	void corrupt(size_t offset) {
+		__start_retained_noinit[offset] ^= 0x5a;
+	}
+};
+
+TEST(LogRetained, init_ShouldReplayLinesInOrder_AfterReset) {
+	write("1: [I] first");
+	write("2: [E] second");
+	write("3: [W] third");
+
+	LONGS_EQUAL(3, log_retained_init());
+
+	STRCMP_EQUAL(LOG_RETAINED_TAG " 1: [I] first", replays[0]);
+	STRCMP_EQUAL(LOG_RETAINED_TAG " 2: [E] second", replays[1]);
+	STRCMP_EQUAL(LOG_RETAINED_TAG " 3: [W] third", replays[2]);
+}
+
+TEST(LogRetained, init_ShouldStartOver_AfterReplay) {
+	write("1: [I] first");
+	LONGS_EQUAL(1, log_retained_init());
+	LONGS_EQUAL(0, log_retained_init());
+
+	write("2: [I] second");
+	LONGS_EQUAL(1, log_retained_init());
+	STRCMP_EQUAL(LOG_RETAINED_TAG " 2: [I] second", replays[1]);
+}
+
+TEST(LogRetained, init_ShouldReplayNothing_WhenMagicIsBroken) {
+	write("1: [I] first");
+	corrupt(MAGIC_OFFSET);
+	LONGS_EQUAL(0, log_retained_init());
+	LONGS_EQUAL(0, nr_replays);
+}
+
+TEST(LogRetained, init_ShouldReplayNothing_WhenHeaderFailsCrc) {
+	write("1: [I] first");
+	corrupt(HEAD_OFFSET);
+	LONGS_EQUAL(0, log_retained_init());
+
+	write("1: [I] first");
+	corrupt(CRC_OFFSET);
+	LONGS_EQUAL(0, log_retained_init());
+	LONGS_EQUAL(0, nr_replays);
+}
+
+TEST(LogRetained, init_ShouldKeepNewestWholeLines_WhenRingWrapped) {
+	char text[32];
+	const unsigned total = LOG_RETAINED_SIZE / 4U;
+
+	for (unsigned i = 0; i < total; i++) {
+		snprintf(text, sizeof(text), "%u: [I] line %04u", i, i);
+		write(text);
+	}
+
+	const size_t n = log_retained_init();
+	CHECK(n > 0 && n < total);
+	LONGS_EQUAL(n, nr_replays);
+
+	/* consecutive, whole, and ending with the newest */
+	for (size_t k = 0; k < n; k++) {
+		const unsigned i = (unsigned)(total - n + k);
+		snprintf(text, sizeof(text), LOG_RETAINED_TAG
+				" %u: [I] line %04u", i, i);
+		STRCMP_EQUAL(text, replays[k]);
+	}
+}
+
+TEST(LogRetained, init_ShouldMakeTextPrintable) {
+	write("1: [I] a\tb\x01");
+	LONGS_EQUAL(1, log_retained_init());
+	STRCMP_EQUAL(LOG_RETAINED_TAG " 1: [I] a?b?", replays[0]);
+}
+
+TEST(LogRetained, init_ShouldReplayDictionaryFramesAsTheyAre) {
+	const char frame[] = { (char)LOG_DICT_SYNC, LOGGING_TYPE_ERROR,
+		4, 0, 1, 2, 3, 4, 5, 6, 7, (char)0x80, 0, 0, 0, 0 };
+
+	log_retained_write(frame, sizeof(frame));
+	LONGS_EQUAL(1, log_retained_init());
+
+	LONGS_EQUAL(sizeof(frame), replay_lens[0]);
+	LONGS_EQUAL(LOGGING_TYPE_ERROR | LOG_DICT_REPLAYED,
+			(uint8_t)replays[0][1]);
+	MEMCMP_EQUAL(&frame[2], &replays[0][2], sizeof(frame) - 2);
+}
+
+TEST(LogRetained, write_ShouldIgnoreLinesAsLongAsTheRing) {
+	static char big[LOG_RETAINED_SIZE + 1];
+	memset(big, 'x', sizeof(big) - 1);
+
+	write("1: [I] kept");
+	log_retained_write(big, LOG_RETAINED_SIZE);
+	LONGS_EQUAL(1, log_retained_init());
+}
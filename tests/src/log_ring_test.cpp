@@ -0,0 +1,222 @@
+#include "CppUTest/TestHarness.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#include "log_ring.h"
+
+#define SLOT_SIZE		24U
+#define SLOT_COUNT		16U
+#define PRODUCERS		4U
+#define RECORDS_PER_PRODUCER	20000U
+
+struct record {
+	uint32_t producer;
+	uint32_t seq;
+};
+
+struct mpsc {
+	struct log_ring *ring;
+	uint32_t producer;
+	uint32_t full;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void *produce(void *arg)
+{
+	struct mpsc *p = (struct mpsc *)arg;
+
+	for (uint32_t i = 0; i < RECORDS_PER_PRODUCER; i++) {
+		const struct record rec = { p->producer, i };
+
+		while (!log_ring_put(p->ring, &rec, sizeof(rec))) {
+			p->full++;
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+TEST_GROUP(LogRing) {
+	struct log_ring ring;
+	uint32_t mem[LOG_RING_MEMSIZE(SLOT_COUNT, SLOT_SIZE) / sizeof(uint32_t)];
+
+	void setup(void) {
+		LONGS_EQUAL(0, log_ring_init(&ring, mem, sizeof(mem),
+				SLOT_SIZE));
+	}
+	void teardown(void) {
+	}
+
+	void put_u32(uint32_t v) {
+		CHECK_TRUE(log_ring_put(&ring, &v, sizeof(v)));
+	}
+	uint32_t get_u32(void) {
+		size_t len = 0;
+		const void *p = log_ring_peek(&ring, &len);
+		uint32_t v;
+
+		CHECK(p != NULL);
+		LONGS_EQUAL(sizeof(v), len);
+		memcpy(&v, p, sizeof(v));
+		log_ring_consume(&ring);
+		return v;
+	}
+};
+
+TEST(LogRing, init_ShouldRoundSlotCountDownToPowerOfTwo) {
+	uint32_t buf[LOG_RING_MEMSIZE(6, SLOT_SIZE) / sizeof(uint32_t)];
+	struct log_ring r;
+	LONGS_EQUAL(0, log_ring_init(&r, buf, sizeof(buf), SLOT_SIZE));
+	LONGS_EQUAL(4, log_ring_capacity(&r));
+	LONGS_EQUAL(SLOT_COUNT, log_ring_capacity(&ring));
+}
+
+TEST(LogRing, init_ShouldFail_WhenMemoryIsTooSmallOrMisaligned) {
+	struct log_ring r;
+	LONGS_EQUAL(-1, log_ring_init(&r, mem, 4, SLOT_SIZE));
+	LONGS_EQUAL(-1, log_ring_init(&r, (uint8_t *)mem + 1,
+			sizeof(mem) - 4, SLOT_SIZE));
+	LONGS_EQUAL(-1, log_ring_init(&r, NULL, sizeof(mem), SLOT_SIZE));
+}
+
+TEST(LogRing, peek_ShouldReturnNull_WhenEmpty) {
+	size_t len = 1;
+	POINTERS_EQUAL(NULL, log_ring_peek(&ring, &len));
+	LONGS_EQUAL(0, log_ring_count(&ring));
+}
+
+TEST(LogRing, put_ShouldKeepOrder) {
+	for (uint32_t i = 0; i < SLOT_COUNT; i++) {
+		put_u32(i);
+	}
+	LONGS_EQUAL(SLOT_COUNT, log_ring_count(&ring));
+	for (uint32_t i = 0; i < SLOT_COUNT; i++) {
+		LONGS_EQUAL(i, get_u32());
+	}
+	LONGS_EQUAL(0, log_ring_count(&ring));
+}
+
+TEST(LogRing, put_ShouldFail_WhenFull) {
+	for (uint32_t i = 0; i < SLOT_COUNT; i++) {
+		put_u32(i);
+	}
+	const uint32_t v = 0xdead;
+	CHECK_FALSE(log_ring_put(&ring, &v, sizeof(v)));
+	LONGS_EQUAL(SLOT_COUNT, log_ring_count(&ring));
+
+	LONGS_EQUAL(0, get_u32());
+	put_u32(v);
+	for (uint32_t i = 1; i < SLOT_COUNT; i++) {
+		LONGS_EQUAL(i, get_u32());
+	}
+	LONGS_EQUAL(v, get_u32());
+}
+
+TEST(LogRing, put_ShouldFail_WhenRecordDoesNotFitSlot) {
+	uint8_t big[SLOT_SIZE + 1] = { 0, };
+	CHECK_FALSE(log_ring_put(&ring, big, sizeof(big)));
+	CHECK_TRUE(log_ring_put(&ring, big, SLOT_SIZE));
+}
+
+TEST(LogRing, peek_ShouldKeepRecordUntilConsumed) {
+	put_u32(7);
+	size_t len;
+	const void *a = log_ring_peek(&ring, &len);
+	const void *b = log_ring_peek(&ring, &len);
+	POINTERS_EQUAL(a, b);
+	LONGS_EQUAL(7, get_u32());
+}
+
+TEST(LogRing, put_ShouldWrapAroundManyLaps) {
+	for (uint32_t i = 0; i < SLOT_COUNT * 1000U; i++) {
+		put_u32(i);
+		if ((i % 3U) == 2U) {
+			LONGS_EQUAL(i - 2U, get_u32());
+			LONGS_EQUAL(i - 1U, get_u32());
+			LONGS_EQUAL(i, get_u32());
+		}
+	}
+}
+
+TEST(LogRing, put_ShouldKeepPerProducerOrder_WhenProducersRace) {
+	pthread_t threads[PRODUCERS];
+	struct mpsc args[PRODUCERS];
+	uint32_t next[PRODUCERS] = { 0, };
+	uint32_t received = 0;
+	uint32_t full = 0;
+
+	for (uint32_t i = 0; i < PRODUCERS; i++) {
+		args[i] = (struct mpsc) { &ring, i, 0 };
+		pthread_create(&threads[i], NULL, produce, &args[i]);
+	}
+
+	while (received < PRODUCERS * RECORDS_PER_PRODUCER) {
+		size_t len;
+		const struct record *rec = (const struct record *)
+			log_ring_peek(&ring, &len);
+
+		if (rec == NULL) {
+			sched_yield();
+			continue;
+		}
+
+		LONGS_EQUAL(sizeof(*rec), len);
+		CHECK(rec->producer < PRODUCERS);
+		LONGS_EQUAL(next[rec->producer], rec->seq);
+		next[rec->producer]++;
+		received++;
+		log_ring_consume(&ring);
+	}
+
+	for (uint32_t i = 0; i < PRODUCERS; i++) {
+		pthread_join(threads[i], NULL);
+		LONGS_EQUAL(RECORDS_PER_PRODUCER, next[i]);
+		full += args[i].full;
+	}
+	LONGS_EQUAL(0, log_ring_count(&ring));
+	printf("\n\tmpsc: %u records, %u puts found the ring full\n",
+			received, full);
+}
+
+/* What a caller pays per record, with the drain falling behind: a put is
+ * a copy when there is room and a failed reservation when there is not,
+ * never a wait. */
+TEST(LogRing, put_ShouldNotBlockCaller_WhenDrainIsSlow) {
+	const uint32_t n = 100000U;
+	uint64_t worst = 0;
+	uint32_t dropped = 0;
+	const uint64_t t0 = now_ns();
+
+	for (uint32_t i = 0; i < n; i++) {
+		const uint64_t t = now_ns();
+		const struct record rec = { 0, i };
+
+		if (!log_ring_put(&ring, &rec, sizeof(rec))) {
+			dropped++;
+		}
+
+		const uint64_t dt = now_ns() - t;
+		worst = (dt > worst)? dt : worst;
+
+		if ((i % 64U) == 0) { /* drain a few now and then */
+			for (int k = 0; k < 8 && log_ring_peek(&ring, NULL);
+					k++) {
+				log_ring_consume(&ring);
+			}
+		}
+	}
+
+	const double avg = (double)(now_ns() - t0) / n;
+	printf("\n\tput: %.0f ns/record avg, %llu ns worst, %u dropped\n",
+			avg, (unsigned long long)worst, dropped);
+	CHECK(dropped > 0);
+	CHECK(avg < 5000.0);
+}
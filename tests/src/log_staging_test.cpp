@@ -0,0 +1,121 @@
+#include "CppUTest/TestHarness.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "log_staging.h"
+
+#define THREADS			(LOG_STAGING_COUNT * 2U)
+#define ROUNDS			20000U
+
+struct worker {
+	pthread_t thread;
+	uint8_t tag;
+	uint32_t taken;
+	uint32_t missed;
+	uint32_t corrupted;
+};
+
+/* Fills the whole buffer with the worker's tag and checks it is still
+ * intact after yielding: a buffer handed out twice gets overwritten. */
+static void *stress(void *arg)
+{
+	struct worker *w = (struct worker *)arg;
+
+	for (uint32_t i = 0; i < ROUNDS; i++) {
+		size_t bufsize;
+		char *buf = log_staging_acquire(&bufsize);
+
+		if (buf == NULL) {
+			w->missed++;
+			sched_yield();
+			continue;
+		}
+
+		w->taken++;
+		memset(buf, w->tag, bufsize);
+		sched_yield();
+		for (size_t k = 0; k < bufsize; k++) {
+			if ((uint8_t)buf[k] != w->tag) {
+				w->corrupted++;
+				break;
+			}
+		}
+		log_staging_release(buf);
+	}
+
+	return NULL;
+}
+
+TEST_GROUP(LogStaging) {
+	void setup(void) {
+	}
+	void teardown(void) {
+	}
+
+	size_t drain(char *bufs[], size_t n) {
+		size_t count = 0;
+		size_t bufsize;
+		while (count < n &&
+				(bufs[count] = log_staging_acquire(&bufsize))) {
+			count++;
+		}
+		return count;
+	}
+	void refill(char *bufs[], size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			log_staging_release(bufs[i]);
+		}
+	}
+};
+
+TEST(LogStaging, acquire_ShouldHandOutDistinctBuffers) {
+	char *bufs[LOG_STAGING_COUNT + 1];
+
+	LONGS_EQUAL(LOG_STAGING_COUNT, drain(bufs, LOG_STAGING_COUNT + 1));
+	for (size_t i = 0; i < LOG_STAGING_COUNT; i++) {
+		for (size_t k = i + 1; k < LOG_STAGING_COUNT; k++) {
+			CHECK(bufs[i] != bufs[k]);
+		}
+	}
+	refill(bufs, LOG_STAGING_COUNT);
+}
+
+TEST(LogStaging, acquire_ShouldReturnNull_WhenAllBuffersAreHeld) {
+	char *bufs[LOG_STAGING_COUNT];
+	size_t bufsize;
+
+	drain(bufs, LOG_STAGING_COUNT);
+	POINTERS_EQUAL(NULL, log_staging_acquire(&bufsize));
+
+	log_staging_release(bufs[1]);
+	POINTERS_EQUAL(bufs[1], log_staging_acquire(&bufsize));
+	refill(bufs, LOG_STAGING_COUNT);
+}
+
+TEST(LogStaging, acquire_ShouldNeverShareBuffer_WhenLoggersRace) {
+	struct worker workers[THREADS];
+	uint32_t taken = 0;
+	uint32_t missed = 0;
+
+	for (uint32_t i = 0; i < THREADS; i++) {
+		workers[i] = (struct worker) { .tag = (uint8_t)(i + 1), };
+		pthread_create(&workers[i].thread, NULL, stress, &workers[i]);
+	}
+	for (uint32_t i = 0; i < THREADS; i++) {
+		pthread_join(workers[i].thread, NULL);
+		LONGS_EQUAL(0, workers[i].corrupted);
+		taken += workers[i].taken;
+		missed += workers[i].missed;
+	}
+
+	LONGS_EQUAL(THREADS * ROUNDS, taken + missed);
+	printf("\n\tstaging: %u taken, %u found the pool empty\n",
+			taken, missed);
+
+	/* every buffer came back */
+	char *bufs[LOG_STAGING_COUNT + 1];
+	LONGS_EQUAL(LOG_STAGING_COUNT, drain(bufs, LOG_STAGING_COUNT + 1));
+	refill(bufs, LOG_STAGING_COUNT);
+}
@@ -0,0 +1,292 @@
+#include "CppUTest/TestHarness.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lfs.h"
+#include "bd/lfs_filebd.h"
+
+#include "log_lz.h"
+#include "log_store.h"
+
+#define FLASH_BLOCK_SIZE	4096U
+#define FLASH_BLOCK_COUNT	(0x378000U / FLASH_BLOCK_SIZE) /* "fs" partition */
+#define FLASH_IO_SIZE		128U /* esp_littlefs read and write size */
+#define FLASH_CACHE_SIZE	512U
+#define FLASH_BLOCK_CYCLES	512
+
+#define BLOCK_MAGIC		0x4B4C424CU /* "LBLK" */
+#define RECORDS			20000U
+
+/* What ports/esp-idf/log_store.c puts ahead of each compressed block. */
+struct block_hdr {
+	uint32_t magic;
+	uint32_t t_first;
+	uint32_t t_last;
+	uint16_t raw_len;
+	uint16_t comp_len;
+	uint32_t crc;
+};
+
+/* littlefs on a file standing in for the flash partition. Programs and
+ * erases are counted on their way to the block device. */
+static struct {
+	lfs_filebd_t bd;
+	struct lfs_filebd_config bdcfg;
+	struct lfs_config cfg;
+	lfs_t lfs;
+	char path[32];
+	uint64_t nr_prog_bytes;
+	uint32_t nr_erases;
+} flash;
+
+/* The write side of the store, done the way log_store.c does it: lines
+ * batched into a block, the block compressed and appended to the newest
+ * file, and the oldest file removed once there are too many. */
+static struct {
+	char data[LOG_STORE_BLOCK_SIZE];
+	size_t len;
+	uint32_t first_file;
+	uint32_t last_file;
+	uint32_t last_file_size;
+	uint32_t nr_blocks;
+	size_t nr_stored_bytes;
+	uint16_t table[LOG_LZ_TABLE_LEN];
+	uint8_t comp[LOG_LZ_BOUND(LOG_STORE_BLOCK_SIZE)];
+	char raw[LOG_STORE_BLOCK_SIZE];
+} store;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int count_prog(const struct lfs_config *c, lfs_block_t block,
+		lfs_off_t off, const void *buffer, lfs_size_t size)
+{
+	flash.nr_prog_bytes += size;
+	return lfs_filebd_prog(c, block, off, buffer, size);
+}
+
+static int count_erase(const struct lfs_config *c, lfs_block_t block)
+{
+	flash.nr_erases++;
+	return lfs_filebd_erase(c, block);
+}
+
+static uint32_t crc32_le(const uint8_t *p, size_t len)
+{
+	uint32_t crc = 0xFFFFFFFFU;
+
+	for (size_t i = 0; i < len; i++) {
+		crc ^= p[i];
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+		}
+	}
+
+	return ~crc;
+}
+
+static void get_path(char *buf, size_t bufsize, uint32_t file)
+{
+	snprintf(buf, bufsize, "log/%08lx.lz", (unsigned long)file);
+}
+
+static void rotate(void)
+{
+	char path[32];
+
+	store.last_file++;
+	store.last_file_size = 0;
+
+	while (store.last_file - store.first_file >= LOG_STORE_FILES) {
+		get_path(path, sizeof(path), store.first_file++);
+		LONGS_EQUAL(0, lfs_remove(&flash.lfs, path));
+	}
+}
+
+static void write_block(void)
+{
+	char path[32];
+	lfs_file_t f;
+	struct block_hdr hdr;
+
+	const size_t comp_len = log_lz_compress(store.data, store.len,
+			store.comp, sizeof(store.comp), store.table);
+	CHECK(comp_len > 0);
+
+	hdr.magic = BLOCK_MAGIC;
+	hdr.t_first = store.nr_blocks;
+	hdr.t_last = store.nr_blocks;
+	hdr.raw_len = (uint16_t)store.len;
+	hdr.comp_len = (uint16_t)comp_len;
+	hdr.crc = crc32_le(store.comp, comp_len);
+
+	const size_t total = sizeof(hdr) + comp_len;
+	if (store.last_file_size > 0 &&
+			store.last_file_size + total > LOG_STORE_FILE_SIZE) {
+		rotate();
+	}
+
+	get_path(path, sizeof(path), store.last_file);
+	LONGS_EQUAL(0, lfs_file_open(&flash.lfs, &f, path,
+			LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND));
+	LONGS_EQUAL(sizeof(hdr), lfs_file_write(&flash.lfs, &f,
+			&hdr, sizeof(hdr)));
+	LONGS_EQUAL(comp_len, lfs_file_write(&flash.lfs, &f,
+			store.comp, (lfs_size_t)comp_len));
+	LONGS_EQUAL(0, lfs_file_close(&flash.lfs, &f)); /* commits */
+
+	store.last_file_size += (uint32_t)total;
+	store.nr_stored_bytes += total;
+	store.nr_blocks++;
+	store.len = 0;
+}
+
+static void append(const char *text, size_t len)
+{
+	if (store.len + len + 1 > sizeof(store.data)) {
+		write_block();
+	}
+
+	memcpy(&store.data[store.len], text, len);
+	store.data[store.len + len] = '\n';
+	store.len += len + 1;
+}
+
+/* Lines as the store sees them: a rising timestamp, a few call sites and
+ * changing numbers. */
+static size_t make_line(char *buf, size_t bufsize, uint32_t i)
+{
+	static const char *const msgs[] = {
+		"sensor", "smp: rx", "battery", "wifi: rssi",
+	};
+
+	return (size_t)snprintf(buf, bufsize, "%u: [I] <0x%x,0x0> %s %u, %u",
+			1000u + i * 7u, 0x8000u + (i % 4u) * 0x40u,
+			msgs[i % 4u], i % 13u, (i * 37u) % 1000u);
+}
+
+/* The newest block read back through littlefs decompresses whole. */
+static void check_last_block(void)
+{
+	char path[32];
+	lfs_file_t f;
+	struct block_hdr hdr;
+	uint32_t off = 0;
+
+	get_path(path, sizeof(path), store.last_file);
+	LONGS_EQUAL(0, lfs_file_open(&flash.lfs, &f, path, LFS_O_RDONLY));
+	LONGS_EQUAL(store.last_file_size, lfs_file_size(&flash.lfs, &f));
+
+	for (;;) {
+		LONGS_EQUAL(sizeof(hdr), lfs_file_read(&flash.lfs, &f,
+				&hdr, sizeof(hdr)));
+		LONGS_EQUAL(BLOCK_MAGIC, hdr.magic);
+		off += (uint32_t)(sizeof(hdr) + hdr.comp_len);
+		if (off >= store.last_file_size) {
+			break;
+		}
+		LONGS_EQUAL(off, lfs_file_seek(&flash.lfs, &f,
+				(lfs_soff_t)off, LFS_SEEK_SET));
+	}
+
+	LONGS_EQUAL(hdr.comp_len, lfs_file_read(&flash.lfs, &f,
+			store.comp, hdr.comp_len));
+	LONGS_EQUAL(hdr.crc, crc32_le(store.comp, hdr.comp_len));
+	LONGS_EQUAL(hdr.raw_len, log_lz_decompress(store.comp, hdr.comp_len,
+			store.raw, sizeof(store.raw)));
+	LONGS_EQUAL(0, lfs_file_close(&flash.lfs, &f));
+}
+
+/* Writes RECORDS lines, and every flush_every lines whatever the block
+ * holds, as the flush timer does when lines are few and far between. */
+static void run(uint32_t flush_every, const char *name)
+{
+	char line[96];
+	size_t nr_raw_bytes = 0;
+
+	const uint64_t t0 = now_ns();
+	for (uint32_t i = 0; i < RECORDS; i++) {
+		const size_t len = make_line(line, sizeof(line), i);
+		append(line, len);
+		nr_raw_bytes += len + 1;
+
+		if (flush_every != 0 && (i + 1U) % flush_every == 0) {
+			write_block();
+		}
+	}
+	if (store.len > 0) {
+		write_block();
+	}
+	const double sec = (double)(now_ns() - t0) / 1e9;
+
+	check_last_block();
+
+	printf("\n\t%s: %8.0f records/s, %u blocks, %u erases\n"
+			"\t\tper record: %5.1f bytes of text, %5.1f stored, "
+			"%5.1f programmed to flash\n", name, RECORDS / sec,
+			store.nr_blocks, flash.nr_erases,
+			(double)nr_raw_bytes / RECORDS,
+			(double)store.nr_stored_bytes / RECORDS,
+			(double)flash.nr_prog_bytes / RECORDS);
+}
+
+TEST_GROUP(LogStore) {
+	void setup(void) {
+		memset(&flash, 0, sizeof(flash));
+		memset(&store, 0, sizeof(store));
+
+		strcpy(flash.path, "/tmp/log_store.XXXXXX");
+		const int fd = mkstemp(flash.path);
+		CHECK(fd >= 0);
+		close(fd);
+
+		flash.bdcfg.read_size = FLASH_IO_SIZE;
+		flash.bdcfg.prog_size = FLASH_IO_SIZE;
+		flash.bdcfg.erase_size = FLASH_BLOCK_SIZE;
+		flash.bdcfg.erase_count = FLASH_BLOCK_COUNT;
+
+		flash.cfg.context = &flash.bd;
+		flash.cfg.read = lfs_filebd_read;
+		flash.cfg.prog = count_prog;
+		flash.cfg.erase = count_erase;
+		flash.cfg.sync = lfs_filebd_sync;
+		flash.cfg.read_size = FLASH_IO_SIZE;
+		flash.cfg.prog_size = FLASH_IO_SIZE;
+		flash.cfg.block_size = FLASH_BLOCK_SIZE;
+		flash.cfg.block_count = FLASH_BLOCK_COUNT;
+		flash.cfg.block_cycles = FLASH_BLOCK_CYCLES;
+		flash.cfg.cache_size = FLASH_CACHE_SIZE;
+		flash.cfg.lookahead_size = FLASH_IO_SIZE;
+
+		LONGS_EQUAL(0, lfs_filebd_create(&flash.cfg, flash.path,
+				&flash.bdcfg));
+		LONGS_EQUAL(0, lfs_format(&flash.lfs, &flash.cfg));
+		LONGS_EQUAL(0, lfs_mount(&flash.lfs, &flash.cfg));
+		LONGS_EQUAL(0, lfs_mkdir(&flash.lfs, "log"));
+
+		/* formatting is not what is measured */
+		flash.nr_prog_bytes = 0;
+		flash.nr_erases = 0;
+	}
+	void teardown(void) {
+		lfs_unmount(&flash.lfs);
+		lfs_filebd_destroy(&flash.cfg);
+		unlink(flash.path);
+	}
+};
+
+TEST(LogStore, write_Benchmark_FullBlocks) {
+	run(0, "full blocks");
+}
+
+TEST(LogStore, write_Benchmark_BlockFlushedEvery8Records) {
+	run(8, "flushed every 8 records");
+}
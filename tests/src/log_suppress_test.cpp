@@ -0,0 +1,157 @@
+#include "CppUTest/TestHarness.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "log_suppress.h"
+#include "libmcu/board.h"
+#include "libmcu/metrics.h"
+
+static uint32_t now;
+static uint32_t nr_suppressed;
+static uint32_t nr_rate_limited;
+static uint32_t seq; /* never repeats, so lines differ across tests too */
+
+uint32_t board_get_time_since_boot_ms(void)
+{
+	return now;
+}
+
+void metrics_increase(metric_key_t key)
+{
+	if (key == LogSuppressedCount) {
+		__atomic_add_fetch(&nr_suppressed, 1, __ATOMIC_RELAXED);
+	} else if (key == LogRateLimitedCount) {
+		__atomic_add_fetch(&nr_rate_limited, 1, __ATOMIC_RELAXED);
+	}
+}
+
+TEST_GROUP(LogSuppress) {
+	char line[64];
+
+	void setup(void) {
+		nr_suppressed = 0;
+		nr_rate_limited = 0;
+		/* the suppressor keeps its state; start with a full bucket */
+		now += 1000000U;
+	}
+	void teardown(void) {
+	}
+
+	/* Distinct lines from one call site. */
+	bool log_next(uint32_t *repeats = NULL) {
+		uint32_t dummy;
+		int len = snprintf(line, sizeof(line),
+				"%u: [I] <0x1000,0x0> seq %u", now, seq++);
+		return log_suppress_check(line, (size_t)len,
+				repeats? repeats : &dummy);
+	}
+	bool log_same(uint32_t *repeats) {
+		int len = snprintf(line, sizeof(line),
+				"%u: [I] <0x1000,0x0> same", now);
+		return log_suppress_check(line, (size_t)len, repeats);
+	}
+	uint32_t drain_bucket(void) {
+		uint32_t passed = 0;
+		while (log_next()) {
+			passed++;
+		}
+		return passed;
+	}
+};
+
+TEST(LogSuppress, check_ShouldPassBurst_ThenRateLimit) {
+	LONGS_EQUAL(LOG_SUPPRESS_BURST, drain_bucket());
+	LONGS_EQUAL(1, nr_rate_limited);
+}
+
+TEST(LogSuppress, check_ShouldRefillAtRate) {
+	drain_bucket();
+	now += 1000U / LOG_SUPPRESS_RATE;
+	CHECK_TRUE(log_next());
+	CHECK_FALSE(log_next());
+}
+
+TEST(LogSuppress, check_ShouldCollapseRepeats) {
+	uint32_t repeats;
+
+	CHECK_TRUE(log_same(&repeats));
+	for (int i = 0; i < 5; i++) {
+		CHECK_FALSE(log_same(&repeats));
+		LONGS_EQUAL(0, repeats);
+	}
+	LONGS_EQUAL(5, nr_suppressed);
+
+	CHECK_TRUE(log_next(&repeats));
+	LONGS_EQUAL(5, repeats);
+}
+
+TEST(LogSuppress, check_ShouldRefillFully_AfterDaysIdle) {
+	drain_bucket();
+
+	/* elapsed * LOG_SUPPRESS_RATE wraps around to a few tokens */
+	now += (uint32_t)(0x100000000ull / LOG_SUPPRESS_RATE) + 300U;
+
+	LONGS_EQUAL(LOG_SUPPRESS_BURST, drain_bucket());
+}
+
+TEST(LogSuppress, check_ShouldPassReplayedLines_BeyondBurst) {
+	uint32_t repeats;
+
+	for (uint32_t i = 0; i < LOG_SUPPRESS_BURST * 2U; i++) {
+		int len = snprintf(line, sizeof(line),
+				"%u: [I] <0x2000,0x0> <retained> 1: [E] same",
+				now);
+		CHECK_TRUE(log_suppress_check(line, (size_t)len, &repeats));
+	}
+	for (uint32_t i = 0; i < LOG_SUPPRESS_BURST * 2U; i++) {
+		int len = snprintf(line, sizeof(line),
+				"%u: [I] <retained> 1: [E] same", now);
+		CHECK_TRUE(log_suppress_check(line, (size_t)len, &repeats));
+	}
+	LONGS_EQUAL(0, nr_suppressed);
+	LONGS_EQUAL(0, nr_rate_limited);
+}
+
+#define STORM_LOGGERS		4U
+#define STORM_LINES		20000U
+
+static pthread_barrier_t storm_start;
+
+static void *log_storm(void *arg)
+{
+	static const char text[] = "0: [E] <0x2000,0x0> fault storm";
+	uint32_t *passed = (uint32_t *)arg;
+	uint32_t repeats;
+
+	pthread_barrier_wait(&storm_start);
+	for (uint32_t i = 0; i < STORM_LINES; i++) {
+		if (log_suppress_check(text, sizeof(text) - 1, &repeats)) {
+			(*passed)++;
+		}
+	}
+
+	return NULL;
+}
+
+/* Loggers on other tasks or cores hitting the same fault all go through
+ * the suppressor; none slips past it. */
+TEST(LogSuppress, check_ShouldCollapseRepeats_FromConcurrentLoggers) {
+	pthread_t threads[STORM_LOGGERS];
+	uint32_t passed[STORM_LOGGERS] = { 0, };
+	uint32_t total = 0;
+
+	pthread_barrier_init(&storm_start, NULL, STORM_LOGGERS);
+	for (uint32_t i = 0; i < STORM_LOGGERS; i++) {
+		pthread_create(&threads[i], NULL, log_storm, &passed[i]);
+	}
+	for (uint32_t i = 0; i < STORM_LOGGERS; i++) {
+		pthread_join(threads[i], NULL);
+		total += passed[i];
+	}
+	pthread_barrier_destroy(&storm_start);
+
+	LONGS_EQUAL(1, total);
+	LONGS_EQUAL(STORM_LOGGERS * STORM_LINES - 1U, nr_suppressed);
+}
@@ -0,0 +1,340 @@
+#include "CppUTest/TestHarness.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "logging.h"
+#include "console_sync.h"
+#include "log_fanout.h"
+#include "log_retained.h"
+#include "log_staging.h"
+#include "log_suppress.h"
+#include "libmcu/metrics.h"
+
+#define LOGGERS			(LOG_STAGING_COUNT + 4U)
+#define LINE_MAXLEN		32U
+#define LINES_KEPT		64U
+#define ASYNC_RECORDS		1024U
+
+static const struct logging_backend *backend;
+static uint32_t nr_drops;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static bool gate_closed;
+static uint32_t nr_blocked;
+static char lines[LINES_KEPT][LINE_MAXLEN];
+static uint32_t nr_lines;
+static uint32_t nr_flushes;
+static console_sync_flush_t policy;
+
+int logging_add_backend(const struct logging_backend *p)
+{
+	backend = p;
+	return 0;
+}
+
+size_t logging_stringify(char *buf, size_t bufsize, const void *log)
+{
+	const size_t len = strnlen((const char *)log, bufsize);
+	memcpy(buf, log, len);
+	return len;
+}
+
+int console_sync_writev(const struct console_sync_iov *iov, size_t iovcnt)
+{
+	size_t total = 0;
+
+	pthread_mutex_lock(&lock);
+	nr_blocked++;
+	pthread_cond_broadcast(&cond);
+	while (gate_closed) {
+		pthread_cond_wait(&cond, &lock);
+	}
+
+	if (nr_lines < LINES_KEPT) {
+		memcpy(lines[nr_lines], iov[0].base, iov[0].len);
+		lines[nr_lines][iov[0].len] = '\0';
+	}
+	nr_lines++;
+	pthread_cond_broadcast(&cond);
+	for (size_t i = 0; i < iovcnt; i++) {
+		total += iov[i].len;
+	}
+	pthread_mutex_unlock(&lock);
+
+	return (int)total;
+}
+
+int console_sync_write(const void *data, size_t datasize)
+{
+	(void)data;
+	return (int)datasize;
+}
+
+int console_sync_flush(void)
+{
+	nr_flushes++;
+	return 0;
+}
+
+console_sync_flush_t console_sync_get_flush_policy(void)
+{
+	return policy;
+}
+
+size_t log_fanout_write(const char *text, size_t len)
+{
+	(void)text;
+	return len;
+}
+
+int log_fanout_add(const struct log_sink *sink)
+{
+	(void)sink;
+	return 0;
+}
+
+bool log_suppress_check(const char *text, size_t len, uint32_t *repeats)
+{
+	(void)text;
+	(void)len;
+	*repeats = 0;
+	return true;
+}
+
+size_t log_suppress_stringify(char *buf, size_t bufsize, uint32_t repeats)
+{
+	(void)buf;
+	(void)bufsize;
+	(void)repeats;
+	return 0;
+}
+
+void log_retained_write(const char *text, size_t len)
+{
+	(void)text;
+	(void)len;
+}
+
+void metrics_increase(metric_key_t key)
+{
+	if (key == LogDropCount) {
+		nr_drops++;
+	}
+}
+
+static void *log_one(void *arg)
+{
+	const char *text = (const char *)arg;
+	backend->write(text, strlen(text) + 1);
+	return NULL;
+}
+
+static bool wait_for(const uint32_t *counter, uint32_t n, int timeout_ms)
+{
+	struct timespec deadline;
+	bool reached;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeout_ms / 1000;
+	deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&lock);
+	while (*counter < n &&
+			pthread_cond_timedwait(&cond, &lock, &deadline) == 0) {
+	}
+	reached = *counter >= n;
+	pthread_mutex_unlock(&lock);
+
+	return reached;
+}
+
+static bool wait_blocked(uint32_t n, int timeout_ms)
+{
+	return wait_for(&nr_blocked, n, timeout_ms);
+}
+
+static bool wait_lines(uint32_t n, int timeout_ms)
+{
+	return wait_for(&nr_lines, n, timeout_ms);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_ns(const void *a, const void *b)
+{
+	const uint64_t x = *(const uint64_t *)a;
+	const uint64_t y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void open_gate(void)
+{
+	pthread_mutex_lock(&lock);
+	gate_closed = false;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+}
+
+TEST_GROUP(Logger) {
+	void setup(void) {
+		nr_drops = 0;
+		memset(lines, 0, sizeof(lines));
+		nr_lines = 0;
+		nr_blocked = 0;
+		nr_flushes = 0;
+		policy = CONSOLE_SYNC_FLUSH_IMMEDIATE;
+		gate_closed = false;
+		logging_stdout_backend_init();
+	}
+	void teardown(void) {
+	}
+};
+
+TEST(Logger, write_ShouldEmitLine) {
+	CHECK(backend->write("1: [I] hello", 13) > 0);
+	LONGS_EQUAL(1, nr_lines);
+	STRCMP_EQUAL("1: [I] hello", lines[0]);
+	LONGS_EQUAL(0, nr_flushes);
+}
+
+TEST(Logger, write_ShouldNotFlushAgain_WhenPolicyIsImmediate) {
+	CHECK(backend->write("1: [E] failed", 14) > 0);
+	LONGS_EQUAL(1, nr_lines);
+	LONGS_EQUAL(0, nr_flushes);
+}
+
+TEST(Logger, write_ShouldFlushErrors_WhenPolicyBuffers) {
+	policy = CONSOLE_SYNC_FLUSH_WATERMARK;
+	CHECK(backend->write("1: [I] hello", 13) > 0);
+	LONGS_EQUAL(0, nr_flushes);
+	CHECK(backend->write("2: [E] failed", 14) > 0);
+	LONGS_EQUAL(1, nr_flushes);
+
+	policy = CONSOLE_SYNC_FLUSH_PERIODIC;
+	CHECK(backend->write("3: [E] failed", 14) > 0);
+	LONGS_EQUAL(2, nr_flushes);
+}
+
+TEST(Logger, write_ShouldNotDrop_WhenMoreLoggersBlockThanStagingBuffers) {
+	static char texts[LOGGERS][LINE_MAXLEN];
+	pthread_t threads[LOGGERS];
+
+	gate_closed = true;
+	for (uint32_t i = 0; i < LOGGERS; i++) {
+		snprintf(texts[i], sizeof(texts[i]), "%u: [I] logger %u", i, i);
+		pthread_create(&threads[i], NULL, log_one, texts[i]);
+	}
+
+	/* every logger reaches the console, none is turned away */
+	CHECK_TRUE(wait_blocked(LOGGERS, 2000));
+	open_gate();
+
+	for (uint32_t i = 0; i < LOGGERS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	LONGS_EQUAL(LOGGERS, nr_lines);
+	LONGS_EQUAL(0, nr_drops);
+
+	/* and the staging buffers all came back */
+	char *bufs[LOG_STAGING_COUNT];
+	size_t bufsize;
+	for (uint32_t i = 0; i < LOG_STAGING_COUNT; i++) {
+		bufs[i] = log_staging_acquire(&bufsize);
+		CHECK(bufs[i] != NULL);
+	}
+	for (uint32_t i = 0; i < LOG_STAGING_COUNT; i++) {
+		log_staging_release(bufs[i]);
+	}
+}
+
+TEST_GROUP(LoggerAsync) {
+	void setup(void) {
+		/* the drain task lives on for the rest of the run */
+		static bool started;
+
+		nr_drops = 0;
+		memset(lines, 0, sizeof(lines));
+		nr_lines = 0;
+		nr_blocked = 0;
+		nr_flushes = 0;
+		policy = CONSOLE_SYNC_FLUSH_IMMEDIATE;
+		gate_closed = false;
+
+		if (!started) {
+			LONGS_EQUAL(0, logging_async_backend_init());
+			started = true;
+		}
+	}
+	void teardown(void) {
+		open_gate();
+	}
+};
+
+TEST(LoggerAsync, write_ShouldReachConsole_FromDrainTask) {
+	static char texts[8][LINE_MAXLEN];
+
+	for (uint32_t i = 0; i < 8; i++) {
+		snprintf(texts[i], sizeof(texts[i]), "%u: [I] record %u", i, i);
+		LONGS_EQUAL(strlen(texts[i]) + 1,
+				backend->write(texts[i], strlen(texts[i]) + 1));
+	}
+
+	CHECK_TRUE(wait_lines(8, 2000));
+	for (uint32_t i = 0; i < 8; i++) {
+		STRCMP_EQUAL(texts[i], lines[i]);
+	}
+	LONGS_EQUAL(0, nr_drops);
+}
+
+TEST(LoggerAsync, write_ShouldNeitherStallNorLoseUncounted_WhenConsoleBlocks) {
+	static uint64_t latency[ASYNC_RECORDS];
+	static char text[LINE_MAXLEN];
+	uint32_t nr_accepted = 0;
+
+	/* the drain task takes the first record and sticks on the console */
+	gate_closed = true;
+	backend->write("0: [I] first", 13);
+	CHECK_TRUE(wait_blocked(1, 2000));
+
+	for (uint32_t i = 0; i < ASYNC_RECORDS; i++) {
+		snprintf(text, sizeof(text), "%u: [I] record", i + 1U);
+		const uint64_t t = now_ns();
+		const size_t n = backend->write(text, strlen(text) + 1);
+		latency[i] = now_ns() - t;
+		nr_accepted += (n > 0);
+	}
+
+	/* what did not fit is counted, nothing else is lost */
+	CHECK(nr_accepted > 0);
+	LONGS_EQUAL(ASYNC_RECORDS - nr_accepted, nr_drops);
+
+	open_gate();
+	CHECK_TRUE(wait_lines(1U + nr_accepted, 2000));
+	STRCMP_EQUAL("0: [I] first", lines[0]);
+	STRCMP_EQUAL("1: [I] record", lines[1]);
+	LONGS_EQUAL(1U + nr_accepted, nr_lines);
+
+	qsort(latency, ASYNC_RECORDS, sizeof(latency[0]), compare_ns);
+	printf("\n\tasync, console blocked: %u of %u records queued, "
+			"caller p50 %.2f us, p99 %.2f us, max %.2f us\n",
+			nr_accepted, ASYNC_RECORDS,
+			(double)latency[ASYNC_RECORDS / 2U] / 1e3,
+			(double)latency[ASYNC_RECORDS * 99U / 100U] / 1e3,
+			(double)latency[ASYNC_RECORDS - 1U] / 1e3);
+	/* a caller waiting on the console would take the whole run */
+	CHECK(latency[ASYNC_RECORDS - 1U] < 100000000ull);
+}
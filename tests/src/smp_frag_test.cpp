@@ -0,0 +1,168 @@
+#include "CppUTest/TestHarness.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "smp_frag.h"
+
+#define BUFSIZE			1032U
+
+static uint8_t packet[BUFSIZE + 64];
+static uint8_t rxbuf[BUFSIZE];
+
+/* An SMP packet whose header announces the payload that follows. */
+static size_t make_packet(uint8_t *p, size_t payload_len, uint8_t seq)
+{
+	memset(p, 0, SMP_FRAG_HDR_SIZE);
+	p[2] = (uint8_t)(payload_len >> 8);
+	p[3] = (uint8_t)payload_len;
+	p[6] = seq;
+	for (size_t i = 0; i < payload_len; i++) {
+		p[SMP_FRAG_HDR_SIZE + i] = (uint8_t)(i * 7U + seq);
+	}
+	return SMP_FRAG_HDR_SIZE + payload_len;
+}
+
+TEST_GROUP(SmpFrag) {
+	struct smp_reasm reasm;
+	struct smp_frag frag;
+
+	void setup(void) {
+		memset(rxbuf, 0, sizeof(rxbuf));
+		smp_reasm_init(&reasm, rxbuf, sizeof(rxbuf));
+	}
+	void teardown(void) {
+	}
+
+	/* Splits a packet at the given MTU payload and feeds the fragments,
+	 * checking the packet completes on the last one and not before. */
+	void send(const uint8_t *p, size_t len, size_t mtu) {
+		const void *data;
+		size_t n;
+		size_t nr_frags = 0;
+
+		smp_frag_init(&frag, p, len);
+
+		while ((data = smp_frag_peek(&frag, mtu, &n)) != NULL) {
+			CHECK(n > 0 && n <= mtu);
+			smp_frag_consume(&frag, n);
+			nr_frags++;
+
+			const int rc = smp_reasm_feed(&reasm, data, n);
+			if (smp_frag_peek(&frag, mtu, &n) != NULL) {
+				LONGS_EQUAL(0, rc);
+				CHECK_TRUE(smp_reasm_busy(&reasm));
+			} else {
+				LONGS_EQUAL(len, rc);
+				CHECK_FALSE(smp_reasm_busy(&reasm));
+			}
+		}
+
+		LONGS_EQUAL((len + mtu - 1) / mtu, nr_frags);
+		MEMCMP_EQUAL(p, rxbuf, len);
+	}
+};
+
+/* The default ATT MTU through the 2M PHY data length and beyond, less the
+ * notification header, plus sizes that split the SMP header itself. */
+TEST(SmpFrag, ShouldRoundTrip_AtAnyMtu) {
+	static const size_t mtus[] = { 1, 3, 7, 8, 9, 20, 64, 182, 244, 509 };
+	static const size_t payloads[] = { 0, 1, 12, 100, 236, 500, 1024 };
+
+	for (size_t i = 0; i < sizeof(mtus) / sizeof(mtus[0]); i++) {
+		for (size_t j = 0; j < sizeof(payloads) / sizeof(payloads[0]);
+				j++) {
+			const size_t len = make_packet(packet, payloads[j],
+					(uint8_t)(i + j));
+			send(packet, len, mtus[i]);
+		}
+	}
+}
+
+TEST(SmpFrag, ShouldTakeBackToBackPackets_WithoutReset) {
+	for (uint8_t seq = 0; seq < 8; seq++) {
+		const size_t len = make_packet(packet, 40U * seq + 3U, seq);
+		send(packet, len, 20);
+	}
+}
+
+TEST(SmpFrag, ShouldFollowMtu_WhenChangedMidPacket) {
+	const size_t len = make_packet(packet, 1000, 1);
+	const size_t mtus[] = { 20, 244, 64, 509 };
+	const void *data;
+	size_t n;
+	size_t sent = 0;
+	int rc = 0;
+
+	smp_frag_init(&frag, packet, len);
+	for (size_t i = 0; (data = smp_frag_peek(&frag, mtus[i % 4], &n));
+			i++) {
+		LONGS_EQUAL(len - sent < mtus[i % 4]? len - sent : mtus[i % 4],
+				n);
+		rc = smp_reasm_feed(&reasm, data, n);
+		smp_frag_consume(&frag, n);
+		sent += n;
+	}
+
+	LONGS_EQUAL(len, sent);
+	LONGS_EQUAL(len, rc);
+	MEMCMP_EQUAL(packet, rxbuf, len);
+}
+
+TEST(SmpFrag, peek_ShouldNotConsume) {
+	const size_t len = make_packet(packet, 30, 0);
+	size_t n1, n2;
+
+	smp_frag_init(&frag, packet, len);
+	const void *p1 = smp_frag_peek(&frag, 20, &n1);
+	const void *p2 = smp_frag_peek(&frag, 20, &n2);
+	POINTERS_EQUAL(p1, p2);
+	LONGS_EQUAL(n1, n2);
+
+	POINTERS_EQUAL(NULL, smp_frag_peek(&frag, 0, &n1));
+	LONGS_EQUAL(0, n1);
+
+	smp_frag_consume(&frag, len + 100);
+	POINTERS_EQUAL(NULL, smp_frag_peek(&frag, 20, &n1));
+}
+
+TEST(SmpFrag, feed_ShouldRejectPacket_WhenLargerThanBuffer) {
+	make_packet(packet, BUFSIZE - SMP_FRAG_HDR_SIZE + 1U, 0);
+	LONGS_EQUAL(-EMSGSIZE, smp_reasm_feed(&reasm, packet, 20));
+	CHECK_FALSE(smp_reasm_busy(&reasm));
+
+	/* and the next packet is taken from its first fragment */
+	const size_t len = make_packet(packet, 100, 1);
+	send(packet, len, 20);
+}
+
+TEST(SmpFrag, feed_ShouldRejectFragment_WhenRunningPastPacket) {
+	const size_t len = make_packet(packet, 10, 0);
+
+	LONGS_EQUAL(0, smp_reasm_feed(&reasm, packet, 12));
+	LONGS_EQUAL(-EPROTO, smp_reasm_feed(&reasm, &packet[12], 20));
+	CHECK_FALSE(smp_reasm_busy(&reasm));
+
+	/* a single fragment carrying more than its header announces */
+	LONGS_EQUAL(-EPROTO, smp_reasm_feed(&reasm, packet, len + 1));
+
+	send(packet, len, 20);
+}
+
+TEST(SmpFrag, reset_ShouldDiscardPartialPacket) {
+	const size_t len = make_packet(packet, 100, 0);
+
+	LONGS_EQUAL(0, smp_reasm_feed(&reasm, packet, 20));
+	CHECK_TRUE(smp_reasm_busy(&reasm));
+	smp_reasm_reset(&reasm);
+	CHECK_FALSE(smp_reasm_busy(&reasm));
+
+	send(packet, len, 20);
+}
+
+TEST(SmpFrag, feed_ShouldStartOver_WhenCompletePacketWasNotReset) {
+	const size_t len = make_packet(packet, 50, 0);
+
+	send(packet, len, 244);
+	send(packet, len, 20);
+}
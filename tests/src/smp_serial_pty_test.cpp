@@ -0,0 +1,607 @@
+#include "CppUTest/TestHarness.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "smp_serial.h"
+
+/* What a driver read returns on the device, as on the ESP transport. */
+#define DEVICE_READ_SIZE	256U
+#define HOST_READ_SIZE		4096U
+#define REPLY_TIMEOUT_MS	2000
+#define ROUNDS			256U
+#define CLIENT_RX_MAX		(2U * SMP_SERIAL_BUF_SIZE)
+#define CLIENT_WIRE_KEPT	1024U /* reply bytes kept for golden checks */
+#define CLIENT_LINE_RAW		93U  /* nmxact: 124 base64 chars a line */
+
+#define GROUP_OS		0U
+#define GROUP_IMAGE		1U
+#define UPLOAD_CHUNK		496U /* mcumgr's default for a 512-byte MTU */
+#define UPLOAD_REPLY_LEN	16U  /* {"rc":0,"off":N} in CBOR, about */
+
+/* The device end: a framing instance over one side of a pty, run in its
+ * own thread and answering each request as the mgmt handler would. */
+struct end {
+	int fd;
+	struct smp_serial serial;
+	uint8_t slot[SMP_SERIAL_BUF_SIZE];
+	uint8_t reply[SMP_SERIAL_BUF_SIZE];
+	uint32_t nr_packets;
+	size_t nr_wire_bytes;
+};
+
+/* The host end: an SMP client written from the mcumgr serial transport
+ * (newtmgr's nmxact) instead of from smp_serial.c, so the two ends meet
+ * only on the wire format. Console requests go out 93 bytes to a line,
+ * each line base64 on its own; replies are taken a line at a time. */
+struct client {
+	int fd;
+	smp_serial_framing_t framing;
+	uint8_t rx[CLIENT_RX_MAX];
+	size_t rx_len;
+	uint8_t frame[CLIENT_RX_MAX];
+	size_t frame_len;
+	uint8_t reply[SMP_SERIAL_BUF_SIZE];
+	size_t reply_len;
+	uint32_t nr_packets;
+	uint32_t nr_bad;
+	size_t nr_wire_bytes;
+	uint8_t wire_in[CLIENT_WIRE_KEPT];
+	size_t wire_in_len;
+};
+
+static struct end device;
+static struct client host;
+static pthread_t device_thread;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool write_all(int fd, const uint8_t *p, size_t len)
+{
+	size_t n = 0;
+
+	while (n < len) {
+		const ssize_t rc = write(fd, &p[n], len - n);
+		if (rc < 0 && errno != EINTR) {
+			return false;
+		}
+		n += (rc > 0)? (size_t)rc : 0;
+	}
+
+	return true;
+}
+
+static int write_fd(const void *data, size_t len,
+		smp_serial_framing_t framing, void *ctx)
+{
+	struct end *e = (struct end *)ctx;
+
+	(void)framing;
+	if (!write_all(e->fd, (const uint8_t *)data, len)) {
+		return -1;
+	}
+
+	e->nr_wire_bytes += len;
+	return (int)len;
+}
+
+static uint8_t *lease(void *ctx)
+{
+	return ((struct end *)ctx)->slot;
+}
+
+static size_t make_packet(uint8_t *buf, uint8_t op, uint8_t group,
+		size_t payload_len, uint8_t seq)
+{
+	buf[0] = op;
+	buf[1] = 0;
+	buf[2] = (uint8_t)(payload_len >> 8);
+	buf[3] = (uint8_t)payload_len;
+	buf[4] = 0;
+	buf[5] = group;
+	buf[6] = seq;
+	buf[7] = 0;
+
+	for (size_t i = 0; i < payload_len; i++) {
+		buf[8U + i] = (uint8_t)(i * 31U + seq); /* zeros included */
+	}
+
+	return 8U + payload_len;
+}
+
+/* The handler: echo back what came in, or acknowledge an image chunk
+ * with a short reply. Either way in the framing of the request. */
+static void device_deliver(uint8_t *buf, size_t len,
+		smp_serial_framing_t framing, void *ctx)
+{
+	struct end *e = (struct end *)ctx;
+
+	e->nr_packets++;
+	smp_serial_set_reply_framing(&e->serial, framing);
+
+	if (buf[5] == GROUP_IMAGE) {
+		const size_t n = make_packet(e->reply, (uint8_t)(buf[0] + 1U),
+				GROUP_IMAGE, UPLOAD_REPLY_LEN, buf[6]);
+		(void)smp_serial_send(&e->serial, e->reply, n);
+		return;
+	}
+
+	buf[0]++; /* write request to write response */
+	(void)smp_serial_send(&e->serial, buf, len);
+}
+
+static const struct smp_serial_ops device_ops = {
+	.write = write_fd,
+	.lease = lease,
+	.deliver = device_deliver,
+};
+
+static const char b64_alphabet[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* CRC-16/XMODEM a bit at a time, as the client computes it. */
+static uint16_t client_crc16(const uint8_t *p, size_t len)
+{
+	uint16_t crc = 0;
+
+	for (size_t i = 0; i < len; i++) {
+		crc = (uint16_t)(crc ^ (p[i] << 8));
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000U)?
+				(uint16_t)((crc << 1) ^ 0x1021U) :
+				(uint16_t)(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+static size_t client_b64_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+	size_t n = 0;
+
+	for (size_t i = 0; i < len; i += 3U) {
+		const uint32_t v = ((uint32_t)in[i] << 16) |
+			((i + 1U < len)? (uint32_t)in[i + 1U] << 8 : 0) |
+			((i + 2U < len)? (uint32_t)in[i + 2U] : 0);
+
+		out[n++] = (uint8_t)b64_alphabet[(v >> 18) & 0x3FU];
+		out[n++] = (uint8_t)b64_alphabet[(v >> 12) & 0x3FU];
+		out[n++] = (i + 1U < len)?
+			(uint8_t)b64_alphabet[(v >> 6) & 0x3FU] : '=';
+		out[n++] = (i + 2U < len)?
+			(uint8_t)b64_alphabet[v & 0x3FU] : '=';
+	}
+
+	return n;
+}
+
+/* Each line is a whole base64 string, padding and all. Returns the
+ * decoded length, or -1 if the line is not. */
+static int client_b64_decode(const uint8_t *in, size_t len, uint8_t *out)
+{
+	size_t n = 0;
+
+	if (len % 4U != 0) {
+		return -1;
+	}
+
+	for (size_t i = 0; i < len; i += 4U) {
+		uint32_t v = 0;
+		int pad = 0;
+
+		for (size_t j = 0; j < 4U; j++) {
+			const char *c = (in[i + j] == '=' || in[i + j] == 0)?
+				NULL : strchr(b64_alphabet, in[i + j]);
+
+			if (in[i + j] == '=' && j >= 2U && i + 4U == len) {
+				pad++;
+			} else if (c == NULL || pad) {
+				return -1;
+			}
+			v = (v << 6) | (c? (uint32_t)(c - b64_alphabet) : 0);
+		}
+
+		out[n++] = (uint8_t)(v >> 16);
+		if (pad < 2) {
+			out[n++] = (uint8_t)(v >> 8);
+		}
+		if (pad < 1) {
+			out[n++] = (uint8_t)v;
+		}
+	}
+
+	return (int)n;
+}
+
+static bool client_write(const uint8_t *p, size_t len)
+{
+	host.nr_wire_bytes += len;
+	return write_all(host.fd, p, len);
+}
+
+/* [len + 2][packet][crc], the length counting the CRC, in 93-byte chunks:
+ * 0x06 0x09 ahead of the first, 0x04 0x14 ahead of the rest. */
+static bool client_send_console(const uint8_t *pkt, size_t len)
+{
+	static uint8_t raw[SMP_SERIAL_PKT_MAX + 4U];
+	const uint16_t crc = client_crc16(pkt, len);
+	const size_t raw_len = len + 4U;
+
+	raw[0] = (uint8_t)((len + 2U) >> 8);
+	raw[1] = (uint8_t)(len + 2U);
+	memcpy(&raw[2], pkt, len);
+	raw[len + 2U] = (uint8_t)(crc >> 8);
+	raw[len + 3U] = (uint8_t)crc;
+
+	for (size_t off = 0; off < raw_len; off += CLIENT_LINE_RAW) {
+		uint8_t line[2U + CLIENT_LINE_RAW / 3U * 4U + 1U];
+		const size_t n = (raw_len - off < CLIENT_LINE_RAW)?
+			raw_len - off : CLIENT_LINE_RAW;
+
+		line[0] = (off == 0)? 0x06 : 0x04;
+		line[1] = (off == 0)? 0x09 : 0x14;
+		size_t line_len = 2U + client_b64_encode(&raw[off], n, &line[2]);
+		line[line_len++] = '\n';
+
+		if (!client_write(line, line_len)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* 0x00, COBS(packet, crc), 0x00, stuffed the textbook way. */
+static bool client_send_cobs(const uint8_t *pkt, size_t len)
+{
+	static uint8_t raw[SMP_SERIAL_PKT_MAX + 2U];
+	static uint8_t out[2U * (SMP_SERIAL_PKT_MAX + 2U)];
+	const uint16_t crc = client_crc16(pkt, len);
+	const size_t raw_len = len + 2U;
+	size_t code_pos = 1;
+	size_t n = 2;
+	uint8_t code = 1;
+
+	memcpy(raw, pkt, len);
+	raw[len] = (uint8_t)(crc >> 8);
+	raw[len + 1U] = (uint8_t)crc;
+
+	out[0] = 0;
+	for (size_t i = 0; i < raw_len; i++) {
+		if (raw[i] != 0) {
+			out[n++] = raw[i];
+			code++;
+		}
+		if (raw[i] == 0 || code == 0xFFU) {
+			out[code_pos] = code;
+			code_pos = n++;
+			code = 1;
+		}
+	}
+	out[code_pos] = code;
+	out[n++] = 0;
+
+	return client_write(out, n);
+}
+
+static bool client_send(const uint8_t *pkt, size_t len)
+{
+	if (host.framing == SMP_SERIAL_FRAMING_COBS) {
+		return client_send_cobs(pkt, len);
+	}
+	return client_send_console(pkt, len);
+}
+
+static void client_deliver(const uint8_t *pkt, size_t len)
+{
+	memcpy(host.reply, pkt, len);
+	host.reply_len = len;
+	host.nr_packets++;
+}
+
+/* Anything not starting with a frame prefix is log output. A packet is
+ * complete once the length field, which counts the CRC, is met. */
+static void client_console_line(const uint8_t *line, size_t len)
+{
+	const bool first = len >= 2U && line[0] == 0x06 && line[1] == 0x09;
+	const bool cont = len >= 2U && line[0] == 0x04 && line[1] == 0x14;
+
+	if (first) {
+		host.frame_len = 0;
+	} else if (!cont || host.frame_len == 0) {
+		return;
+	}
+
+	const int n = client_b64_decode(&line[2], len - 2U,
+			&host.frame[host.frame_len]);
+	if (n <= 0 || host.frame_len + (size_t)n > SMP_SERIAL_BUF_SIZE + 2U) {
+		host.nr_bad++;
+		host.frame_len = 0;
+		return;
+	}
+	host.frame_len += (size_t)n;
+
+	const size_t pkt_len = ((size_t)host.frame[0] << 8) | host.frame[1];
+	if (host.frame_len < pkt_len + 2U) {
+		return;
+	}
+
+	if (host.frame_len != pkt_len + 2U || pkt_len < 2U ||
+			client_crc16(&host.frame[2], pkt_len) != 0) {
+		host.nr_bad++;
+	} else {
+		client_deliver(&host.frame[2], pkt_len - 2U);
+	}
+	host.frame_len = 0;
+}
+
+static void client_cobs_frame(const uint8_t *in, size_t len)
+{
+	size_t n = 0;
+
+	if (len == 0) {
+		return;
+	}
+
+	for (size_t i = 0; i < len;) {
+		const uint8_t code = in[i++];
+
+		if (code == 0 || i + code - 1U > len) {
+			host.nr_bad++;
+			return;
+		}
+		memcpy(&host.frame[n], &in[i], code - 1U);
+		n += code - 1U;
+		i += code - 1U;
+		if (code != 0xFFU && i < len) {
+			host.frame[n++] = 0;
+		}
+	}
+
+	if (n < 2U || client_crc16(host.frame, n) != 0) {
+		host.nr_bad++;
+		return;
+	}
+	client_deliver(host.frame, n - 2U);
+}
+
+static void client_feed(const uint8_t *p, size_t len)
+{
+	const uint8_t end = (host.framing == SMP_SERIAL_FRAMING_COBS)?
+		0 : '\n';
+
+	for (size_t i = 0; i < len; i++) {
+		if (p[i] != end) {
+			if (host.rx_len < sizeof(host.rx)) {
+				host.rx[host.rx_len++] = p[i];
+			}
+			continue;
+		}
+
+		if (end == 0) {
+			client_cobs_frame(host.rx, host.rx_len);
+		} else {
+			client_console_line(host.rx, host.rx_len);
+		}
+		host.rx_len = 0;
+	}
+}
+
+/* Ends once the host closes its side of the pty. */
+static void *run_device(void *arg)
+{
+	uint8_t block[DEVICE_READ_SIZE];
+
+	(void)arg;
+	for (;;) {
+		const ssize_t n = read(device.fd, block, sizeof(block));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		} else if (n <= 0) {
+			break;
+		}
+		smp_serial_feed(&device.serial, block, (size_t)n);
+	}
+
+	return NULL;
+}
+
+static bool wait_reply(uint32_t nr_replies)
+{
+	uint8_t block[HOST_READ_SIZE];
+	struct pollfd pfd = { .fd = host.fd, .events = POLLIN, .revents = 0 };
+
+	while (host.nr_packets < nr_replies) {
+		if (poll(&pfd, 1, REPLY_TIMEOUT_MS) <= 0) {
+			return false;
+		}
+
+		const ssize_t n = read(host.fd, block, sizeof(block));
+		if (n > 0) {
+			const size_t room = sizeof(host.wire_in) -
+				host.wire_in_len;
+			const size_t kept = ((size_t)n < room)? (size_t)n : room;
+
+			memcpy(&host.wire_in[host.wire_in_len], block, kept);
+			host.wire_in_len += kept;
+			client_feed(block, (size_t)n);
+		} else if (n < 0 && errno != EINTR && errno != EAGAIN) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int compare_ns(const void *a, const void *b)
+{
+	const uint64_t x = *(const uint64_t *)a;
+	const uint64_t y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+/* Stop and wait, as mcumgr clients do: each request goes out once the
+ * reply to the previous one is in, so a round trip is the latency a
+ * client sees and the rate its throughput. */
+static void run(smp_serial_framing_t framing, uint8_t group,
+		size_t payload_len, const char *name)
+{
+	static uint64_t latency[ROUNDS];
+	uint8_t req[SMP_SERIAL_PKT_MAX];
+	size_t nr_bytes = 0;
+
+	host.framing = framing;
+
+	const uint64_t t0 = now_ns();
+	for (uint32_t i = 0; i < ROUNDS; i++) {
+		const size_t len = make_packet(req, 2, group, payload_len,
+				(uint8_t)i);
+		const uint64_t t = now_ns();
+
+		CHECK_TRUE(client_send(req, len));
+		CHECK_TRUE(wait_reply(i + 1U));
+		latency[i] = now_ns() - t;
+
+		LONGS_EQUAL(3, host.reply[0]);
+		LONGS_EQUAL((uint8_t)i, host.reply[6]);
+		if (group == GROUP_OS) {
+			LONGS_EQUAL(len, host.reply_len);
+			MEMCMP_EQUAL(&req[8], &host.reply[8], payload_len);
+		}
+		nr_bytes += len + host.reply_len;
+	}
+	const double sec = (double)(now_ns() - t0) / 1e9;
+
+	struct smp_serial_stats stats;
+	smp_serial_get_stats(&device.serial, &stats);
+	LONGS_EQUAL(ROUNDS, stats.rx_packets);
+	LONGS_EQUAL(0, stats.crc_errors + stats.malformed + stats.dropped);
+	LONGS_EQUAL(0, host.nr_bad);
+
+	qsort(latency, ROUNDS, sizeof(latency[0]), compare_ns);
+	printf("\n\t%s: %6.0f packets/s, %6.1f KiB/s of SMP, "
+			"%6.1f KiB/s on the wire\n"
+			"\t\tround trip p50 %5.0f us, p99 %5.0f us, "
+			"max %5.0f us\n", name, ROUNDS / sec,
+			(double)nr_bytes / sec / 1024.0,
+			(double)(host.nr_wire_bytes + device.nr_wire_bytes) /
+				sec / 1024.0,
+			(double)latency[ROUNDS / 2U] / 1e3,
+			(double)latency[ROUNDS * 99U / 100U] / 1e3,
+			(double)latency[ROUNDS - 1U] / 1e3);
+}
+
+/* Requests as the mcumgr client puts them on the wire, length counting
+ * the CRC: "echo hello" in the os group, and an echo long enough to take
+ * a continuation line. */
+static const uint8_t golden_echo_hello[] =
+	"\x06\x09" "ABMCAAAJAAAAAKFhZGVoZWxsbyVv\n";
+static const uint8_t golden_echo_hello_reply[] =
+	"\x06\x09" "ABMDAAAJAAAAAKFhZGVoZWxsbzWN\n";
+static const uint8_t golden_echo_hello_pkt[] = {
+	0x02, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x00,
+	0xa1, 0x61, 0x64, 0x65, 0x68, 0x65, 0x6c, 0x6c, 0x6f,
+};
+static const uint8_t golden_echo_long[] =
+	"\x06\x09" "AHkCAABvAAABAKFhZHhqVGhlIHF1aWNrIGJyb3duIGZveCBqdW1wcyBvd"
+	"mVyIHRoZSBsYXp5IGRvZy4gVGhlIHF1aWNrIGJyb3duIGZveCBqdW1wcyBvdmVyIHRo\n"
+	"\x04\x14" "ZSBsYXp5IGRvZy4gU01QIG92ZXIgc2VyaWFsIXwI\n";
+static const char golden_echo_long_text[] =
+	"The quick brown fox jumps over the lazy dog. "
+	"The quick brown fox jumps over the lazy dog. SMP over serial!";
+
+static void send_golden(const uint8_t *frame, size_t len)
+{
+	host.framing = SMP_SERIAL_FRAMING_CONSOLE;
+	CHECK_TRUE(client_write(frame, len));
+	CHECK_TRUE(wait_reply(1));
+
+	struct smp_serial_stats stats;
+	smp_serial_get_stats(&device.serial, &stats);
+	LONGS_EQUAL(1, stats.rx_packets);
+	LONGS_EQUAL(0, stats.crc_errors + stats.malformed + stats.dropped);
+	LONGS_EQUAL(0, host.nr_bad);
+}
+
+TEST_GROUP(SmpSerialPty) {
+	void setup(void) {
+		struct termios tio;
+
+		memset(&device, 0, sizeof(device));
+		memset(&host, 0, sizeof(host));
+
+		host.fd = posix_openpt(O_RDWR | O_NOCTTY);
+		CHECK(host.fd >= 0);
+		CHECK(grantpt(host.fd) == 0 && unlockpt(host.fd) == 0);
+		device.fd = open(ptsname(host.fd), O_RDWR | O_NOCTTY);
+		CHECK(device.fd >= 0);
+
+		/* 8-bit clean both ways, with no echo or line editing */
+		CHECK(tcgetattr(device.fd, &tio) == 0);
+		cfmakeraw(&tio);
+		CHECK(tcsetattr(device.fd, TCSANOW, &tio) == 0);
+
+		smp_serial_init(&device.serial, &device_ops, &device);
+		smp_serial_set_framing(&device.serial, SMP_SERIAL_FRAMING_AUTO);
+
+		pthread_create(&device_thread, NULL, run_device, NULL);
+	}
+	void teardown(void) {
+		close(host.fd);
+		pthread_join(device_thread, NULL);
+		close(device.fd);
+	}
+};
+
+TEST(SmpSerialPty, ConsoleEcho) {
+	run(SMP_SERIAL_FRAMING_CONSOLE, GROUP_OS, 128, "console, 136-byte echo");
+}
+
+TEST(SmpSerialPty, CobsEcho) {
+	run(SMP_SERIAL_FRAMING_COBS, GROUP_OS, 128, "cobs, 136-byte echo");
+}
+
+TEST(SmpSerialPty, ConsoleImageUpload) {
+	run(SMP_SERIAL_FRAMING_CONSOLE, GROUP_IMAGE, UPLOAD_CHUNK,
+			"console, 504-byte upload");
+}
+
+TEST(SmpSerialPty, CobsImageUpload) {
+	run(SMP_SERIAL_FRAMING_COBS, GROUP_IMAGE, UPLOAD_CHUNK,
+			"cobs, 504-byte upload");
+}
+
+TEST(SmpSerialPty, ShouldAnswerGoldenRequest_ByteForByte) {
+	send_golden(golden_echo_hello, sizeof(golden_echo_hello) - 1U);
+
+	LONGS_EQUAL(sizeof(golden_echo_hello_pkt), host.reply_len);
+	LONGS_EQUAL(3, host.reply[0]);
+	MEMCMP_EQUAL(&golden_echo_hello_pkt[1], &host.reply[1],
+			sizeof(golden_echo_hello_pkt) - 1U);
+	LONGS_EQUAL(sizeof(golden_echo_hello_reply) - 1U, host.wire_in_len);
+	MEMCMP_EQUAL(golden_echo_hello_reply, host.wire_in, host.wire_in_len);
+}
+
+TEST(SmpSerialPty, ShouldAnswerGoldenRequest_WhenItSpansLines) {
+	send_golden(golden_echo_long, sizeof(golden_echo_long) - 1U);
+
+	LONGS_EQUAL(8U + 5U + sizeof(golden_echo_long_text) - 1U,
+			host.reply_len);
+	LONGS_EQUAL(3, host.reply[0]);
+	LONGS_EQUAL(1, host.reply[6]);
+	MEMCMP_EQUAL(golden_echo_long_text, &host.reply[13],
+			sizeof(golden_echo_long_text) - 1U);
+}
@@ -0,0 +1,681 @@
+#include "CppUTest/TestHarness.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "smp_serial.h"
+#include "crc16_xmodem.h"
+
+#define UPLOAD_CHUNK		496U /* mcumgr's default for a 512-byte MTU */
+#define SESSION_PACKETS		256U
+#define RECORDING_MAX		(512U * 1024U)
+
+/* The wire as the device sees it: every byte either side wrote. */
+struct wire {
+	uint8_t buf[RECORDING_MAX];
+	size_t len;
+	uint32_t nr_writes;
+	size_t max_write;
+};
+
+struct receiver {
+	uint8_t slot[SMP_SERIAL_BUF_SIZE];
+	bool no_buffer;
+	bool verify;	/* check each packet against make_packet() */
+	uint32_t nr_corrupt;
+	uint32_t nr_packets;
+	size_t nr_bytes;
+	size_t last_len;
+	smp_serial_framing_t last_framing;
+};
+
+static struct wire wire;
+static struct receiver rx;
+static struct smp_serial tx_side;
+static struct smp_serial rx_side;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int record(const void *data, size_t len,
+		smp_serial_framing_t framing, void *ctx)
+{
+	struct wire *w = (struct wire *)ctx;
+
+	(void)framing;
+	if (len > sizeof(w->buf) - w->len) {
+		return -1;
+	}
+	memcpy(&w->buf[w->len], data, len);
+	w->len += len;
+	w->nr_writes++;
+	w->max_write = (len > w->max_write)? len : w->max_write;
+
+	return (int)len;
+}
+
+/* An image upload request: an SMP header and a chunk of image. The bytes
+ * are pseudo-random so both framings see zeros and every base64 digit. */
+static size_t make_packet(uint8_t *buf, size_t payload_len, uint32_t seq)
+{
+	uint32_t x = seq * 2654435761u + 1u;
+
+	buf[0] = 2; /* write */
+	buf[1] = 0;
+	buf[2] = (uint8_t)(payload_len >> 8);
+	buf[3] = (uint8_t)payload_len;
+	buf[4] = 0;
+	buf[5] = 1; /* image group */
+	buf[6] = (uint8_t)seq;
+	buf[7] = 1; /* upload */
+
+	for (size_t i = 0; i < payload_len; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		buf[8U + i] = (uint8_t)x;
+	}
+
+	return 8U + payload_len;
+}
+
+static uint8_t *lease(void *ctx)
+{
+	struct receiver *r = (struct receiver *)ctx;
+	return r->no_buffer? NULL : r->slot;
+}
+
+static void deliver(uint8_t *buf, size_t len, smp_serial_framing_t framing,
+		void *ctx)
+{
+	struct receiver *r = (struct receiver *)ctx;
+
+	if (r->verify) {
+		uint8_t expected[SMP_SERIAL_PKT_MAX];
+		const size_t payload_len = (size_t)buf[2] << 8 | buf[3];
+
+		if (len < 8U || payload_len != len - 8U ||
+				make_packet(expected, payload_len, buf[6]) != len ||
+				memcmp(buf, expected, len) != 0) {
+			r->nr_corrupt++;
+		}
+	}
+
+	r->nr_packets++;
+	r->nr_bytes += len;
+	r->last_len = len;
+	r->last_framing = framing;
+}
+
+static const struct smp_serial_ops tx_ops = {
+	.write = record,
+	.lease = NULL,
+	.deliver = NULL,
+};
+
+static const struct smp_serial_ops rx_ops = {
+	.write = NULL,
+	.lease = lease,
+	.deliver = deliver,
+};
+
+/* What the host sends for an upload of @p count chunks, with the log
+ * output a console-shared link carries in between. */
+static void clear_wire(void)
+{
+	wire.len = 0;
+	wire.nr_writes = 0;
+	wire.max_write = 0;
+}
+
+static void append_session(smp_serial_framing_t framing, size_t chunk,
+		uint32_t first, uint32_t count)
+{
+	static const char log[] = "I (12345) app: flash write done\r\n";
+	uint8_t pkt[SMP_SERIAL_PKT_MAX];
+
+	smp_serial_init(&tx_side, &tx_ops, &wire);
+	smp_serial_set_framing(&tx_side, framing);
+
+	for (uint32_t i = first; i < first + count; i++) {
+		const size_t len = make_packet(pkt, chunk, i);
+
+		LONGS_EQUAL(0, smp_serial_send(&tx_side, pkt, len));
+		if (framing == SMP_SERIAL_FRAMING_CONSOLE && (i % 4U) == 0) {
+			record(log, sizeof(log) - 1, framing, &wire);
+		}
+	}
+}
+
+static void record_session(smp_serial_framing_t framing, size_t chunk,
+		uint32_t count)
+{
+	clear_wire();
+	append_session(framing, chunk, 0, count);
+}
+
+/* The receiver as it was before decoding went incremental: every line end
+ * decodes the frame gathered so far all over again from its start. Kept
+ * to measure against. */
+struct whole_frame {
+	uint8_t b64[SMP_SERIAL_BUF_SIZE * 2U];
+	size_t len;
+	uint8_t decoded[SMP_SERIAL_BUF_SIZE + 2U];
+	uint32_t nr_packets;
+};
+
+static size_t decode_base64(const uint8_t *in, size_t len, uint8_t *out)
+{
+	static int8_t map[256];
+	size_t n = 0;
+
+	if (map['B'] == 0) {
+		const char *abc = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+			"abcdefghijklmnopqrstuvwxyz0123456789+/";
+		memset(map, -1, sizeof(map));
+		for (int i = 0; i < 64; i++) {
+			map[(uint8_t)abc[i]] = (int8_t)i;
+		}
+	}
+
+	for (size_t i = 0; i + 4U <= len; i += 4U) {
+		const uint32_t v = (uint32_t)map[in[i]] << 18 |
+			(uint32_t)map[in[i + 1]] << 12 |
+			(uint32_t)(in[i + 2] == '=' ? 0 : map[in[i + 2]]) << 6 |
+			(uint32_t)(in[i + 3] == '=' ? 0 : map[in[i + 3]]);
+
+		out[n++] = (uint8_t)(v >> 16);
+		if (in[i + 2] != '=') {
+			out[n++] = (uint8_t)(v >> 8);
+		}
+		if (in[i + 3] != '=') {
+			out[n++] = (uint8_t)v;
+		}
+	}
+
+	return n;
+}
+
+static void whole_frame_line(struct whole_frame *w)
+{
+	if (w->len == 0 || (w->len & 3U) != 0) {
+		return;
+	}
+
+	const size_t n = decode_base64(w->b64, w->len, w->decoded);
+	const size_t pkt_len = (size_t)w->decoded[0] << 8 | w->decoded[1];
+
+	if (n < 4U || n < pkt_len + 2U) {
+		return;
+	}
+	if (n == pkt_len + 2U && crc16_xmodem_update(CRC16_XMODEM_INIT,
+			&w->decoded[2], pkt_len) == 0U) {
+		w->nr_packets++;
+	}
+	w->len = 0;
+}
+
+static void whole_frame_feed(struct whole_frame *w,
+		const uint8_t *data, size_t len)
+{
+	const uint8_t *p = data;
+	const uint8_t *end = data + len;
+
+	while (p < end) {
+		const uint8_t *eol = (const uint8_t *)memchr(p, '\n',
+				(size_t)(end - p));
+		const size_t n = (size_t)(eol - p);
+
+		if (n >= 2U && p[0] == 0x06 && p[1] == 0x09) {
+			w->len = 0;
+		} else if (!(n >= 2U && p[0] == 0x04 && p[1] == 0x14 &&
+				w->len != 0)) {
+			p = eol + 1;
+			continue;
+		}
+
+		memcpy(&w->b64[w->len], &p[2], n - 2U);
+		w->len += n - 2U;
+		whole_frame_line(w);
+		p = eol + 1;
+	}
+}
+
+static void feed_in_blocks(const uint8_t *data, size_t len, size_t block)
+{
+	for (size_t i = 0; i < len; i += block) {
+		smp_serial_feed(&rx_side, &data[i],
+				(len - i < block)? len - i : block);
+	}
+}
+
+TEST_GROUP(SmpSerial) {
+	void setup(void) {
+		memset(&rx, 0, sizeof(rx));
+		smp_serial_init(&rx_side, &rx_ops, &rx);
+	}
+	void teardown(void) {
+	}
+};
+
+static void send_cobs(const uint8_t *pkt, size_t len)
+{
+	clear_wire();
+	smp_serial_init(&tx_side, &tx_ops, &wire);
+	smp_serial_set_framing(&tx_side, SMP_SERIAL_FRAMING_COBS);
+	LONGS_EQUAL(0, smp_serial_send(&tx_side, pkt, len));
+}
+
+/* A frame is written block by block from a small buffer: zeros only as
+ * the two delimiters, no write larger than the buffer, and the receiver
+ * gets back what was sent. */
+static void check_cobs_round_trip(const uint8_t *pkt, size_t len)
+{
+	send_cobs(pkt, len);
+
+	CHECK(wire.max_write <= SMP_SERIAL_COBS_TX_BUFSIZE);
+	BYTES_EQUAL(0, wire.buf[0]);
+	BYTES_EQUAL(0, wire.buf[wire.len - 1]);
+	POINTERS_EQUAL(NULL, memchr(&wire.buf[1], 0, wire.len - 2));
+
+	rx.nr_packets = 0;
+	smp_serial_set_framing(&rx_side, SMP_SERIAL_FRAMING_COBS);
+	smp_serial_feed(&rx_side, wire.buf, wire.len);
+	LONGS_EQUAL(1, rx.nr_packets);
+	LONGS_EQUAL(len, rx.last_len);
+	MEMCMP_EQUAL(pkt, rx.slot, len);
+}
+
+TEST(SmpSerial, send_ShouldWriteCobsInBlocks_WhenPacketIsLarge) {
+	uint8_t pkt[SMP_SERIAL_PKT_MAX];
+
+	const size_t len = make_packet(pkt, sizeof(pkt) - 8U, 1);
+	check_cobs_round_trip(pkt, len);
+	CHECK(wire.nr_writes > 1);
+}
+
+TEST(SmpSerial, send_ShouldEncodeCobs_AroundFullBlocks) {
+	static const size_t runs[] = { 1, 253, 254, 255, 508, 509, 1000 };
+	uint8_t pkt[SMP_SERIAL_PKT_MAX];
+
+	for (size_t k = 0; k < sizeof(runs) / sizeof(runs[0]); k++) {
+		memset(pkt, 0xA5, runs[k]);
+		check_cobs_round_trip(pkt, runs[k]);
+
+		pkt[runs[k]] = 0; /* and a zero right after the run */
+		check_cobs_round_trip(pkt, runs[k] + 1U);
+	}
+}
+
+TEST(SmpSerial, send_ShouldEncodeCobs_WhenPacketIsAllZeros) {
+	uint8_t pkt[SMP_SERIAL_PKT_MAX];
+
+	memset(pkt, 0, sizeof(pkt));
+	check_cobs_round_trip(pkt, sizeof(pkt));
+	check_cobs_round_trip(pkt, 1);
+}
+
+static void feed_randomly(const uint8_t *data, size_t len, uint32_t seed)
+{
+	uint32_t x = seed * 2654435761u + 1u;
+
+	for (size_t i = 0; i < len;) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		size_t n = 1U + x % 600U;
+		n = (n < len - i)? n : len - i;
+		smp_serial_feed(&rx_side, &data[i], n);
+		i += n;
+	}
+}
+
+static const struct smp_serial_stats *get_stats(void)
+{
+	static struct smp_serial_stats stats;
+	smp_serial_get_stats(&rx_side, &stats);
+	return &stats;
+}
+
+static void check_no_errors(void)
+{
+	const struct smp_serial_stats *stats = get_stats();
+
+	LONGS_EQUAL(0, stats->crc_errors);
+	LONGS_EQUAL(0, stats->malformed);
+	LONGS_EQUAL(0, stats->dropped);
+	LONGS_EQUAL(0, rx.nr_corrupt);
+}
+
+/* Lengths around every quantum, line and block boundary. */
+static const size_t payloads[] = {
+	0, 1, 2, 3, 88, 89, 90, 91, 245, 246, 247, 496, SMP_SERIAL_PKT_MAX - 8U,
+};
+
+/* Every session, whatever the framing, read the way a driver might hand
+ * it over: a byte at a time, in blocks that fit no boundary, and at
+ * random. */
+static void check_session(smp_serial_framing_t framing)
+{
+	static const size_t blocks[] = { 1, 2, 3, 7, 64, 127, 4096 };
+	const uint32_t count = 8U;
+
+	smp_serial_set_framing(&rx_side, framing);
+	rx.verify = true;
+
+	for (size_t k = 0; k < sizeof(payloads) / sizeof(payloads[0]); k++) {
+		record_session(framing, payloads[k], count);
+
+		for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+			rx.nr_packets = 0;
+			feed_in_blocks(wire.buf, wire.len, blocks[b]);
+			LONGS_EQUAL(count, rx.nr_packets);
+			LONGS_EQUAL(payloads[k] + 8U, rx.last_len);
+			LONGS_EQUAL(framing, rx.last_framing);
+		}
+
+		rx.nr_packets = 0;
+		feed_randomly(wire.buf, wire.len, (uint32_t)k);
+		LONGS_EQUAL(count, rx.nr_packets);
+	}
+
+	check_no_errors();
+	LONGS_EQUAL(sizeof(payloads) / sizeof(payloads[0]) * count *
+			(sizeof(blocks) / sizeof(blocks[0]) + 1U),
+			get_stats()->rx_packets);
+}
+
+TEST(SmpSerial, feed_ShouldDeliverConsolePackets_WhenReadInAnyChunks) {
+	check_session(SMP_SERIAL_FRAMING_CONSOLE);
+}
+
+TEST(SmpSerial, feed_ShouldDeliverCobsPackets_WhenReadInAnyChunks) {
+	check_session(SMP_SERIAL_FRAMING_COBS);
+}
+
+/* Log lines may land between the lines of a frame, as each line takes
+ * the console lock on its own. */
+TEST(SmpSerial, feed_ShouldSkipLogLines_BetweenLinesOfAFrame) {
+	static const char log[] = "W (42) wifi: beacon timeout\r\n";
+	static uint8_t mixed[RECORDING_MAX];
+	size_t len = 0;
+
+	record_session(SMP_SERIAL_FRAMING_CONSOLE, SMP_SERIAL_PKT_MAX - 8U, 4);
+	for (size_t i = 0; i < wire.len; i++) {
+		mixed[len++] = wire.buf[i];
+		if (wire.buf[i] == SMP_SERIAL_LINE_END) {
+			memcpy(&mixed[len], log, sizeof(log) - 1);
+			len += sizeof(log) - 1;
+		}
+	}
+
+	rx.verify = true;
+	feed_randomly(mixed, len, 1);
+	LONGS_EQUAL(4, rx.nr_packets);
+	check_no_errors();
+}
+
+TEST(SmpSerial, feed_ShouldTakeBothFramings_WhenAuto) {
+	clear_wire();
+	append_session(SMP_SERIAL_FRAMING_CONSOLE, 100, 0, 3);
+	append_session(SMP_SERIAL_FRAMING_COBS, 100, 3, 3);
+	append_session(SMP_SERIAL_FRAMING_CONSOLE, 100, 6, 1);
+
+	smp_serial_set_framing(&rx_side, SMP_SERIAL_FRAMING_AUTO);
+	rx.verify = true;
+
+	const size_t cut = wire.len - (wire.len / 7U);
+	smp_serial_feed(&rx_side, wire.buf, cut);
+	LONGS_EQUAL(6, rx.nr_packets);
+	LONGS_EQUAL(SMP_SERIAL_FRAMING_COBS, rx.last_framing);
+	smp_serial_feed(&rx_side, &wire.buf[cut], wire.len - cut);
+	LONGS_EQUAL(7, rx.nr_packets);
+	LONGS_EQUAL(SMP_SERIAL_FRAMING_CONSOLE, rx.last_framing);
+	check_no_errors();
+}
+
+TEST(SmpSerial, feed_ShouldIgnoreOtherFraming_WhenFramingIsFixed) {
+	record_session(SMP_SERIAL_FRAMING_COBS, 100, 2);
+	smp_serial_set_framing(&rx_side, SMP_SERIAL_FRAMING_CONSOLE);
+	smp_serial_feed(&rx_side, wire.buf, wire.len);
+	LONGS_EQUAL(0, rx.nr_packets);
+
+	record_session(SMP_SERIAL_FRAMING_CONSOLE, 100, 2);
+	smp_serial_set_framing(&rx_side, SMP_SERIAL_FRAMING_COBS);
+	smp_serial_feed(&rx_side, wire.buf, wire.len);
+	LONGS_EQUAL(0, rx.nr_packets);
+
+	check_no_errors();
+}
+
+TEST(SmpSerial, send_ShouldReplyInRequestFraming_WhenAuto) {
+	uint8_t pkt[16];
+	const size_t len = make_packet(pkt, 8, 0);
+
+	clear_wire();
+	smp_serial_init(&tx_side, &tx_ops, &wire);
+	LONGS_EQUAL(0, smp_serial_set_framing(&tx_side,
+			SMP_SERIAL_FRAMING_AUTO));
+
+	smp_serial_set_reply_framing(&tx_side, SMP_SERIAL_FRAMING_COBS);
+	LONGS_EQUAL(0, smp_serial_send(&tx_side, pkt, len));
+	BYTES_EQUAL(0, wire.buf[0]);
+
+	clear_wire();
+	smp_serial_set_reply_framing(&tx_side, SMP_SERIAL_FRAMING_CONSOLE);
+	LONGS_EQUAL(0, smp_serial_send(&tx_side, pkt, len));
+	BYTES_EQUAL(0x06, wire.buf[0]);
+
+	/* and a fixed framing stays as it is */
+	clear_wire();
+	smp_serial_set_framing(&tx_side, SMP_SERIAL_FRAMING_CONSOLE);
+	smp_serial_set_reply_framing(&tx_side, SMP_SERIAL_FRAMING_COBS);
+	LONGS_EQUAL(0, smp_serial_send(&tx_side, pkt, len));
+	BYTES_EQUAL(0x06, wire.buf[0]);
+
+	LONGS_EQUAL(-1, smp_serial_set_framing(&tx_side,
+			(smp_serial_framing_t)3));
+}
+
+/* A corrupted frame is counted and dropped, and the next one gets
+ * through. */
+TEST(SmpSerial, feed_ShouldDropPacket_WhenCrcDoesNotMatch) {
+	uint8_t pkt[SMP_SERIAL_PKT_MAX];
+	const size_t len = make_packet(pkt, 300, 5);
+
+	record_session(SMP_SERIAL_FRAMING_CONSOLE, 300, 1);
+	uint8_t *digit = &wire.buf[40];
+	*digit = (*digit == 'A')? 'B' : 'A'; /* still base64 */
+	smp_serial_feed(&rx_side, wire.buf, wire.len);
+	LONGS_EQUAL(0, rx.nr_packets);
+	LONGS_EQUAL(1, get_stats()->crc_errors);
+
+	memset(pkt, 0xA5, len);
+	send_cobs(pkt, len);
+	wire.buf[40] = 0x5A; /* a data byte, not a code */
+	smp_serial_set_framing(&rx_side, SMP_SERIAL_FRAMING_COBS);
+	smp_serial_feed(&rx_side, wire.buf, wire.len);
+	LONGS_EQUAL(0, rx.nr_packets);
+	LONGS_EQUAL(2, get_stats()->crc_errors);
+
+	send_cobs(pkt, len);
+	smp_serial_feed(&rx_side, wire.buf, wire.len);
+	LONGS_EQUAL(1, rx.nr_packets);
+	LONGS_EQUAL(0, get_stats()->malformed);
+}
+
+TEST(SmpSerial, feed_ShouldDropPacket_WhenNoBufferIsLeased) {
+	static const smp_serial_framing_t framings[] = {
+		SMP_SERIAL_FRAMING_CONSOLE, SMP_SERIAL_FRAMING_COBS,
+	};
+
+	smp_serial_set_framing(&rx_side, SMP_SERIAL_FRAMING_AUTO);
+	rx.verify = true;
+
+	for (size_t k = 0; k < 2; k++) {
+		record_session(framings[k], 496, 2);
+
+		rx.no_buffer = true;
+		smp_serial_feed(&rx_side, wire.buf, wire.len);
+		LONGS_EQUAL(0, rx.nr_packets);
+		LONGS_EQUAL(2U * (k + 1U), get_stats()->dropped);
+
+		rx.no_buffer = false;
+		smp_serial_feed(&rx_side, wire.buf, wire.len);
+		LONGS_EQUAL(2, rx.nr_packets);
+		rx.nr_packets = 0;
+	}
+
+	const struct smp_serial_stats *stats = get_stats();
+	LONGS_EQUAL(0, stats->crc_errors + stats->malformed);
+	LONGS_EQUAL(4, stats->rx_packets);
+	LONGS_EQUAL(0, rx.nr_corrupt);
+}
+
+TEST(SmpSerial, send_ShouldFail_WhenPacketIsTooLarge) {
+	static uint8_t pkt[SMP_SERIAL_PKT_MAX + 1U];
+
+	clear_wire();
+	smp_serial_init(&tx_side, &tx_ops, &wire);
+	LONGS_EQUAL(-1, smp_serial_send(&tx_side, pkt, sizeof(pkt)));
+	smp_serial_set_framing(&tx_side, SMP_SERIAL_FRAMING_COBS);
+	LONGS_EQUAL(-1, smp_serial_send(&tx_side, pkt, sizeof(pkt)));
+	LONGS_EQUAL(0, wire.len);
+}
+
+/* Frames no sender of ours would make: one declaring more than a buffer
+ * holds, one running past it, and a line that is not base64. */
+TEST(SmpSerial, feed_ShouldDropFrame_WhenOversizeOrMalformed) {
+	static const char too_long[] = "\x06\x09" "EAAAAAAAAAAA\n";
+	static const char not_base64[] = "\x06\x09" "AB*DAAAA\n";
+	static uint8_t cobs[1 + 5U * 255U + 1];
+
+	smp_serial_set_framing(&rx_side, SMP_SERIAL_FRAMING_AUTO);
+
+	smp_serial_feed(&rx_side, too_long, sizeof(too_long) - 1);
+	LONGS_EQUAL(1, get_stats()->malformed);
+	smp_serial_feed(&rx_side, not_base64, sizeof(not_base64) - 1);
+	LONGS_EQUAL(2, get_stats()->malformed);
+
+	memset(cobs, 0x11, sizeof(cobs));
+	cobs[0] = 0;
+	for (size_t i = 1; i < sizeof(cobs) - 1; i += 255U) {
+		cobs[i] = 0xFF;
+	}
+	cobs[sizeof(cobs) - 1] = 0;
+	smp_serial_feed(&rx_side, cobs, sizeof(cobs));
+	LONGS_EQUAL(3, get_stats()->malformed);
+	LONGS_EQUAL(0, rx.nr_packets);
+
+	/* and the receiver is back on track right after */
+	rx.verify = true;
+	record_session(SMP_SERIAL_FRAMING_CONSOLE, SMP_SERIAL_PKT_MAX - 8U, 1);
+	append_session(SMP_SERIAL_FRAMING_COBS, SMP_SERIAL_PKT_MAX - 8U, 1, 1);
+	smp_serial_feed(&rx_side, wire.buf, wire.len);
+	LONGS_EQUAL(2, rx.nr_packets);
+	LONGS_EQUAL(0, get_stats()->crc_errors);
+	LONGS_EQUAL(0, rx.nr_corrupt);
+}
+
+/* Bytes lost in the middle of a frame: the port resets, and the rest of
+ * the broken frame goes by without a packet or a stall. */
+TEST(SmpSerial, reset_ShouldDropFrameInProgress) {
+	record_session(SMP_SERIAL_FRAMING_CONSOLE, 496, 2);
+	const size_t half = wire.len / 4U;
+
+	smp_serial_feed(&rx_side, wire.buf, half);
+	smp_serial_reset(&rx_side);
+	smp_serial_feed(&rx_side, &wire.buf[half], wire.len - half);
+	LONGS_EQUAL(1, rx.nr_packets);
+}
+
+/* Throughput of the receiver over a recorded upload, fed in blocks the
+ * size a driver read returns. A block of one is what a byte-per-read
+ * transport amounts to. */
+static void bench_feed(smp_serial_framing_t framing, const char *name)
+{
+	static const size_t blocks[] = { 1, 16, 64, 256, 4096 };
+	const uint32_t rounds = 8U;
+	double rate[sizeof(blocks) / sizeof(blocks[0])];
+
+	record_session(framing, UPLOAD_CHUNK, SESSION_PACKETS);
+	smp_serial_set_framing(&rx_side, SMP_SERIAL_FRAMING_AUTO);
+
+	for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+		rx.nr_packets = 0;
+
+		const uint64_t t0 = now_ns();
+		for (uint32_t r = 0; r < rounds; r++) {
+			feed_in_blocks(wire.buf, wire.len, blocks[b]);
+		}
+		const double sec = (double)(now_ns() - t0) / 1e9;
+
+		struct smp_serial_stats stats;
+		smp_serial_get_stats(&rx_side, &stats);
+		LONGS_EQUAL(SESSION_PACKETS * rounds, rx.nr_packets);
+		LONGS_EQUAL(0, stats.crc_errors + stats.malformed);
+
+		rate[b] = (double)wire.len * rounds / sec;
+		printf("\n\t%s, %4zu-byte reads: %6.1f MiB/s on the wire, "
+				"%7.0f packets/s", name, blocks[b],
+				rate[b] / (1024.0 * 1024.0),
+				rx.nr_packets / sec);
+	}
+	printf("\n");
+
+	CHECK(rate[3] > rate[0]);
+}
+
+TEST(SmpSerial, feed_Benchmark_ConsoleUpload) {
+	bench_feed(SMP_SERIAL_FRAMING_CONSOLE, "console");
+}
+
+TEST(SmpSerial, feed_Benchmark_CobsUpload) {
+	bench_feed(SMP_SERIAL_FRAMING_COBS, "cobs");
+}
+
+/* Per-packet decode cost as packets grow to the largest the transport
+ * takes. Decoding the whole frame again at each line end grows with the
+ * square of the packet; decoding each quantum once grows with it. */
+TEST(SmpSerial, feed_Benchmark_IncrementalAgainstWholeFrameDecode) {
+	static struct whole_frame ref;
+	static const size_t sizes[] = {
+		128U, 512U, SMP_SERIAL_PKT_MAX - 8U,
+	};
+	const uint32_t count = 64U;
+	const uint32_t rounds = 16U;
+	double ns_new = 0;
+	double ns_old = 0;
+
+	for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+		record_session(SMP_SERIAL_FRAMING_CONSOLE, sizes[k], count);
+
+		rx.nr_packets = 0;
+		uint64_t t0 = now_ns();
+		for (uint32_t r = 0; r < rounds; r++) {
+			smp_serial_feed(&rx_side, wire.buf, wire.len);
+		}
+		ns_new = (double)(now_ns() - t0) / (count * rounds);
+		LONGS_EQUAL(count * rounds, rx.nr_packets);
+
+		ref.nr_packets = 0;
+		t0 = now_ns();
+		for (uint32_t r = 0; r < rounds; r++) {
+			whole_frame_feed(&ref, wire.buf, wire.len);
+		}
+		ns_old = (double)(now_ns() - t0) / (count * rounds);
+		LONGS_EQUAL(count * rounds, ref.nr_packets);
+
+		printf("\n\t%4zu-byte packets: %7.0f ns incremental, "
+				"%7.0f ns whole frame, %.1fx", sizes[k] + 8U,
+				ns_new, ns_old, ns_old / ns_new);
+	}
+	printf("\n");
+
+	CHECK(ns_new < ns_old);
+}
@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2026 권경환 Kyunghwan Kwon <k@libmcu.org>
+#
+# SPDX-License-Identifier: MIT
+
+"""Rebuild dictionary log records into text using the firmware ELF.
+
+Usage: log_dict_decode.py build/madi.elf [capture.bin | -]
+
+Bytes that are not part of a dictionary frame (plain text lines such as the
+repeat notes of the suppressor) are passed through unchanged. A frame runs
+from the sync byte to the end of its line; the sync byte never appears
+inside one, so a frame cut short by lost bytes is dropped at the next sync
+byte and decoding resumes there.
+"""
+
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+ESC = 0xA6
+REPLAYED = 0x80
+HDR_SIZE = 11
+FRAME_MAXLEN = 1 + 128 * 2
+LEVELS = ("DEBUG", "INFO", "WARN", "ERROR")
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+SPEC = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?"
+                  r"(hh|h|ll|l|z|j|t|L)?([diuoxXcfFeEgGaAspn%])")
+
+
+class Elf:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError(f"{path}: not an ELF file")
+        self.is64 = self.data[4] == 2
+        self.endian = "<" if self.data[5] == 1 else ">"
+        self.sections = list(self._alloc_sections())
+
+    def _alloc_sections(self):
+        if self.is64:
+            shoff, = struct.unpack_from(self.endian + "Q", self.data, 0x28)
+            shentsize, shnum = struct.unpack_from(self.endian + "HH",
+                                                  self.data, 0x3A)
+            fmt = "IIQQQQ"
+        else:
+            shoff, = struct.unpack_from(self.endian + "I", self.data, 0x20)
+            shentsize, shnum = struct.unpack_from(self.endian + "HH",
+                                                  self.data, 0x2E)
+            fmt = "IIIIII"
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from(
+                self.endian + fmt, self.data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size:
+                yield addr, offset, size
+
+    def string_at(self, addr):
+        for base, offset, size in self.sections:
+            if base <= addr < base + size:
+                start = offset + addr - base
+                end = self.data.index(b"\0", start, offset + size)
+                return self.data[start:end].decode(errors="replace")
+        return None
+
+
+class Args:
+    def __init__(self, payload, is64):
+        self.payload = payload
+        self.pos = 0
+        self.ptr = 8 if is64 else 4
+
+    def int(self, width, signed=False):
+        raw = self.payload[self.pos:self.pos + width]
+        self.pos += width
+        return int.from_bytes(raw, "little", signed=signed)
+
+    def double(self):
+        value, = struct.unpack_from("<d", self.payload, self.pos)
+        self.pos += 8
+        return value
+
+    def string(self):
+        n = self.payload[self.pos]
+        s = self.payload[self.pos + 1:self.pos + 1 + n]
+        self.pos += 1 + n
+        return s.decode(errors="replace")
+
+    def width_of(self, length):
+        return {
+            "l": self.ptr, "ll": 8, "z": self.ptr, "j": 8, "t": self.ptr,
+        }.get(length, 4)
+
+
+def render(fmt, args):
+    def conversion(m):
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        if width == "*":
+            width = str(args.int(4, signed=True))
+        if prec == "*":
+            prec = str(args.int(4, signed=True))
+        spec = "%" + flags + (width or "") + ("." + prec if prec else "")
+        if conv in "di":
+            return (spec + "d") % args.int(args.width_of(length), True)
+        if conv in "uoxX":
+            conv = "d" if conv == "u" else conv
+            return (spec + conv) % args.int(args.width_of(length))
+        if conv == "c":
+            return (spec + "c") % chr(args.int(4) & 0xFF)
+        if conv in "fFeEgG":
+            return (spec + conv.replace("F", "f")) % args.double()
+        if conv in "aA":
+            return args.double().hex()
+        if conv == "s":
+            return (spec + "s") % args.string()
+        if conv == "p":
+            return "0x%x" % args.int(args.ptr)
+        return ""
+
+    return SPEC.sub(conversion, fmt)
+
+
+def unescape(frame):
+    record = bytearray()
+    it = iter(frame)
+    for c in it:
+        if c == ESC:
+            c = next(it, None)
+            if c is None or c ^ 0x20 not in (SYNC, ESC, 0x0A):
+                return None
+            c ^= 0x20
+        record.append(c)
+    return bytes(record)
+
+
+def render_record(elf, record):
+    if record is None or len(record) < HDR_SIZE:
+        return "<malformed frame>\n"
+    level, length, ts, addr = struct.unpack_from("<BHII", record, 0)
+    if len(record) != HDR_SIZE + length:
+        return "<malformed frame>\n"
+    tag = "<retained> " if level & REPLAYED else ""
+    level &= ~REPLAYED
+    fmt = elf.string_at(addr)
+    if fmt is None:
+        return f"{tag}{ts}: [?] <unknown format 0x{addr:08x}>\n"
+    name = LEVELS[level] if level < len(LEVELS) else str(level)
+    try:
+        text = render(fmt, Args(record[HDR_SIZE:], elf.is64))
+    except (IndexError, struct.error, ValueError):
+        text = f"<malformed record for \"{fmt}\">"
+    return f"{tag}{ts}: [{name}] {text}\n"
+
+
+def decode(elf, stream, out):
+    buf = bytearray()
+    while True:
+        chunk = stream.read(4096)
+        if not chunk:
+            break
+        buf += chunk
+        while buf:
+            if buf[0] != SYNC:
+                end = buf.find(SYNC)
+                end = len(buf) if end < 0 else end
+                out.write(buf[:end].decode(errors="replace"))
+                del buf[:end]
+                continue
+            end = buf.find(b"\n")
+            resync = buf.find(SYNC, 1, end if end >= 0 else len(buf))
+            if resync > 0:
+                out.write("<truncated frame>\n")
+                del buf[:resync]
+                continue
+            if end < 0:
+                if len(buf) > FRAME_MAXLEN:
+                    out.write("<truncated frame>\n")
+                    del buf[:1]
+                break
+            frame = bytes(buf[1:end])
+            del buf[:end + 1]
+            out.write(render_record(elf, unescape(frame)))
+        out.flush()
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    elf = Elf(sys.argv[1])
+    path = sys.argv[2] if len(sys.argv) > 2 else "-"
+    if path == "-":
+        decode(elf, sys.stdin.buffer, sys.stdout)
+    else:
+        with open(path, "rb") as f:
+            decode(elf, f, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()